@@ -0,0 +1,296 @@
+/**************************************************************************
+ *  ALIGN.C
+ *
+ * Signals and their alignment with video. The following functions are
+ * public:
+ *
+ *   sig_create     -   Creates an empty signal
+ *   sig_free       -   Releases a signal
+ *   aln_read       -   Reads samples from a text file onto a signal
+ *   aln_onset      -   Time a channel first reaches a level
+ *   aln_resample   -   Puts a signal onto another timebase
+ *
+ * Resampling works out where each output sample falls (and for sinc,
+ * its weights) once; every channel then goes through the same plain
+ * loop of multiply-adds down contiguous columns.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "align.h"
+
+#define PI  3.14159265358979
+
+/* Prototypes for internal functions */
+static void  *aln_alloc( long n, size_t size );
+static void   sig_reserve( SIGNAL *s, long samples );
+static double aln_lanczos( double x );
+static void   aln_linear( SIGNAL *s, SIGNAL *out, const double *pos );
+static void   aln_sinc( SIGNAL *s, SIGNAL *out, const double *pos );
+
+
+/* aln_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *aln_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  aln_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* sig_reserve - Makes room for at least "samples" samples per channel.
+ */
+static void sig_reserve( SIGNAL *s, long samples )
+{
+    double *data;
+    long cap;
+    int c;
+
+    if( samples <= s->capacity )
+       return;
+    cap = (s->capacity > 0) ? s->capacity * 2 : 64;
+    if( cap < samples )
+       cap = samples;
+    data = (double *) aln_alloc( s->numchan * cap, sizeof(double) );
+    for( c = 0; c < s->numchan; c++ )
+       if( s->numsamples > 0 )
+          memcpy( data + c * cap, SIG_COL( s, c ),
+                  (size_t) s->numsamples * sizeof(double) );
+    free( s->data );
+    s->data = data;
+    s->capacity = cap;
+}
+
+
+/* sig_create - Creates an empty signal of "numchan" channels sampled
+ * "rate" times a second from time "start", with room for "hint"
+ * samples.
+ *
+ * Return: The signal
+ */
+SIGNAL *sig_create( int numchan, long hint, double rate, double start )
+{
+    SIGNAL *s;
+
+    s = (SIGNAL *) aln_alloc( 1L, sizeof(SIGNAL) );
+    s->numchan = numchan;
+    s->numsamples = 0;
+    s->capacity = 0;
+    s->rate = rate;
+    s->start = start;
+    s->data = NULL;
+    sig_reserve( s, (hint > 0) ? hint : 1 );
+    return s;
+}
+
+
+/* sig_free - Releases a signal.
+ */
+void sig_free( SIGNAL *s )
+{
+    if( s == NULL )
+       return;
+    free( s->data );
+    free( s );
+}
+
+
+/* aln_read - Appends samples of s->numchan values each, read from
+ * "ts", until the file ends.  A short last sample is dropped.
+ *
+ * Return: The number of samples read
+ */
+long aln_read( SIGNAL *s, TXTSCAN *ts )
+{
+    double *rec;
+    long count = 0;
+    int c;
+
+    rec = (double *) aln_alloc( (long) s->numchan, sizeof(double) );
+    while( txt_doubles( ts, rec, (long) s->numchan ) == s->numchan )
+      {
+        sig_reserve( s, s->numsamples + 1 );
+        for( c = 0; c < s->numchan; c++ )
+           SIG_COL( s, c )[s->numsamples] = rec[c];
+        s->numsamples++;
+        count++;
+      }
+    free( rec );
+    return count;
+}
+
+
+/* aln_onset - Finds when channel "chan" first reaches "level" in size,
+ * to a fraction of a sample by a straight line from the sample before.
+ *
+ * Return: The time in seconds, or -1 if it never does
+ */
+double aln_onset( SIGNAL *s, int chan, double level )
+{
+    double *x, a, b;
+    long n;
+
+    x = SIG_COL( s, chan );
+    for( n = 0; n < s->numsamples; n++ )
+       if( fabs( x[n] ) >= level )
+         {
+           if( n == 0 )
+              return s->start;
+           a = fabs( x[n - 1] );
+           b = fabs( x[n] );
+           return s->start + (n - 1 + (level - a) / (b - a)) / s->rate;
+         }
+    return -1.0;
+}
+
+
+/* aln_lanczos - The Lanczos kernel, sinc( x ) sinc( x / ALN_LOBES ).
+ */
+static double aln_lanczos( double x )
+{
+    if( x == 0.0 )
+       return 1.0;
+    if( fabs( x ) >= ALN_LOBES )
+       return 0.0;
+    return ALN_LOBES * sin( PI * x ) * sin( PI * x / ALN_LOBES )
+           / (PI * PI * x * x);
+}
+
+
+/* aln_linear - Linear interpolation of every channel of "s" at the
+ * sample positions "pos" (already inside the signal).
+ */
+static void aln_linear( SIGNAL *s, SIGNAL *out, const double *pos )
+{
+    long *at, k, last;
+    double *frac, *x, *y;
+    int c;
+
+    at = (long *) aln_alloc( out->numsamples, sizeof(long) );
+    frac = (double *) aln_alloc( out->numsamples, sizeof(double) );
+    last = (s->numsamples > 1) ? s->numsamples - 2 : 0;
+    for( k = 0; k < out->numsamples; k++ )
+      {
+        at[k] = (long) pos[k];
+        if( at[k] > last )
+           at[k] = last;
+        frac[k] = (s->numsamples > 1) ? pos[k] - at[k] : 0.0;
+      }
+    for( c = 0; c < s->numchan; c++ )
+      {
+        x = SIG_COL( s, c );
+        y = SIG_COL( out, c );
+        if( s->numsamples == 1 )
+           for( k = 0; k < out->numsamples; k++ )
+              y[k] = x[0];
+        else
+           for( k = 0; k < out->numsamples; k++ )
+              y[k] = x[at[k]] + frac[k] * (x[at[k] + 1] - x[at[k]]);
+      }
+    free( at );
+    free( frac );
+}
+
+
+/* aln_sinc - Windowed sinc interpolation of every channel of "s" at
+ * the sample positions "pos" (already inside the signal).  When the
+ * output is sampled more slowly than the input the kernel is widened
+ * by the rate ratio, so it also low-pass filters below the new
+ * Nyquist frequency and nothing aliases.
+ */
+static void aln_sinc( SIGNAL *s, SIGNAL *out, const double *pos )
+{
+    long *at, k, m, half, width, n;
+    double *w, *pad, *x, *y, scale, sum;
+    int c;
+
+    scale = (out->rate < s->rate) ? out->rate / s->rate : 1.0;
+    half = (long) ceil( ALN_LOBES / scale );
+    width = 2 * half;
+    at = (long *) aln_alloc( out->numsamples, sizeof(long) );
+    w = (double *) aln_alloc( out->numsamples * width, sizeof(double) );
+    for( k = 0; k < out->numsamples; k++ )
+      {
+        at[k] = (long) floor( pos[k] ) - half + 1;
+        for( sum = 0.0, m = 0; m < width; m++ )
+          {
+            w[k * width + m] = aln_lanczos( (pos[k] - (at[k] + m)) * scale );
+            sum += w[k * width + m];
+          }
+        for( m = 0; m < width; m++ )
+           w[k * width + m] /= sum;
+      }
+
+    /* Each column is copied with its end samples repeated "half" times
+       either side, so no tap falls off the end */
+    n = s->numsamples;
+    pad = (double *) aln_alloc( n + 2 * half, sizeof(double) );
+    for( c = 0; c < s->numchan; c++ )
+      {
+        x = SIG_COL( s, c );
+        y = SIG_COL( out, c );
+        for( m = 0; m < half; m++ )
+          {
+            pad[m] = x[0];
+            pad[half + n + m] = x[n - 1];
+          }
+        memcpy( pad + half, x, (size_t) n * sizeof(double) );
+        for( k = 0; k < out->numsamples; k++ )
+          {
+            for( sum = 0.0, m = 0; m < width; m++ )
+               sum += w[k * width + m] * pad[half + at[k] + m];
+            y[k] = sum;
+          }
+      }
+    free( pad );
+    free( w );
+    free( at );
+}
+
+
+/* aln_resample - Samples every channel of "s" "count" times at "rate"
+ * a second from video time "start", where video time zero is signal
+ * time "offset", by ALN_LINEAR or ALN_SINC interpolation.
+ *
+ * Return: The new signal, stamped with "rate" and "start"
+ */
+SIGNAL *aln_resample( SIGNAL *s, double rate, double start, long count,
+                      double offset, int method )
+{
+    SIGNAL *out;
+    double *pos, last;
+    long k;
+    int c;
+
+    out = sig_create( s->numchan, count, rate, start );
+    out->numsamples = count;
+    if( s->numsamples == 0 )
+      {
+        for( c = 0; c < out->numchan; c++ )
+           memset( SIG_COL( out, c ), 0, (size_t) count * sizeof(double) );
+        return out;
+      }
+
+    pos = (double *) aln_alloc( count, sizeof(double) );
+    last = (double) (s->numsamples - 1);
+    for( k = 0; k < count; k++ )        /* where each falls in "s" */
+      {
+        pos[k] = (start + k / rate + offset - s->start) * s->rate;
+        pos[k] = (pos[k] < 0.0) ? 0.0 : (pos[k] > last) ? last : pos[k];
+      }
+    if( method == ALN_SINC )
+       aln_sinc( s, out, pos );
+    else
+       aln_linear( s, out, pos );
+    free( pos );
+    return out;
+}
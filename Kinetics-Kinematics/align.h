@@ -0,0 +1,49 @@
+/* ALIGN.H
+ *
+ * Time alignment of sampled signals (force plate channels) with the
+ * video fields.  A SIGNAL holds evenly spaced samples of one or more
+ * channels, one column per channel, stamped with its sample rate and
+ * the time of its first sample.  aln_resample() puts a signal onto any
+ * other timebase, at any rate ratio, by linear or windowed sinc
+ * (Lanczos) interpolation.
+ *
+ * The two streams' clocks may be out of step: "offset" is the signal
+ * time at video time zero.  It is usually found from a sync event
+ * seen in both, e.g. first contact with the plate:
+ *
+ *      offset = aln_onset( force, chan, level ) - record / recrate
+ *
+ * Outside the signal the first or last sample is held.
+ */
+
+/* Include only once */
+#ifndef ALIGN_H
+#define ALIGN_H
+
+#include "txtscan.h"
+
+#define ALN_LINEAR   0          /* Straight line between samples        */
+#define ALN_SINC     1          /* Lanczos windowed sinc                */
+#define ALN_LOBES    4          /* Sinc lobes each side of the centre   */
+
+typedef struct _SIGNAL
+{
+    int     numchan;            /* Channels (columns)                   */
+    long    numsamples;         /* Samples currently held               */
+    long    capacity;           /* Samples allocated in each column     */
+    double  rate;               /* Samples per second                   */
+    double  start;              /* Time of sample 0, seconds            */
+    double *data;               /* numchan columns of capacity          */
+} SIGNAL;
+
+#define SIG_COL( s, c )  ((s)->data + (long) (c) * (s)->capacity)
+
+/* Public alignment functions */
+SIGNAL *sig_create( int numchan, long hint, double rate, double start );
+void    sig_free( SIGNAL *s );
+long    aln_read( SIGNAL *s, TXTSCAN *ts );
+double  aln_onset( SIGNAL *s, int chan, double level );
+SIGNAL *aln_resample( SIGNAL *s, double rate, double start, long count,
+                      double offset, int method );
+
+#endif /* ALIGN_H */
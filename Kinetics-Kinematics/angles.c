@@ -0,0 +1,195 @@
+/**************************************************************************
+ *  ANGLES.C
+ *
+ * Segment and joint angles. The following functions are public:
+ *
+ *   ang_compute    -   Computes a set of angles over every field
+ *   ang_unwrap     -   Removes the 2 PI jumps from one angle column
+ *   ang_free       -   Releases a set of angles
+ *
+ * The column loops have no branches: hidden points hold zero, so
+ * atan2 of them is harmless and the mask (the AND of the joints'
+ * masks, a byte at a time) says which results stand.  Each angle is a
+ * task for the worker pool (worker.c).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "angles.h"
+#include "worker.h"
+
+#define PI  3.14159265358979
+
+/* Shared arguments of the per angle tasks */
+typedef struct _ANGJOB
+{
+    TRAJECT       *t;
+    const ANGSPEC *spec;
+    ANGLES        *g;
+    int            unwrap;
+} ANGJOB;
+
+/* Prototypes for internal functions */
+static void *ang_alloc( long n, size_t size );
+static void  ang_task( void *arg, long i );
+
+
+/* ang_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *ang_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  ang_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* ang_task - Task: angle "i" of the job over every field.
+ */
+static void ang_task( void *arg, long i )
+{
+    ANGJOB *job = (ANGJOB *) arg;
+    TRAJECT *t = job->t;
+    const ANGSPEC *s = job->spec + i;
+    double *out, *xa, *ya, *xb, *yb, *xc, *yc, *xd, *yd, ux, uy, vx, vy;
+    unsigned char *m, *ma, *mb, *mc, *md;
+    long n, k, bytes;
+
+    out = ANG_COL( job->g, i );
+    m = ANG_MASK( job->g, i );
+    bytes = (t->numframes + 7) >> 3;
+    xa = TRAJ_X( t, s->a );
+    ya = TRAJ_Y( t, s->a );
+    xb = TRAJ_X( t, s->b );
+    yb = TRAJ_Y( t, s->b );
+    ma = TRAJ_MASK( t, s->a );
+    mb = TRAJ_MASK( t, s->b );
+
+    if( s->kind == ANG_JOINT )
+      {
+        xc = TRAJ_X( t, s->c );
+        yc = TRAJ_Y( t, s->c );
+        xd = TRAJ_X( t, s->d );
+        yd = TRAJ_Y( t, s->d );
+        mc = TRAJ_MASK( t, s->c );
+        md = TRAJ_MASK( t, s->d );
+        for( n = 0; n < t->numframes; n++ )
+          {
+            ux = xb[n] - xa[n];
+            uy = yb[n] - ya[n];
+            vx = xd[n] - xc[n];
+            vy = yd[n] - yc[n];
+            out[n] = atan2( ux * vy - uy * vx, ux * vx + uy * vy );
+          }
+        for( k = 0; k < bytes; k++ )
+           m[k] = (unsigned char) (ma[k] & mb[k] & mc[k] & md[k]);
+      }
+    else
+      {
+        for( n = 0; n < t->numframes; n++ )
+           out[n] = atan2( yb[n] - ya[n], xb[n] - xa[n] );
+        for( k = 0; k < bytes; k++ )
+           m[k] = (unsigned char) (ma[k] & mb[k]);
+      }
+
+    for( n = 0; n < t->numframes; n++ )         /* zero the invalid */
+       out[n] *= (double) ((m[n >> 3] >> (n & 7)) & 1);
+    if( job->unwrap )
+       ang_unwrap( out, m, t->numframes );
+}
+
+
+/* ang_compute - Computes the "numangles" angles described by "spec"
+ * for every field of "t", unwrapped if "unwrap" is set, using up to
+ * "nthreads" threads (0 = one per processor).
+ *
+ * Return: The angles, or NULL if a spec names a joint "t" doesn't have
+ */
+ANGLES *ang_compute( TRAJECT *t, const ANGSPEC *spec, int numangles,
+                     int unwrap, int nthreads )
+{
+    ANGLES *g;
+    ANGJOB job;
+    int i, top;
+
+    for( i = 0; i < numangles; i++ )
+      {
+        top = spec[i].a > spec[i].b ? spec[i].a : spec[i].b;
+        if( spec[i].kind == ANG_JOINT )
+          {
+            if( spec[i].c > top )
+               top = spec[i].c;
+            if( spec[i].d > top )
+               top = spec[i].d;
+            if( spec[i].c < 0 || spec[i].d < 0 )
+               return NULL;
+          }
+        if( spec[i].a < 0 || spec[i].b < 0 || top >= t->numjoints )
+           return NULL;
+      }
+
+    g = (ANGLES *) ang_alloc( 1L, sizeof(ANGLES) );
+    g->numangles = numangles;
+    g->numframes = t->numframes;
+    g->capacity = t->capacity;
+    g->base = (double *) ang_alloc( numangles * g->capacity, sizeof(double) );
+    g->valid = (unsigned char *) ang_alloc( numangles * (g->capacity >> 3),
+                                            1 );
+    memset( g->valid, 0, (size_t) (numangles * (g->capacity >> 3)) );
+
+    job.t = t;
+    job.spec = spec;
+    job.g = g;
+    job.unwrap = unwrap;
+    work_run( (long) numangles, ang_task, &job, nthreads );
+    return g;
+}
+
+
+/* ang_unwrap - Adds whole turns to the "len" angles of "a" whose bits
+ * are set in "mask" so that each differs from the last valid one by
+ * no more than PI.  The first valid angle is left as it is.
+ */
+void ang_unwrap( double *a, const unsigned char *mask, long len )
+{
+    double last, turns, w;
+    long n;
+    int seen = 0;
+
+    last = 0.0;
+    turns = 0.0;
+    for( n = 0; n < len; n++ )
+      {
+        if( !((mask[n >> 3] >> (n & 7)) & 1) )
+           continue;
+        a[n] += turns;
+        if( seen )
+          {
+            w = 2.0 * PI * floor( (a[n] - last + PI) / (2.0 * PI) );
+            a[n] -= w;
+            turns -= w;
+          }
+        last = a[n];
+        seen = 1;
+      }
+}
+
+
+/* ang_free - Releases a set of angles.
+ */
+void ang_free( ANGLES *g )
+{
+    if( g == NULL )
+       return;
+    free( g->base );
+    free( g->valid );
+    free( g );
+}
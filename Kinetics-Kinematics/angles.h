@@ -0,0 +1,55 @@
+/* ANGLES.H
+ *
+ * Segment and joint angles over whole trajectories.  A segment runs
+ * from one joint to another; its absolute angle is measured counter
+ * clockwise from the +x axis.  A joint angle is the counter clockwise
+ * turn from one segment to a second, taken as atan2 of their cross
+ * and dot products, so no quadrant tests are needed for either.
+ *
+ * Angles are in radians, one column per angle, with a validity mask
+ * laid out as in TRAJECT: an angle is valid in a field only when every
+ * joint it uses was visible.  Invalid fields hold zero.
+ *
+ * atan2 only returns -PI to PI.  With unwrapping asked for, each
+ * column has whole turns added where needed so that no step between
+ * one valid field and the next is bigger than PI, and an angle
+ * swinging through PI runs on smoothly instead of jumping by 2 PI.
+ */
+
+/* Include only once */
+#ifndef ANGLES_H
+#define ANGLES_H
+
+#include "traject.h"
+
+#define ANG_SEGMENT  0          /* Segment a->b against the +x axis     */
+#define ANG_JOINT    1          /* From segment a->b to segment c->d    */
+
+/* One angle to compute */
+typedef struct _ANGSPEC
+{
+    int     kind;               /* ANG_SEGMENT or ANG_JOINT             */
+    int     a, b;               /* First segment, from joint a to b     */
+    int     c, d;               /* Second segment, ANG_JOINT only       */
+} ANGSPEC;
+
+typedef struct _ANGLES
+{
+    int     numangles;
+    long    numframes;
+    long    capacity;           /* Fields in each column, as the TRAJECT */
+    double *base;               /* numangles columns                    */
+    unsigned char *valid;       /* capacity / 8 mask bytes per angle    */
+} ANGLES;
+
+#define ANG_COL( g, i )   ((g)->base + (long) (i) * (g)->capacity)
+#define ANG_MASK( g, i )  ((g)->valid + (long) (i) * ((g)->capacity >> 3))
+#define ANG_OK( g, i, n ) ((ANG_MASK( g, i )[(n) >> 3] >> ((n) & 7)) & 1)
+
+/* Public angle functions */
+ANGLES *ang_compute( TRAJECT *t, const ANGSPEC *spec, int numangles,
+                     int unwrap, int nthreads );
+void    ang_unwrap( double *a, const unsigned char *mask, long len );
+void    ang_free( ANGLES *g );
+
+#endif /* ANGLES_H */
@@ -6,6 +6,18 @@
    ** Should error check:
       USE:   ( distance2 = xdist^2 * ydist^2 )
              ( error     = distance2 - distance )
+
+   The records asked for are read into a columnar trajectory store
+   (traject.c in ..\VideoCapture) before any calculation.  When the
+   digitizer left a binary "*.TRJ" next to the "*.DAT" it is mapped
+   and just those records are taken from it, with no parsing;
+   otherwise the text is read with the buffered scanner (txtscan.c).  The ankle is placed in
+   every record at once as a virtual marker (vmarker.c).  Compile with:
+
+         cl /AL /I..\VideoCapture ankle.c vmarker.c
+            ..\VideoCapture\traject.c ..\VideoCapture\trjfile.c
+            ..\VideoCapture\filemap.c ..\VideoCapture\txtscan.c
+            ..\VideoCapture\worker.c
 */
 
 #include <stdio.h>
@@ -15,6 +27,10 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <alloc.h>
+#include "traject.h"
+#include "trjfile.h"
+#include "txtscan.h"
+#include "vmarker.h"
 
 #define PI    3.1415927
 
@@ -27,64 +43,31 @@ void all_done( void );
 
 int n, numframes, end;
 char datafile[8];
-double deg_alpha, distance, anklex, ankley;
-
-struct jttype
-{
-   double x, y;
-};
+double deg_alpha, distance;
 
-typedef struct frametype
-{
-   struct jttype joint[5];
-} FRAMETYPE;
-
-typedef struct frametype FRAME;
-
-FRAME *f;
+TRAJECT *t;
+TRJMAP trjmap;          /* the .TRJ, if it was found */
+TXTSCAN *ts;
+TRAJECT *ankle;         /* the ankle, in pixels, every record */
 
 FILE *fpSESS, *fpNEW;
 
 main()
 {
    open_files();
+   input_data();
+   convert();
+   calculate();
    for( n = 0; n < end; n++)
-    {
-      input_data();
-      convert();
-      calculate();
       save_data();
-    }
    all_done();
 }
 
 
-FRAME *create_frame( void )
-{
-   int i;
-   FRAME *f;
-
-   f = (FRAME *) malloc( sizeof(FRAME) );
-   if( f == NULL )
-     {
-       printf( "Error:  create_frame()  malloc failed.\n" );
-       exit( 1 );
-     }
-   else
-     {
-       for( i = 0; i < 5; i++)
-         {
-            f->joint[i].x = 0;
-            f->joint[i].y = 0;
-          }
-     }
-   return f;
-}
-
-
 void open_files( void )
 {
    int i, length, fin;
+   long njts;
    char sessfile[28], newdatafile[28];
 
    printf("Enter the name of the datafile (no extension): ");
@@ -92,11 +75,18 @@ void open_files( void )
    length = strlen( datafile );
    strcpy (sessfile, "F:\\FP_DIG.DAT\\");
    strncat (sessfile, datafile, length + 1 );
-   strcat (sessfile, ".DAT");
-   if ((fpSESS = fopen( sessfile, "r")) == NULL )
-      printf("\nDatafile not found.");
-   f = create_frame();
-   fscanf( fpSESS, "%d\n", &numframes);
+   strcat (sessfile, ".TRJ");
+   if ( trj_map( &trjmap, sessfile ) == 0 )
+      numframes = (int) trjmap.head->numjoints;
+   else
+     {
+      strcpy (sessfile + strlen( sessfile ) - 4, ".DAT");
+      if ((fpSESS = fopen( sessfile, "r")) == NULL )
+         printf("\nDatafile not found.");
+      ts = txt_open( fpSESS );
+      if ( txt_long( ts, &njts ) )
+         numframes = (int) njts;
+     }
    strcpy ( newdatafile, "F:\\FP_DIG.DAT\\");
    strncat ( newdatafile, datafile, length + 1 );
    strcat ( newdatafile, ".DTA");
@@ -121,18 +111,23 @@ void open_files( void )
 
 void input_data( void )
 {
-   int i = 0;
-   fscanf( fpSESS, "\n%lf%lf", &f->joint[i].x, &f->joint[i].y);
-   for ( i = 1; i < numframes; i++ )
-      {
-      if ( (i % 4) == 0)
-         fscanf( fpSESS, "\n%lf%lf", &f->joint[i].x, &f->joint[i].y);
-      else
-         fscanf( fpSESS, "%lf%lf", &f->joint[i].x, &f->joint[i].y);
-      }
+                /* Reading the records into the trajectory store. */
+   t = traj_create( numframes, end );
+   if ( trjmap.head != NULL )
+     {
+      trj_read( &trjmap, t, 0L, (long) end );  /* Binary: no parsing */
+      trj_unmap( &trjmap );
+     }
+   else
+      txt_traject( ts, t, (long) end, TXT_DAT );
+   if ( t->numframes < end )
+     {
+      printf( "\nOnly %ld records in datafile.", t->numframes );
+      end = (int) t->numframes;
+     }
 /*   printf( "\n" );
-   for ( i = 0; i < numframes; i++)
-      printf( "%5.3lf %6.3lf  ", f->joint[i].x, f->joint[i].y );
+   for ( i = 0; i < numframes; i++ )
+      printf( "%5.3lf %6.3lf  ", TRAJ_X( t, i )[0], TRAJ_Y( t, i )[0] );
    printf( "\n" ); */
 }
 
@@ -140,110 +135,58 @@ void input_data( void )
 void convert( void )
 {
    int i;
-   double cfactor = 0.00318;
+   long k;
+   double *x, *y, scale, cfactor = 0.00318;
+
+/* Loop will convert from real world to pixel (640*480) coord's
+   and move origin from upper left to lower left, one joint
+   column at a time over every record.  Text datafiles hold real
+   world values (t->cfactor = 1); a .TRJ holds digitizer pixels
+   and the digitizer's own conversion factor. */
 
-/* Loop will convert from real world to pixel (640*480) coord's. */
+   scale = ( t->cfactor / cfactor );
 
    for ( i = 0; i < numframes; i++ )
      {
-       f->joint[i].x = floor(( f->joint[i].x / cfactor) + 0.5);
-       f->joint[i].y = floor(( f->joint[i].y / cfactor) + 0.5);
+       x = TRAJ_X( t, i );
+       y = TRAJ_Y( t, i );
+       for ( k = 0; k < t->numframes; k++ )
+         {
+           x[k] = floor(( x[k] * scale) + 0.5);
+           y[k] = ( 480 - floor(( y[k] * scale) + 0.5));
+         }
      }
-
-/* Loop will move origin from upper left to lower left. */
-
-   for ( i = 0; i < numframes; i++)
-      f->joint[i].y = ( 480 - f->joint[i].y );
 }
 
 
 void calculate( void)
 {
-   int temp;
-   double x, y, xdist, ydist, pi, deg_gamma,
-             rad_gamma, rad_alpha, rad_beta, deg_beta;
-
-   anklex = ankley = xdist = ydist = 0.0;
-
-
-/* Finding the change in x and y */
-
-   x = ( f->joint[0].x - f->joint[1].x );
-   y = ( f->joint[0].y - f->joint[1].y );
+   VMARKER vm;
+   double rad_alpha;
 
 /* Converting (from degrees to radians) the orientation
                        of the ankle with respect to the fin */
    rad_alpha = (( deg_alpha / 180.0 ) * PI );
 
-/* Finding the orientation of the fin */
-
-   if ( x == 0.0 )
-      rad_beta = ( PI / 2 );
-   else
-      rad_beta = atan2 ( y, x );
-
-/* Finding the absolute orientation of the ankle */
-
-   if ( x == 0.0 )     /* Fin is perpendicular */
+/* The ankle is a virtual marker in the fin's frame: origin at fin
+   point 0, x axis pointing from fin point 1 to fin point 0, and the
+   ankle "distance" out, turned "alpha" clockwise from that axis.
+   Every record is placed in one pass, whatever way the fin points,
+   and a hidden fin point leaves the ankle hidden. */
+
+   vm.nreal = 2;
+   vm.real[0] = 0;
+   vm.rx[0] = vm.ry[0] = 0.0;
+   vm.real[1] = 1;
+   vm.rx[1] = -1.0;
+   vm.ry[1] = 0.0;
+   vm.vx = distance * cos( rad_alpha );
+   vm.vy = -distance * sin( rad_alpha );
+   if (( ankle = vm_build( t, &vm, 1, 0 )) == NULL )
      {
-      rad_gamma = ( rad_beta - rad_alpha );
-      xdist = floor(( distance * cos( rad_gamma )) + 0.5 );
-      ydist = floor(( distance * sin( rad_gamma )) + 0.5 );
-      anklex = ( f->joint[0].x + xdist );
-      ankley = ( f->joint[0].y + ydist );
-     }
-   else if (( x > 0 ) && ( y < 0 ))       /* Quadrant 2 */
-     {
-      rad_gamma = rad_alpha - rad_beta;
-      xdist = floor(( distance * cos( rad_gamma )) + 0.5 );
-      ydist = floor(( distance * sin( rad_gamma )) + 0.5 );
-      anklex = ( f->joint[0].x + xdist );
-      ankley = ( f->joint[0].y - ydist );
-     }
-   else if (( x > 0 ) && ( y > 0 ))  /* Quadrant 3 */
-     {
-      rad_gamma = rad_beta - rad_alpha;
-      if ( rad_gamma == 0 )
-        {
-         xdist = floor(( distance * cos( rad_alpha)) + 0.5 );
-         anklex = ( f->joint[0].x + xdist );
-         ankley = ( f->joint[0].y );
-        }
-      else
-        {
-         xdist = floor(( distance * cos( rad_gamma )) + 0.5 );
-         ydist = ( distance * sin( rad_gamma ));
-         anklex = ( f->joint[0].x + xdist );
-         ankley = floor(( f->joint[0].y + ydist ) + 0.5);
-        }
-     }
-   else if (( x < 0 ) && ( y > 0 ))  /* Quadrant 4 */
-     {
-      rad_gamma = ( PI + rad_beta - rad_alpha );
-      xdist = floor(( distance * cos( rad_gamma )) + 0.5 );
-      ydist = floor(( distance * sin( rad_gamma )) + 0.5 );
-      anklex = ( f->joint[0].x - xdist );
-      ankley = ( f->joint[0].y - ydist );
-     }
-   else if (( x < 0) && ( y < 0 ))  /* Quadrant 1 */
-     {
-      printf( "\n\nERROR IN FIN ORIENTATION !! (Line = %d)\n\n", n);
-      getchar();
+      printf("\nThe datafile needs fin points 0 and 1.");
       exit( 1 );
      }
-/*
-   deg_beta = ( rad_beta * 180 / PI );
-   deg_gamma = ( rad_gamma / PI * 180 );
-   printf("\nx & y = %7.1lf, %7.1lf", x, y);
-   printf("\nAlpha = %6.4lf radians, or %5.2lf degrees.",
-                                       rad_alpha, deg_alpha);
-   printf("\nBeta = %6.4lf radians, or %5.2lf degrees.",
-                                       rad_beta, deg_beta);
-   printf( "\nGamma = %6.4lf radians, or %5.2lf degrees.",
-                                   rad_gamma, deg_gamma );
-   printf("\nxdist = %lf, \nydist = %lf", xdist, ydist );
-*/
-
 }
 
 
@@ -251,16 +194,27 @@ void save_data( void )
 {
    int i;
 
-   fprintf( fpNEW, "%4.0lf%5.0lf", anklex, ankley );
+                 /* Hidden points go out as the hidden point code */
+   if ( TRAJ_OK( ankle, 0, n ) )
+      fprintf( fpNEW, "%4.0lf%5.0lf", floor( TRAJ_X( ankle, 0 )[n] + 0.5 ),
+                                      floor( TRAJ_Y( ankle, 0 )[n] + 0.5 ));
+   else
+      fprintf( fpNEW, "%4.0lf%5.0lf", TRAJ_HIDDEN, TRAJ_HIDDEN );
    for ( i = 0; i < numframes; i++ )
-      fprintf( fpNEW, "%6.0lf%5.0lf", f->joint[i].x, f->joint[i].y );
+      if ( TRAJ_OK( t, i, n ) )
+         fprintf( fpNEW, "%6.0lf%5.0lf", TRAJ_X( t, i )[n], TRAJ_Y( t, i )[n] );
+      else
+         fprintf( fpNEW, "%6.0lf%5.0lf", TRAJ_HIDDEN, TRAJ_HIDDEN );
    fprintf( fpNEW, "\n" );
 }
 
 void all_done( void )
 {
-   fclose( fpSESS);
+   txt_close( ts );
+   if ( fpSESS != NULL )
+      fclose( fpSESS);
    fclose( fpNEW);
-   free ( f );
+   traj_free ( ankle );
+   traj_free ( t );
    printf("\nALL DONE.!\n\n");
 }
@@ -0,0 +1,633 @@
+/**************************************************************************
+ *  BATCH.C
+ *
+ * Study batches. The following functions are public:
+ *
+ *   bat_read       -   Reads a manifest
+ *   bat_run        -   Runs every trial of a batch over the worker pool
+ *   bat_report     -   Writes the results in manifest order
+ *   bat_log        -   Writes how each trial went
+ *   bat_free       -   Releases a batch
+ *
+ * A trial opens its own files, runs with one thread and leaves its
+ * results in its TRIAL, so trials share nothing but the settings.
+ *
+ * With a cache directory, each trial is first keyed (cache.c) on its
+ * input files, parameters and the settings that affect it; a trial
+ * with an entry for its key takes its results from there instead of
+ * running.  A fin trial's entry holds its PIPERESULT, a velocity
+ * trial's its lines.  Kept .DTA and .TOR files must still be there,
+ * at the sizes they were written, for a fin entry to be used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "batch.h"
+#include "cache.h"
+#include "trjfile.h"
+#include "lsfit.h"
+#include "worker.h"
+
+/* Shared arguments of the per trial tasks */
+typedef struct _BATJOB
+{
+    BATCH *b;
+    int   *order;               /* Trials, biggest input first          */
+} BATJOB;
+
+/* What a fin trial's cache entry holds after its PIPERESULT */
+typedef struct _BATFINENT
+{
+    long    nosync;             /* The sync event wasn't found          */
+    long    dtasize, torsize;   /* Kept files as written, 0 if not kept */
+} BATFINENT;
+
+/* Prototypes for internal functions */
+static void  *bat_alloc( long n, size_t size );
+static int    bat_same( const char *a, const char *b );
+static long   bat_size( const char *path );
+static void   bat_path( char *path, const char *dir, const char *name,
+                        const char *ext );
+static void   bat_finmsg( TRIAL *tr, int nosync );
+static int    bat_finhit( BATCH *b, TRIAL *tr, const CACHEKEY *k );
+static void   bat_fin( BATCH *b, TRIAL *tr );
+static void   bat_velocity( BATCH *b, TRIAL *tr );
+static void   bat_task( void *arg, long i );
+
+
+/* bat_alloc - malloc() that stops the program if memory runs out.
+ */
+static void *bat_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n * size) );
+    if( p == NULL )
+      {
+        printf( "Error:  bat_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* bat_same - Compares two words, ignoring case.
+ *
+ * Return: 1 if they are the same word, else 0
+ */
+static int bat_same( const char *a, const char *b )
+{
+    for( ; *a != '\0' && *b != '\0'; a++, b++ )
+       if( tolower( (unsigned char) *a ) != tolower( (unsigned char) *b ) )
+          return 0;
+    return *a == *b;
+}
+
+
+/* bat_size - Size of a file.
+ *
+ * Return: Its bytes, or 0 if it can't be opened
+ */
+static long bat_size( const char *path )
+{
+    FILE *fp;
+    long size;
+
+    if( (fp = fopen( path, "rb" )) == NULL )
+       return 0L;
+    fseek( fp, 0L, SEEK_END );
+    size = ftell( fp );
+    fclose( fp );
+    return (size > 0L) ? size : 0L;
+}
+
+
+/* bat_path - Builds "dir" "name" "ext" in "path" (BAT_DIRLEN +
+ * BAT_NAMELEN + 4 bytes).
+ */
+static void bat_path( char *path, const char *dir, const char *name,
+                      const char *ext )
+{
+    strcpy( path, dir );
+    strcat( path, name );
+    strcat( path, ext );
+}
+
+
+/* bat_read - Reads the settings and trials of a manifest from "ts".
+ * Reading stops at the end of the file or at the first line that is
+ * not a whole trial.  Session files are looked for in "digdir", force
+ * files in "forcedir", .TOR files written to "tordir" and results
+ * cached in "cachedir" (NULL or "" for no cache), each ending in a
+ * path separator.
+ *
+ * Return: The batch, or NULL if the settings can't be read
+ */
+BATCH *bat_read( TXTSCAN *ts, const char *digdir, const char *forcedir,
+                 const char *tordir, const char *cachedir )
+{
+    BATCH *b;
+    TRIAL *tr, *grown;
+    char kind[BAT_NAMELEN];
+    double v[4];
+    long l[3];
+    int capacity = 16;
+
+    if( txt_doubles( ts, v, 4L ) != 4 )
+       return NULL;
+    b = (BATCH *) bat_alloc( 1L, sizeof(BATCH) );
+    b->rate = v[0];
+    b->method = ((int) v[1] == 1) ? ALN_SINC : ALN_LINEAR;
+    b->degree = ((int) v[2] < 1 || (int) v[2] > LSQ_MAXDEG) ? 1
+                                                            : (int) v[2];
+    b->keep = (int) v[3];
+    strncpy( b->digdir, digdir, BAT_DIRLEN - 1 );
+    strncpy( b->forcedir, forcedir, BAT_DIRLEN - 1 );
+    strncpy( b->tordir, tordir, BAT_DIRLEN - 1 );
+    b->digdir[BAT_DIRLEN - 1] = b->forcedir[BAT_DIRLEN - 1] = '\0';
+    b->tordir[BAT_DIRLEN - 1] = '\0';
+    b->cachedir[0] = '\0';
+    if( cachedir != NULL )
+       strncat( b->cachedir, cachedir, BAT_DIRLEN - 1 );
+    b->numtrials = 0;
+    b->trial = (TRIAL *) bat_alloc( (long) capacity, sizeof(TRIAL) );
+
+    while( txt_word( ts, kind, sizeof(kind) ) )
+      {
+        if( b->numtrials == capacity )
+          {
+            capacity *= 2;
+            grown = (TRIAL *) realloc( b->trial,
+                                       (size_t) capacity * sizeof(TRIAL) );
+            if( grown == NULL )
+              {
+                printf( "Error:  bat_read()  realloc failed.\n" );
+                exit( 1 );
+              }
+            b->trial = grown;
+          }
+        tr = b->trial + b->numtrials;
+        memset( tr, 0, sizeof(TRIAL) );
+        if( !txt_word( ts, tr->name, sizeof(tr->name) ) )
+           break;
+        if( bat_same( kind, "fin" ) )
+          {
+            tr->kind = BAT_FIN;
+            if( !txt_long( ts, &l[0] ) || txt_doubles( ts, v, 2L ) != 2
+                || !txt_long( ts, &l[1] ) || !txt_long( ts, &l[2] )
+                || txt_doubles( ts, &v[2], 2L ) != 2 )
+               break;
+            tr->fin = (int) l[0];
+            tr->alpha = v[0];
+            tr->distance = v[1];
+            tr->records = l[1];
+            tr->sync = l[2];
+            tr->chan = (int) v[2];
+            tr->level = v[3];
+          }
+        else if( bat_same( kind, "velocity" ) )
+          {
+            tr->kind = BAT_VELOCITY;
+            if( !txt_long( ts, &l[0] ) || !txt_long( ts, &l[1] ) )
+               break;
+            tr->lane = (int) l[0];
+            tr->records = l[1];
+          }
+        else
+           break;
+        b->numtrials++;
+      }
+    return b;
+}
+
+
+/* bat_finmsg - Sets a fin trial's status and message from its
+ * results.
+ */
+static void bat_finmsg( TRIAL *tr, int nosync )
+{
+    tr->status = (tr->res.solved == 0) ? BAT_OK : BAT_NODATA;
+    sprintf( tr->msg, "%ld records, %ld hidden, %ld fin the wrong way%s",
+             tr->res.records, tr->res.hidden, tr->res.badfin,
+             (tr->status != BAT_OK) ? ", too few to fit"
+             : nosync ? ", no sync event" : "" );
+}
+
+
+/* bat_finhit - Takes a fin trial's results from its cache entry.
+ *
+ * Return: 1 if they were there, 0 if the trial must be run
+ */
+static int bat_finhit( BATCH *b, TRIAL *tr, const CACHEKEY *k )
+{
+    char path[BAT_DIRLEN + BAT_NAMELEN + 4];
+    BATFINENT ent;
+    FILE *fp;
+    int ok;
+
+    if( (fp = cch_open( k, b->cachedir, ".FIN" )) == NULL )
+       return 0;
+    ok = fread( &tr->res, sizeof(PIPERESULT), 1, fp ) == 1
+         && fread( &ent, sizeof(ent), 1, fp ) == 1;
+    fclose( fp );
+    if( ok && b->keep )
+      {
+        bat_path( path, b->digdir, tr->name, ".DTA" );
+        ok = ent.dtasize > 0 && bat_size( path ) == ent.dtasize;
+        bat_path( path, b->tordir, tr->name, ".TOR" );
+        ok = ok && ent.torsize > 0 && bat_size( path ) == ent.torsize;
+      }
+    if( !ok )
+       return 0;
+    bat_finmsg( tr, (int) ent.nosync );
+    tr->cached = 1;
+    return 1;
+}
+
+
+/* bat_fin - Runs a fin trial through pipe.c, or takes it from the
+ * cache.
+ */
+static void bat_fin( BATCH *b, TRIAL *tr )
+{
+    char sessfile[BAT_DIRLEN + BAT_NAMELEN + 4];
+    char path[BAT_DIRLEN + BAT_NAMELEN + 4];
+    FILE *fpSESS = NULL, *fpFORCE, *fp;
+    TXTSCAN *tsSESS = NULL, *tsFORCE;
+    TRJMAP trjmap;
+    PIPESPEC p;
+    CACHEKEY key;
+    BATFINENT ent;
+    long njts;
+    int nosync = 0;
+
+    if( b->cachedir[0] != '\0' )       /* everything the results hang on */
+      {
+        cch_start( &key );
+        cch_long( &key, (long) BAT_FIN );
+        bat_path( path, b->digdir, tr->name, ".TRJ" );
+        if( cch_file( &key, path ) < 0 )
+          {
+            bat_path( path, b->digdir, tr->name, ".DAT" );
+            cch_file( &key, path );
+          }
+        bat_path( path, b->forcedir, tr->name, "" );
+        cch_file( &key, path );
+        cch_long( &key, (long) tr->fin );
+        cch_double( &key, tr->alpha );
+        cch_double( &key, tr->distance );
+        cch_long( &key, tr->records );
+        cch_long( &key, tr->sync );
+        cch_long( &key, (long) tr->chan );
+        cch_double( &key, tr->level );
+        cch_double( &key, b->rate );
+        cch_long( &key, (long) b->method );
+        cch_long( &key, (long) b->degree );
+        cch_long( &key, (long) PIP_BLOCK );
+        if( bat_finhit( b, tr, &key ) )
+           return;
+      }
+
+    memset( &p, 0, sizeof(p) );
+    p.name = tr->name;
+    p.fin = tr->fin;
+    p.alpha = tr->alpha;
+    p.distance = tr->distance;
+    p.records = tr->records;
+    p.method = b->method;
+    p.degree = b->degree;
+
+    bat_path( path, b->forcedir, tr->name, "" );
+    if( (fpFORCE = fopen( path, "r" )) == NULL )
+      {
+        tr->status = BAT_NOFILE;
+        sprintf( tr->msg, "force file not found" );
+        return;
+      }
+    tsFORCE = txt_open( fpFORCE );
+    txt_skip( tsFORCE, (long) TXT_BEDASHEAD );
+    p.plate = sig_create( TXT_BEDASCHAN, 0L, b->rate, 0.0 );
+    aln_read( p.plate, tsFORCE );
+    txt_close( tsFORCE );
+    fclose( fpFORCE );
+    if( tr->sync >= 0 )
+      {
+        if( tr->chan < 1 || tr->chan > TXT_BEDASCHAN
+            || (p.offset = aln_onset( p.plate, tr->chan - 1, tr->level ))
+               < 0.0 )
+          {
+            nosync = 1;
+            p.offset = 0.0;
+          }
+        else
+           p.offset -= tr->sync / PIP_RECRATE;
+      }
+
+    bat_path( sessfile, b->digdir, tr->name, ".TRJ" );
+    if( trj_map( &trjmap, sessfile ) == 0 )
+       p.map = &trjmap;
+    else
+      {
+        bat_path( sessfile, b->digdir, tr->name, ".DAT" );
+        if( (fpSESS = fopen( sessfile, "r" )) == NULL )
+          {
+            tr->status = BAT_NOFILE;
+            sprintf( tr->msg, "datafile not found" );
+            sig_free( p.plate );
+            return;
+          }
+        tsSESS = txt_open( fpSESS );
+        njts = 0;
+        txt_long( tsSESS, &njts );
+        p.ts = tsSESS;
+        p.numjoints = (int) njts;
+      }
+
+    if( b->keep )
+      {
+        bat_path( path, b->digdir, tr->name, ".DTA" );
+        p.dta = fopen( path, "w+" );
+        bat_path( path, b->tordir, tr->name, ".TOR" );
+        p.tor = fopen( path, "w+" );
+      }
+
+    if( b->keep && (p.dta == NULL || p.tor == NULL) )
+      {
+        tr->status = BAT_NOFILE;
+        sprintf( tr->msg, "cannot create intermediate files" );
+      }
+    else if( pip_run( &p, &tr->res, 1 ) < 0 )
+      {
+        tr->status = BAT_NODATA;
+        sprintf( tr->msg, "too few fin points" );
+      }
+    else
+       bat_finmsg( tr, nosync );
+
+    if( p.dta != NULL )
+       fclose( p.dta );
+    if( p.tor != NULL )
+       fclose( p.tor );
+    sig_free( p.plate );
+    if( p.map != NULL )
+       trj_unmap( &trjmap );
+    else
+      {
+        txt_close( tsSESS );
+        fclose( fpSESS );
+      }
+
+    if( b->cachedir[0] == '\0' || tr->status == BAT_NOFILE
+        || (fp = cch_create( &key, b->cachedir, (int) (tr - b->trial) ))
+           == NULL )
+       return;
+    ent.nosync = nosync;
+    ent.dtasize = ent.torsize = 0L;
+    if( b->keep )
+      {
+        bat_path( path, b->digdir, tr->name, ".DTA" );
+        ent.dtasize = bat_size( path );
+        bat_path( path, b->tordir, tr->name, ".TOR" );
+        ent.torsize = bat_size( path );
+      }
+    fwrite( &tr->res, sizeof(PIPERESULT), 1, fp );
+    fwrite( &ent, sizeof(ent), 1, fp );
+    cch_commit( fp, &key, b->cachedir, ".FIN", (int) (tr - b->trial) );
+}
+
+
+/* bat_velocity - Runs a velocity trial as velocity.c does, or takes it
+ * from the cache, writing its lines to a scratch file for bat_report().
+ */
+static void bat_velocity( BATCH *b, TRIAL *tr )
+{
+    char buf[512];
+    FILE *fpRAW, *fp = NULL;
+    TXTSCAN *ts;
+    CACHEKEY key;
+    double v[8], xdist, ydist, pixels, displacement, seconds, cfactor;
+    size_t got;
+    long n;
+    int oldrpe = 1, trial = 0;
+
+    if( tr->lane == 5 )
+       cfactor = 0.00850;
+    else if( tr->lane == 4 )
+       cfactor = 0.00695;
+    else if( tr->lane == 2 )
+       cfactor = 0.00577;
+    else
+      {
+        tr->status = BAT_BADPARM;
+        sprintf( tr->msg, "no conversion factor for lane %d", tr->lane );
+        return;
+      }
+    if( (tr->out = tmpfile()) == NULL )
+      {
+        tr->status = BAT_NOFILE;
+        sprintf( tr->msg, "cannot create scratch file" );
+        return;
+      }
+
+    if( b->cachedir[0] != '\0' )
+      {
+        cch_start( &key );
+        cch_long( &key, (long) BAT_VELOCITY );
+        cch_file( &key, tr->name );
+        cch_long( &key, (long) tr->lane );
+        cch_long( &key, tr->records );
+        if( (fp = cch_open( &key, b->cachedir, ".VEL" )) != NULL
+            && fread( &n, sizeof(n), 1, fp ) == 1 )
+          {
+            while( (got = fread( buf, 1, sizeof(buf), fp )) > 0 )
+               fwrite( buf, 1, got, tr->out );
+            fclose( fp );
+            sprintf( tr->msg, "%ld records", n );
+            tr->cached = 1;
+            return;
+          }
+        if( fp != NULL )
+           fclose( fp );
+      }
+
+    if( (fpRAW = fopen( tr->name, "r" )) == NULL )
+      {
+        tr->status = BAT_NOFILE;
+        sprintf( tr->msg, "datafile not found" );
+        return;
+      }
+
+    ts = txt_open( fpRAW );
+    for( n = 0; tr->records <= 0 || n < tr->records; n++ )
+      {
+        if( txt_doubles( ts, v, 8L ) != 8 )
+           break;
+                    /* subject fin rpe x1 y1 x2 y2 fields */
+        xdist = v[5] - v[3];
+        ydist = v[6] - v[4];
+        pixels = floor( sqrt( xdist * xdist + ydist * ydist ) + .5 );
+        displacement = pixels * cfactor;
+        seconds = v[7] / 60.0000;
+        if( (int) v[2] != oldrpe )
+           trial = 1;
+        else
+           trial += 1;
+        fprintf( tr->out, "%02d %02d %02d %02d %01d %03d %03d %03d %03d "
+                 "%03.0lf %01.4lf %01.4lf %02.4lf\n",
+                 (int) v[0], (int) v[1], (int) v[2], trial, tr->lane,
+                 (int) v[3], (int) v[4], (int) v[5], (int) v[6], pixels,
+                 displacement, seconds, displacement / seconds );
+        oldrpe = (int) v[2];
+      }
+    txt_close( ts );
+    fclose( fpRAW );
+    if( n == 0 )
+      {
+        tr->status = BAT_NODATA;
+        sprintf( tr->msg, "no records" );
+        return;
+      }
+    sprintf( tr->msg, "%ld records", n );
+
+    if( b->cachedir[0] == '\0'
+        || (fp = cch_create( &key, b->cachedir, (int) (tr - b->trial) ))
+           == NULL )
+       return;
+    fwrite( &n, sizeof(n), 1, fp );
+    rewind( tr->out );
+    while( (got = fread( buf, 1, sizeof(buf), tr->out )) > 0 )
+       fwrite( buf, 1, got, fp );
+    cch_commit( fp, &key, b->cachedir, ".VEL", (int) (tr - b->trial) );
+}
+
+
+/* bat_task - Task: the "i"th biggest trial.
+ */
+static void bat_task( void *arg, long i )
+{
+    BATJOB *job = (BATJOB *) arg;
+    TRIAL *tr = job->b->trial + job->order[i];
+
+    if( tr->kind == BAT_FIN )
+       bat_fin( job->b, tr );
+    else
+       bat_velocity( job->b, tr );
+}
+
+
+/* bat_run - Runs every trial of "b", using up to "nthreads" threads
+ * (0 = one per processor), biggest input first.
+ */
+void bat_run( BATCH *b, int nthreads )
+{
+    char path[BAT_DIRLEN + BAT_NAMELEN + 4];
+    BATJOB job;
+    TRIAL *tr;
+    int i, k;
+
+    for( i = 0; i < b->numtrials; i++ )
+      {
+        tr = b->trial + i;
+        if( tr->kind == BAT_VELOCITY )
+           tr->size = bat_size( tr->name );
+        else
+          {
+            bat_path( path, b->digdir, tr->name, ".TRJ" );
+            if( (tr->size = bat_size( path )) == 0 )
+              {
+                bat_path( path, b->digdir, tr->name, ".DAT" );
+                tr->size = bat_size( path );
+              }
+          }
+      }
+
+    job.b = b;                          /* insertion sort, biggest first */
+    job.order = (int *) bat_alloc( (long) b->numtrials + 1, sizeof(int) );
+    for( i = 0; i < b->numtrials; i++ )
+      {
+        for( k = i; k > 0 && b->trial[job.order[k - 1]].size
+                             < b->trial[i].size; k-- )
+           job.order[k] = job.order[k - 1];
+        job.order[k] = i;
+      }
+    work_run( (long) b->numtrials, bat_task, &job, nthreads );
+    free( job.order );
+}
+
+
+/* bat_report - Writes, in manifest order, every fitted fin to "graph"
+ * and "stats" (see lsq_report()) and every velocity trial's lines to
+ * "vel".
+ *
+ * Return: The number of trials that failed
+ */
+int bat_report( BATCH *b, int maxangle, FILE *graph, FILE *stats,
+                FILE *vel )
+{
+    char buf[512];
+    TRIAL *tr;
+    size_t got;
+    int i, good = 0, failed = 0;
+
+    for( i = 0; i < b->numtrials; i++ )
+       if( b->trial[i].kind == BAT_FIN && b->trial[i].status == BAT_OK )
+          good++;
+    fprintf( graph, "%d\n", good );
+    fprintf( stats, "Degree %d\n", b->degree );
+
+    for( i = 0; i < b->numtrials; i++ )
+      {
+        tr = b->trial + i;
+        if( tr->status != BAT_OK )
+          {
+            failed++;
+            continue;
+          }
+        if( tr->kind == BAT_FIN )
+           lsq_report( &tr->res.fit, tr->name, maxangle, graph, stats );
+        else if( tr->out != NULL )
+          {
+            rewind( tr->out );
+            while( (got = fread( buf, 1, sizeof(buf), tr->out )) > 0 )
+               fwrite( buf, 1, got, vel );
+          }
+      }
+    return failed;
+}
+
+
+/* bat_log - Writes a line per trial, in manifest order, to "fp": its
+ * name and what happened.
+ */
+void bat_log( BATCH *b, FILE *fp )
+{
+    TRIAL *tr;
+    int i;
+
+    for( i = 0; i < b->numtrials; i++ )
+      {
+        tr = b->trial + i;
+        fprintf( fp, "%-12s %s%s%s\n", tr->name,
+                 (tr->status == BAT_OK) ? "" : "FAILED: ", tr->msg,
+                 tr->cached ? " (cached)" : "" );
+      }
+}
+
+
+/* bat_free - Releases a batch and its scratch files.
+ */
+void bat_free( BATCH *b )
+{
+    int i;
+
+    if( b == NULL )
+       return;
+    for( i = 0; i < b->numtrials; i++ )
+       if( b->trial[i].out != NULL )
+          fclose( b->trial[i].out );
+    free( b->trial );
+    free( b );
+}
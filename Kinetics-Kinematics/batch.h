@@ -0,0 +1,92 @@
+/* BATCH.H
+ *
+ * A whole study run from a manifest, with no prompting.  The manifest
+ * is text: the settings the programs would ask for, then one trial to
+ * a line, each led by its kind:
+ *
+ *      rate  method  degree  keep
+ *      fin       name  fin  angle  distance  records  sync  chan  level
+ *      velocity  name  lane  records
+ *
+ * rate is the force plate's samples per second, method 0 linear or 1
+ * sinc, degree the fit's polynomial and keep 1 to write the "*.DTA"
+ * and "*.TOR" files as well.  A fin trial is "ankle.c", "torque.c"
+ * and the fit in one pass (pipe.c); see "pipeline.c" for its fields.
+ * A velocity trial is "velocity.c" over the file "name" for the lane
+ * (2, 4 or 5).
+ *
+ * bat_run() hands the trials to the worker pool (worker.c), biggest
+ * input first: threads take the next trial as they finish one, so a
+ * long trial started early no longer holds up the end of the batch.
+ * With a cache directory, a trial whose input files and parameters
+ * are unchanged since its results were cached (cache.c) is not run
+ * again.  Each trial keeps its own results and its own error; nothing
+ * is printed and nothing stops the batch.  bat_report() and bat_log()
+ * then write everything in manifest order, so the output does not
+ * depend on which thread ran what.
+ */
+
+/* Include only once */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include "txtscan.h"
+#include "pipe.h"
+
+#define BAT_FIN       0         /* Ankle, torque and fit                */
+#define BAT_VELOCITY  1         /* velocity.c                           */
+
+#define BAT_OK        0         /* Trial status                         */
+#define BAT_NOFILE    -1        /* An input file couldn't be opened     */
+#define BAT_NODATA    -2        /* Too few points or records            */
+#define BAT_BADPARM   -3        /* A parameter is out of range          */
+
+#define BAT_NAMELEN   13        /* Longest name, with its terminator    */
+#define BAT_DIRLEN    64
+#define BAT_MSGLEN    80
+
+typedef struct _TRIAL
+{
+    int     kind;               /* BAT_FIN or BAT_VELOCITY              */
+    char    name[BAT_NAMELEN];
+    long    records;            /* Records to run, <= 0 for all         */
+    int     fin;                /* BAT_FIN                              */
+    double  alpha, distance;
+    long    sync;
+    int     chan;
+    double  level;
+    int     lane;               /* BAT_VELOCITY                         */
+
+    long    size;               /* Bytes of input, for ordering         */
+    int     status;             /* BAT_OK, or what went wrong           */
+    char    msg[BAT_MSGLEN];    /* Counts, or the error                 */
+    PIPERESULT res;             /* BAT_FIN                              */
+    FILE   *out;                /* BAT_VELOCITY lines, a tmpfile()      */
+    int     cached;             /* Results came from the cache          */
+} TRIAL;
+
+typedef struct _BATCH
+{
+    double  rate;               /* Force plate samples per second       */
+    int     method;             /* ALN_LINEAR or ALN_SINC               */
+    int     degree;
+    int     keep;               /* Write .DTA and .TOR too              */
+    char    digdir[BAT_DIRLEN];     /* .TRJ, .DAT and .DTA              */
+    char    forcedir[BAT_DIRLEN];   /* BEDAS force files                */
+    char    tordir[BAT_DIRLEN];     /* .TOR                             */
+    char    cachedir[BAT_DIRLEN];   /* Cache entries, "" for none       */
+    int     numtrials;
+    TRIAL  *trial;
+} BATCH;
+
+/* Public batch functions */
+BATCH *bat_read( TXTSCAN *ts, const char *digdir, const char *forcedir,
+                 const char *tordir, const char *cachedir );
+void   bat_run( BATCH *b, int nthreads );
+int    bat_report( BATCH *b, int maxangle, FILE *graph, FILE *stats,
+                   FILE *vel );
+void   bat_log( BATCH *b, FILE *fp );
+void   bat_free( BATCH *b );
+
+#endif /* BATCH_H */
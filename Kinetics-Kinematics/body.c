@@ -0,0 +1,291 @@
+/**************************************************************************
+ *  BODY.C
+ *
+ * Whole body centre of mass and angular momentum. The following
+ * functions are public:
+ *
+ *   bod_map        -   Builds segments from joint names and a table
+ *   bod_compute    -   Centre of mass and angular momentum of a trial
+ *   bod_batch      -   The same for many trials at once
+ *   bod_free       -   Releases the results
+ *
+ * Segment centres of mass and angles come from id_segments() and are
+ * differentiated by kin_derive(); the sums over segments then run one
+ * segment at a time down whole columns.  bod_batch() makes each trial
+ * a task for the worker pool (worker.c).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include "body.h"
+#include "kinemat.h"
+#include "worker.h"
+
+/* Winter, Biomechanics and Motor Control of Human Movement (Dempster's
+   cadaver data): mass fraction, centre of mass and radius of gyration */
+const BODYPARM bod_winter[BOD_WINTER] =
+{
+    { "finger",   "wrist",    0.006,  0.506, 0.297 },   /* hand       */
+    { "wrist",    "elbow",    0.016,  0.430, 0.303 },   /* forearm    */
+    { "elbow",    "shoulder", 0.028,  0.436, 0.322 },   /* upper arm  */
+    { "toe",      "ankle",    0.0145, 0.500, 0.475 },   /* foot       */
+    { "ankle",    "knee",     0.0465, 0.433, 0.302 },   /* leg        */
+    { "knee",     "hip",      0.100,  0.433, 0.323 },   /* thigh      */
+    { "shoulder", "hip",      0.678,  0.626, 0.496 }    /* head, arms
+                                                           and trunk  */
+};
+
+/* Shared arguments of the per trial tasks */
+typedef struct _BODJOB
+{
+    TRAJECT      **pos;
+    const SEGMENT *seg;
+    int            numsegs;
+    int            stencil;
+    BODY         **out;
+} BODJOB;
+
+/* Prototypes for internal functions */
+static int  bod_joint( const char *names, int namestride, int numjoints,
+                       const char *name );
+static void bod_trial( void *arg, long i );
+
+
+/* bod_joint - Looks up a joint by name, ignoring case and trailing
+ * blanks.
+ *
+ * Return: The joint number, or -1 if there is none of that name
+ */
+static int bod_joint( const char *names, int namestride, int numjoints,
+                      const char *name )
+{
+    const char *a, *b;
+    int j, k;
+
+    for( j = 0; j < numjoints; j++ )
+      {
+        a = names + j * namestride;
+        b = name;
+        for( k = 0; k < namestride && a[k] != '\0' && a[k] != ' '; k++ )
+           if( b[k] == '\0'
+               || tolower( (unsigned char) a[k] )
+                  != tolower( (unsigned char) b[k] ) )
+              break;
+        if( (k == namestride || a[k] == '\0' || a[k] == ' ')
+            && b[k] == '\0' )
+           return j;
+      }
+    return -1;
+}
+
+
+/* bod_map - Fills "seg" with every segment of the "ntab" row table
+ * "tab" whose two joints are among the names of "pos" ("namestride"
+ * bytes apart), for a body of "bodymass" kg.  Each segment's length is
+ * its mean over the fields where both its joints are visible.
+ *
+ * Return: The number of segments found
+ */
+int bod_map( TRAJECT *pos, const char *names, int namestride,
+             const BODYPARM *tab, int ntab, double bodymass,
+             SEGMENT *seg )
+{
+    double *xd, *yd, *xp, *yp, len, dx, dy;
+    long n, seen;
+    int i, d, p, numsegs = 0;
+
+    for( i = 0; i < ntab; i++ )
+      {
+        d = bod_joint( names, namestride, pos->numjoints, tab[i].distal );
+        p = bod_joint( names, namestride, pos->numjoints, tab[i].proximal );
+        if( d < 0 || p < 0 )
+           continue;
+        xd = TRAJ_X( pos, d );
+        yd = TRAJ_Y( pos, d );
+        xp = TRAJ_X( pos, p );
+        yp = TRAJ_Y( pos, p );
+        for( len = 0.0, seen = 0, n = 0; n < pos->numframes; n++ )
+           if( TRAJ_OK( pos, d, n ) && TRAJ_OK( pos, p, n ) )
+             {
+               dx = xd[n] - xp[n];
+               dy = yd[n] - yp[n];
+               len += sqrt( dx * dx + dy * dy );
+               seen++;
+             }
+        len = (seen > 0) ? len / seen * pos->cfactor : 0.0;
+        seg[numsegs].distal = d;
+        seg[numsegs].proximal = p;
+        seg[numsegs].mass = tab[i].mass * bodymass;
+        seg[numsegs].com = tab[i].com;
+        seg[numsegs].inertia = seg[numsegs].mass
+                               * (tab[i].gyration * len)
+                               * (tab[i].gyration * len);
+        numsegs++;
+      }
+    return numsegs;
+}
+
+
+/* bod_compute - Whole body centre of mass, its velocity and the
+ * angular momentum about it for every field of "pos", made up of the
+ * "numsegs" segments "seg", differentiated with the given kinemat.c
+ * stencil using up to "nthreads" threads (0 = one per processor).
+ *
+ * Return: The results, or NULL for a bad segment or stencil
+ */
+BODY *bod_compute( TRAJECT *pos, const SEGMENT *seg, int numsegs,
+                   int stencil, int nthreads )
+{
+    BODY *b;
+    TRAJECT *ang, *vcom, *w;
+    double *rx, *ry, *vx, *vy, *h, *cx, *cy, *ux, *uy, *om, m, total;
+    unsigned char *mr, *mv;
+    long n, k, bytes;
+    int s;
+
+    if( stencil != KIN_CENTRAL3 && stencil != KIN_CENTRAL5 )
+       return NULL;
+    for( s = 0; s < numsegs; s++ )
+       if( seg[s].distal < 0 || seg[s].distal >= pos->numjoints
+           || seg[s].proximal < 0 || seg[s].proximal >= pos->numjoints )
+          return NULL;
+
+    b = (BODY *) malloc( sizeof(BODY) );
+    if( b == NULL )
+      {
+        printf( "Error:  bod_compute()  malloc failed.\n" );
+        exit( 1 );
+      }
+    b->numsegs = numsegs;
+    b->segcom = id_segments( pos, seg, numsegs, nthreads, &ang );
+    kin_derive( b->segcom, stencil, nthreads, &vcom, NULL );
+    kin_derive( ang, stencil, nthreads, &w, NULL );
+
+    b->whole = traj_create( 2, pos->numframes );
+    b->whole->skip = pos->skip;
+    b->whole->cfactor = 1.0;
+    while( b->whole->numframes < pos->numframes )
+       traj_append( b->whole );
+    b->angmom = (double *) calloc( (size_t) (pos->numframes + 1),
+                                   sizeof(double) );
+    if( b->angmom == NULL )
+      {
+        printf( "Error:  bod_compute()  malloc failed.\n" );
+        exit( 1 );
+      }
+
+    rx = TRAJ_X( b->whole, BOD_COM );
+    ry = TRAJ_Y( b->whole, BOD_COM );
+    vx = TRAJ_X( b->whole, BOD_VCOM );
+    vy = TRAJ_Y( b->whole, BOD_VCOM );
+    mr = TRAJ_MASK( b->whole, BOD_COM );
+    mv = TRAJ_MASK( b->whole, BOD_VCOM );
+    h = b->angmom;
+    bytes = (pos->numframes + 7) >> 3;
+
+    total = 0.0;                        /* mass weighted sums */
+    for( s = 0; s < numsegs; s++ )
+      {
+        m = seg[s].mass;
+        total += m;
+        cx = TRAJ_X( b->segcom, s );
+        cy = TRAJ_Y( b->segcom, s );
+        ux = TRAJ_X( vcom, s );
+        uy = TRAJ_Y( vcom, s );
+        for( n = 0; n < pos->numframes; n++ )
+          {
+            rx[n] += m * cx[n];
+            ry[n] += m * cy[n];
+            vx[n] += m * ux[n];
+            vy[n] += m * uy[n];
+          }
+        for( k = 0; k < bytes; k++ )
+          {
+            mr[k] &= TRAJ_MASK( b->segcom, s )[k];
+            mv[k] &= (unsigned char) (TRAJ_MASK( vcom, s )[k]
+                                      & TRAJ_MASK( w, s )[k]);
+          }
+      }
+    total = (total > 0.0) ? 1.0 / total : 0.0;
+    for( n = 0; n < pos->numframes; n++ )
+      {
+        rx[n] *= total;
+        ry[n] *= total;
+        vx[n] *= total;
+        vy[n] *= total;
+      }
+
+    for( s = 0; s < numsegs; s++ )      /* about the centre of mass */
+      {
+        m = seg[s].mass;
+        cx = TRAJ_X( b->segcom, s );
+        cy = TRAJ_Y( b->segcom, s );
+        ux = TRAJ_X( vcom, s );
+        uy = TRAJ_Y( vcom, s );
+        om = TRAJ_X( w, s );
+        for( n = 0; n < pos->numframes; n++ )
+           h[n] += m * ((cx[n] - rx[n]) * (uy[n] - vy[n])
+                        - (cy[n] - ry[n]) * (ux[n] - vx[n]))
+                   + seg[s].inertia * om[n];
+      }
+
+    for( n = 0; n < pos->numframes; n++ )   /* hidden results hold 0 */
+      {
+        m = (double) ((mr[n >> 3] >> (n & 7)) & 1);
+        rx[n] *= m;
+        ry[n] *= m;
+        m = (double) ((mv[n >> 3] >> (n & 7)) & 1);
+        vx[n] *= m;
+        vy[n] *= m;
+        h[n] *= m;
+      }
+    traj_free( ang );
+    traj_free( vcom );
+    traj_free( w );
+    return b;
+}
+
+
+/* bod_trial - Task: trial "i", on one thread.
+ */
+static void bod_trial( void *arg, long i )
+{
+    BODJOB *job = (BODJOB *) arg;
+
+    job->out[i] = bod_compute( job->pos[i], job->seg, job->numsegs,
+                               job->stencil, 1 );
+}
+
+
+/* bod_batch - Runs bod_compute() over the "ntrials" trials "pos",
+ * which share the same segments, one trial to a thread, using up to
+ * "nthreads" threads (0 = one per processor).  out[i] is set to the
+ * results of trial i.
+ */
+void bod_batch( TRAJECT **pos, int ntrials, const SEGMENT *seg,
+                int numsegs, int stencil, int nthreads, BODY **out )
+{
+    BODJOB job;
+
+    job.pos = pos;
+    job.seg = seg;
+    job.numsegs = numsegs;
+    job.stencil = stencil;
+    job.out = out;
+    work_run( (long) ntrials, bod_trial, &job, nthreads );
+}
+
+
+/* bod_free - Releases whole body results.
+ */
+void bod_free( BODY *b )
+{
+    if( b == NULL )
+       return;
+    traj_free( b->segcom );
+    traj_free( b->whole );
+    free( b->angmom );
+    free( b );
+}
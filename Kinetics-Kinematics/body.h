@@ -0,0 +1,68 @@
+/* BODY.H
+ *
+ * Whole body centre of mass and angular momentum.  Segments are found
+ * by the names the joints were given when the session was digitized
+ * (the .TRJ name table, jtnames in the digitizer), using a table of
+ * anthropometric parameters: each entry names a segment's distal and
+ * proximal joints and gives its mass as a fraction of body mass, its
+ * centre of mass from the proximal end and its radius of gyration
+ * about the centre of mass, both as fractions of its length.  The
+ * length is the mean over the session's visible fields.  bod_winter[]
+ * holds Winter's (Dempster's) values for the common segments.
+ *
+ * Then, for every field,
+ *
+ *      R = sum( m_i r_i ) / M
+ *      H = sum( m_i (r_i - R) x (v_i - V) + I_i w_i )
+ *
+ * with r_i, v_i each segment's centre of mass and its velocity and
+ * w_i its angular velocity.  H is about the whole body centre of mass,
+ * in kg m^2/s, counter clockwise positive; positions are taken as
+ * pos * pos->cfactor meters.  R is valid where every segment's centre
+ * of mass is visible, V and H where every derivative is.
+ */
+
+/* Include only once */
+#ifndef BODY_H
+#define BODY_H
+
+#include "traject.h"
+#include "invdyn.h"
+
+#define BOD_NAMELEN  16         /* Joint name characters, as TRJ_NAMELEN */
+#define BOD_WINTER   7          /* Entries in bod_winter[]              */
+
+#define BOD_COM      0          /* Joints of BODY.whole: centre of mass */
+#define BOD_VCOM     1          /*   and its velocity                   */
+
+/* One row of an anthropometric table */
+typedef struct _BODYPARM
+{
+    char    distal[BOD_NAMELEN];
+    char    proximal[BOD_NAMELEN];
+    double  mass;               /* Fraction of body mass                */
+    double  com;                /* From the proximal end, of the length */
+    double  gyration;           /* About the centre of mass, of length  */
+} BODYPARM;
+
+typedef struct _BODY
+{
+    int      numsegs;
+    TRAJECT *segcom;            /* Centre of mass of each segment       */
+    TRAJECT *whole;             /* BOD_COM and BOD_VCOM, meters         */
+    double  *angmom;            /* H, valid where BOD_VCOM is           */
+} BODY;
+
+extern const BODYPARM bod_winter[BOD_WINTER];
+
+/* Public whole body functions */
+int   bod_map( TRAJECT *pos, const char *names, int namestride,
+               const BODYPARM *tab, int ntab, double bodymass,
+               SEGMENT *seg );
+BODY *bod_compute( TRAJECT *pos, const SEGMENT *seg, int numsegs,
+                   int stencil, int nthreads );
+void  bod_batch( TRAJECT **pos, int ntrials, const SEGMENT *seg,
+                 int numsegs, int stencil, int nthreads, BODY **out );
+void  bod_free( BODY *b );
+
+#endif /* BODY_H */
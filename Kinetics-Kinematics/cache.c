@@ -0,0 +1,222 @@
+/**************************************************************************
+ *  CACHE.C
+ *
+ * Content keyed result cache. The following functions are public:
+ *
+ *   cch_start      -   Starts a key
+ *   cch_bytes      -   Adds bytes to a key
+ *   cch_long       -   Adds a whole number parameter to a key
+ *   cch_double     -   Adds a real parameter to a key
+ *   cch_file       -   Adds a file's contents to a key
+ *   cch_open       -   Opens the entry for a key, if there is one
+ *   cch_create     -   Starts writing the entry for a key
+ *   cch_commit     -   Finishes an entry and puts it in place
+ *
+ * The CRC is worked a nibble at a time from a 16 entry table, which
+ * needs no setting up and so is safe from any thread.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "cache.h"
+
+#define CCH_BUFSIZE  8192       /* Bytes of a file hashed at a time     */
+#define CCH_MASK     0xFFFFFFFFUL
+
+/* Head of every entry */
+typedef struct _CCHHEAD
+{
+    char          magic[8];     /* CCH_MAGIC                            */
+    long          version;      /* CCH_VERSION                          */
+    unsigned long fnv, crc;
+    long          bytes;
+} CCHHEAD;
+
+static const unsigned long cch_crctab[16] =
+{
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+/* Prototypes for internal functions */
+static void cch_path( char *path, const CACHEKEY *k, const char *dir,
+                      const char *ext );
+static void cch_head( CCHHEAD *h, const CACHEKEY *k );
+
+
+/* cch_start - Starts an empty key.
+ */
+void cch_start( CACHEKEY *k )
+{
+    k->fnv = 2166136261UL;
+    k->crc = CCH_MASK;
+    k->bytes = 0L;
+}
+
+
+/* cch_bytes - Adds the "n" bytes at "p" to the key.
+ */
+void cch_bytes( CACHEKEY *k, const void *p, long n )
+{
+    const unsigned char *b = (const unsigned char *) p;
+    unsigned long fnv = k->fnv, crc = k->crc;
+    long i;
+
+    for( i = 0; i < n; i++ )
+      {
+        fnv = ((fnv ^ b[i]) * 16777619UL) & CCH_MASK;
+        crc ^= b[i];
+        crc = (crc >> 4) ^ cch_crctab[crc & 15];
+        crc = (crc >> 4) ^ cch_crctab[crc & 15];
+      }
+    k->fnv = fnv;
+    k->crc = crc;
+    k->bytes += n;
+}
+
+
+/* cch_long - Adds a whole number parameter to the key.
+ */
+void cch_long( CACHEKEY *k, long v )
+{
+    cch_bytes( k, &v, (long) sizeof(v) );
+}
+
+
+/* cch_double - Adds a real parameter to the key.
+ */
+void cch_double( CACHEKEY *k, double v )
+{
+    cch_bytes( k, &v, (long) sizeof(v) );
+}
+
+
+/* cch_file - Adds the contents of the file at "path" to the key, or
+ * a marker that there was none, so a file appearing changes the key.
+ *
+ * Return: 0 if the file was read, -1 if it couldn't be opened
+ */
+int cch_file( CACHEKEY *k, const char *path )
+{
+    unsigned char buf[CCH_BUFSIZE];
+    FILE *fp;
+    size_t got;
+
+    if( (fp = fopen( path, "rb" )) == NULL )
+      {
+        cch_long( k, -1L );
+        return -1;
+      }
+    while( (got = fread( buf, 1, sizeof(buf), fp )) > 0 )
+       cch_bytes( k, buf, (long) got );
+    fclose( fp );
+    cch_long( k, 0L );
+    return 0;
+}
+
+
+/* cch_path - Builds the path of the entry for "k" in "path".
+ */
+static void cch_path( char *path, const CACHEKEY *k, const char *dir,
+                      const char *ext )
+{
+    sprintf( path, "%.*s%08lX%.4s", CCH_PATHLEN - 14, dir, k->fnv, ext );
+}
+
+
+/* cch_head - Fills in an entry's head for "k".
+ */
+static void cch_head( CCHHEAD *h, const CACHEKEY *k )
+{
+    memset( h, 0, sizeof(CCHHEAD) );
+    strcpy( h->magic, CCH_MAGIC );
+    h->version = CCH_VERSION;
+    h->fnv = k->fnv;
+    h->crc = k->crc ^ CCH_MASK;
+    h->bytes = k->bytes;
+}
+
+
+/* cch_open - Opens the "ext" entry for "k" in "dir" for reading.
+ *
+ * Return: The entry, positioned after its head, or NULL if there is
+ *         none for this key
+ */
+FILE *cch_open( const CACHEKEY *k, const char *dir, const char *ext )
+{
+    char path[CCH_PATHLEN];
+    CCHHEAD want, have;
+    FILE *fp;
+
+    cch_path( path, k, dir, ext );
+    if( (fp = fopen( path, "rb" )) == NULL )
+       return NULL;
+    cch_head( &want, k );
+    if( fread( &have, sizeof(have), 1, fp ) != 1
+        || memcmp( &have, &want, sizeof(have) ) != 0 )
+      {
+        fclose( fp );
+        return NULL;
+      }
+    return fp;
+}
+
+
+/* cch_create - Starts an entry for "k" in "dir", under a scratch name
+ * told apart by "tag" (e.g. the trial number) in case two writers have
+ * the same key at once.  cch_commit() gives it its extension.
+ *
+ * Return: The scratch file, positioned after the head, or NULL if it
+ *         can't be created
+ */
+FILE *cch_create( const CACHEKEY *k, const char *dir, int tag )
+{
+    char path[CCH_PATHLEN], scratch[8];
+    CCHHEAD h;
+    FILE *fp;
+
+    sprintf( scratch, ".%02X", tag & 0xFF );
+    cch_path( path, k, dir, scratch );
+    if( (fp = fopen( path, "wb" )) == NULL )
+       return NULL;
+    cch_head( &h, k );
+    if( fwrite( &h, sizeof(h), 1, fp ) != 1 )
+      {
+        fclose( fp );
+        remove( path );
+        return NULL;
+      }
+    return fp;
+}
+
+
+/* cch_commit - Closes an entry from cch_create() and renames it into
+ * place, or throws it away if it could not all be written.
+ *
+ * Return: 0 on success, -1 if the entry was thrown away
+ */
+int cch_commit( FILE *fp, const CACHEKEY *k, const char *dir,
+                const char *ext, int tag )
+{
+    char path[CCH_PATHLEN], scratch[CCH_PATHLEN], ending[8];
+    int bad;
+
+    sprintf( ending, ".%02X", tag & 0xFF );
+    cch_path( scratch, k, dir, ending );
+    cch_path( path, k, dir, ext );
+    bad = ferror( fp );
+    if( fclose( fp ) != 0 || bad )
+      {
+        remove( scratch );
+        return -1;
+      }
+    remove( path );                     /* rename won't replace, in DOS */
+    if( rename( scratch, path ) != 0 )
+      {
+        remove( scratch );
+        return -1;
+      }
+    return 0;
+}
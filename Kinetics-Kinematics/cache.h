@@ -0,0 +1,47 @@
+/* CACHE.H
+ *
+ * Results kept on disk under a fingerprint of everything they were
+ * made from, so a batch run can skip trials whose inputs and settings
+ * have not changed.
+ *
+ * A key is built up from the input files' contents and the parameters
+ * with cch_file(), cch_long() and cch_double(): two 32 bit hashes
+ * (FNV-1a and the CRC-32 of zip and Ethernet) and the byte count.  An
+ * entry is the file "dir\HHHHHHHH.ext", HHHHHHHH the FNV hash in hex,
+ * starting with the whole key; cch_open() only hands back an entry
+ * whose stored key matches, so two keys that share a name simply miss.
+ *
+ * An entry is written under a scratch name and renamed when complete
+ * (cch_commit()), so a run cut short never leaves a half entry behind.
+ * Bump CCH_VERSION when a stage's results change for the same inputs.
+ */
+
+/* Include only once */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdio.h>
+
+#define CCH_MAGIC    "PUMACCH"
+#define CCH_VERSION  1L
+#define CCH_PATHLEN  96         /* Longest entry path, with terminator  */
+
+typedef struct _CACHEKEY
+{
+    unsigned long fnv;          /* FNV-1a, 32 bits                      */
+    unsigned long crc;          /* CRC-32                               */
+    long          bytes;        /* Bytes hashed                         */
+} CACHEKEY;
+
+/* Public cache functions */
+void  cch_start( CACHEKEY *k );
+void  cch_bytes( CACHEKEY *k, const void *p, long n );
+void  cch_long( CACHEKEY *k, long v );
+void  cch_double( CACHEKEY *k, double v );
+int   cch_file( CACHEKEY *k, const char *path );
+FILE *cch_open( const CACHEKEY *k, const char *dir, const char *ext );
+FILE *cch_create( const CACHEKEY *k, const char *dir, int tag );
+int   cch_commit( FILE *fp, const CACHEKEY *k, const char *dir,
+                  const char *ext, int tag );
+
+#endif /* CACHE_H */
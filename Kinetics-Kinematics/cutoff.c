@@ -0,0 +1,139 @@
+/* Cutoff Program.
+   ------------------
+   Program prompts for a datafile name and chooses a smoothing cutoff
+   for every joint by residual analysis (resid.c).  The residual curves
+   and chosen cutoffs are written to "*.RES" and the cutoffs shown on
+   the screen.
+
+   The digitizer's binary "*.TRJ" is used if there is one (it carries
+   the joint names and fields skipped); otherwise the "*.DAT" text is
+   read and the number of fields skipped is asked for.
+
+   Compile with:
+
+         cl /AL /I..\VideoCapture cutoff.c resid.c smooth.c kinemat.c
+            ..\VideoCapture\traject.c ..\VideoCapture\trjfile.c
+            ..\VideoCapture\filemap.c ..\VideoCapture\txtscan.c
+            ..\VideoCapture\worker.c
+
+   (add /DPUMA_THREADS and -lpthread on a system with POSIX threads).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traject.h"
+#include "trjfile.h"
+#include "txtscan.h"
+#include "resid.h"
+
+void open_files( void );
+void calculate( void );
+void save_data( void );
+void all_done( void );
+
+char datafile[9], *names;
+double low, high, step;
+
+TRAJECT *t;
+RESIDUAL *r;
+
+FILE *fpNEW;
+
+main()
+{
+   open_files();
+   calculate();
+   save_data();
+   all_done();
+}
+
+
+void open_files( void )
+{
+   int length;
+   long njts;
+   char sessfile[28], newdatafile[28];
+   FILE *fpSESS;
+   TXTSCAN *ts;
+   TRJMAP trjmap;
+
+   printf("Enter the name of the datafile (no extension): ");
+   scanf( "%8s", datafile );
+   length = strlen( datafile );
+   strcpy (sessfile, "F:\\FP_DIG.DAT\\");
+   strncat (sessfile, datafile, length + 1 );
+   strcat (sessfile, ".TRJ");
+   if ( trj_map( &trjmap, sessfile ) == 0 )
+     {
+      t = trj_traject( &trjmap );
+      names = (char *) malloc( t->numjoints * TRJ_NAMELEN + 1 );
+      if ( names != NULL )
+         memcpy( names, trjmap.names, t->numjoints * TRJ_NAMELEN );
+      trj_unmap( &trjmap );
+     }
+   else
+     {
+      strcpy (sessfile + strlen( sessfile ) - 4, ".DAT");
+      if ((fpSESS = fopen( sessfile, "r")) == NULL )
+        {
+         printf("\nDatafile not found.");
+         exit( 1 );
+        }
+      ts = txt_open( fpSESS );
+      txt_long( ts, &njts );
+      t = traj_create( (int) njts, 0L );
+      txt_traject( ts, t, -1L, TXT_DAT );
+      txt_close( ts );
+      fclose( fpSESS );
+      printf("\nEnter the number of fields skipped: ");
+      scanf( "%d", &t->skip );
+     }
+   printf("\nLowest and highest cutoff and step in Hz");
+   printf("\n(0 0 0 for %2.0lf to %2.0lf): ", RES_LOW, RES_HIGH );
+   scanf( "%lf%lf%lf", &low, &high, &step );
+   strcpy ( newdatafile, "F:\\FP_DIG.DAT\\");
+   strncat ( newdatafile, datafile, length + 1 );
+   strcat ( newdatafile, ".RES");
+   if ((fpNEW = fopen( newdatafile, "w")) == NULL)
+     {
+      printf("\nCannot create new datafile");
+      exit( 1 );
+     }
+}
+
+
+void calculate( void )
+{
+   if (( r = res_sweep( t, low, high, step, 0 )) == NULL )
+     {
+      printf("\nNo usable cutoffs for this field rate.");
+      exit( 1 );
+     }
+}
+
+
+void save_data( void )
+{
+   int j;
+
+   res_report( r, fpNEW, names, TRJ_NAMELEN );
+   for ( j = 0; j < r->numjoints; j++ )
+     {
+      if ( names != NULL )
+         printf( "\n%-12s", names + j * TRJ_NAMELEN );
+      else
+         printf( "\nJOINT%-7d", j + 1 );
+      printf( "%6.2lf Hz", r->best[j] );
+     }
+}
+
+
+void all_done( void )
+{
+   fclose( fpNEW );
+   res_free( r );
+   traj_free( t );
+   free( names );
+   printf("\n\nALL DONE.!\n\n");
+}
@@ -0,0 +1,196 @@
+/* Derivative Program.
+   ------------------
+   Program prompts for a datafile name and writes the velocity and
+   acceleration of every joint, for every field, to "*.VEL".
+   Replaces running "velocity.c" one record at a time.
+
+   The digitizer's binary "*.TRJ" is used if there is one (pixels,
+   converted with its own conversion factor and skip); otherwise the
+   "*.DAT" text (already in meters) is read and the number of fields
+   skipped is asked for.  A value that can't be computed (hidden point
+   in its stencil, or too near either end) is written as 999.
+
+   The coordinates can first be smoothed with a zero lag Butterworth
+   filter (smooth.c); give a cutoff of 0 to differentiate them raw, or
+   -1 to let residual analysis (resid.c) choose one for each joint.
+   Short runs of hidden points can be filled with cubic splines
+   (gapfill.c) beforehand; the runs filled are listed in "*.GAP".
+
+   "*.VEL" holds the datafile name, joints, fields and seconds per
+   field, then one line per field:  field  vx vy ax ay  for each joint.
+
+   Compile with:
+
+         cl /AL /I..\VideoCapture deriv.c kinemat.c smooth.c resid.c
+            gapfill.c ..\VideoCapture\traject.c ..\VideoCapture\trjfile.c
+            ..\VideoCapture\filemap.c ..\VideoCapture\txtscan.c
+            ..\VideoCapture\worker.c
+
+   (add /DPUMA_THREADS and -lpthread on a system with POSIX threads
+   to spread the joints over every processor).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traject.h"
+#include "trjfile.h"
+#include "txtscan.h"
+#include "kinemat.h"
+#include "smooth.h"
+#include "resid.h"
+#include "gapfill.h"
+
+void open_files( void );
+void calculate( void );
+void save_data( void );
+void all_done( void );
+
+char datafile[9];
+int stencil;
+long maxgap;
+double cutoff;
+
+TRAJECT *t, *vel, *acc;
+
+FILE *fpNEW;
+
+main()
+{
+   open_files();
+   calculate();
+   save_data();
+   all_done();
+}
+
+
+void open_files( void )
+{
+   int length;
+   long njts;
+   char sessfile[28], newdatafile[28];
+   FILE *fpSESS;
+   TXTSCAN *ts;
+   TRJMAP trjmap;
+
+   printf("Enter the name of the datafile (no extension): ");
+   scanf( "%8s", datafile );
+   length = strlen( datafile );
+   strcpy (sessfile, "F:\\FP_DIG.DAT\\");
+   strncat (sessfile, datafile, length + 1 );
+   strcat (sessfile, ".TRJ");
+   if ( trj_map( &trjmap, sessfile ) == 0 )
+     {
+      t = trj_traject( &trjmap );
+      trj_unmap( &trjmap );
+     }
+   else
+     {
+      strcpy (sessfile + strlen( sessfile ) - 4, ".DAT");
+      if ((fpSESS = fopen( sessfile, "r")) == NULL )
+        {
+         printf("\nDatafile not found.");
+         exit( 1 );
+        }
+      ts = txt_open( fpSESS );
+      txt_long( ts, &njts );
+      t = traj_create( (int) njts, 0L );
+      txt_traject( ts, t, -1L, TXT_DAT );
+      txt_close( ts );
+      fclose( fpSESS );
+      printf("\nEnter the number of fields skipped: ");
+      scanf( "%d", &t->skip );
+     }
+   printf("\nLongest hidden gap to fill, in fields (0 for none): ");
+   scanf( "%ld", &maxgap );
+   printf("\nSmoothing cutoff in Hz (0 for none, -1 for automatic): ");
+   scanf( "%lf", &cutoff );
+   printf("\nStencil, 3 or 5 point: ");
+   scanf( "%d", &stencil );
+   strcpy ( newdatafile, "F:\\FP_DIG.DAT\\");
+   strncat ( newdatafile, datafile, length + 1 );
+   strcat ( newdatafile, ".VEL");
+   if ((fpNEW = fopen( newdatafile, "w")) == NULL)
+     {
+      printf("\nCannot create new datafile");
+      exit( 1 );
+     }
+}
+
+
+void calculate( void )
+{
+   RESIDUAL *r;
+   GAPLIST *g;
+   FILE *fpGAP;
+   char gapfile[28];
+
+   if ( maxgap > 0 )               /* splines over the short gaps */
+     {
+      g = gap_fill( t, maxgap, GAP_NATURAL, 0 );
+      printf("\n%ld fields filled in %ld gaps.", g->filled, g->count );
+      strcpy ( gapfile, "F:\\FP_DIG.DAT\\");
+      strcat ( gapfile, datafile );
+      strcat ( gapfile, ".GAP");
+      if (( fpGAP = fopen( gapfile, "w")) != NULL )
+        {
+         gap_report( g, fpGAP );
+         fclose( fpGAP );
+        }
+      gap_free( g );
+     }
+   if ( cutoff < 0.0 )             /* each joint's own, by residuals */
+     {
+      if (( r = res_sweep( t, 0.0, 0.0, 0.0, 0 )) != NULL )
+        {
+         smo_joints( t, r->best, 0 );
+         res_free( r );
+        }
+     }
+   else if (( cutoff > 0.0 ) && ( smo_filter( t, cutoff, 0 ) < 0 ))
+     {
+      printf("\nCutoff must be below %4.1lf Hz.",
+                  SMO_PASSES / ( 2.0 * kin_interval( t )));
+      exit( 1 );
+     }
+   if ( kin_derive( t, stencil, 0, &vel, &acc ) < 0 )
+     {
+      printf("\nStencil must be 3 or 5.");
+      exit( 1 );
+     }
+}
+
+
+void save_data( void )
+{
+   int j;
+   long n;
+   double cf;
+
+   cf = t->cfactor;             /* pixels to meters, 1 for a .DAT */
+   fprintf( fpNEW, "%s\n%d\n%ld\n%01.5lf\n", datafile, t->numjoints,
+                   t->numframes, kin_interval( t ));
+   for ( n = 0; n < t->numframes; n++ )
+     {
+      fprintf( fpNEW, "%04ld", n );
+      for ( j = 0; j < t->numjoints; j++ )
+         if ( TRAJ_OK( vel, j, n ) )
+            fprintf( fpNEW, " %9.4lf %9.4lf %10.4lf %10.4lf",
+                     TRAJ_X( vel, j )[n] * cf, TRAJ_Y( vel, j )[n] * cf,
+                     TRAJ_X( acc, j )[n] * cf, TRAJ_Y( acc, j )[n] * cf );
+         else
+            fprintf( fpNEW, " %9.0lf %9.0lf %10.0lf %10.0lf", TRAJ_HIDDEN,
+                     TRAJ_HIDDEN, TRAJ_HIDDEN, TRAJ_HIDDEN );
+      fprintf( fpNEW, "\n" );
+     }
+}
+
+
+void all_done( void )
+{
+   fclose( fpNEW );
+   traj_free( t );
+   traj_free( vel );
+   traj_free( acc );
+   printf("\nALL DONE.!\n\n");
+}
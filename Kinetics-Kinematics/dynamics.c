@@ -0,0 +1,312 @@
+/* Dynamics Program.
+   ------------------
+   Program prompts for a datafile name and writes the force and moment
+   at the proximal joint of every segment of a chain (fin, shank,
+   thigh ...), for every field, to "*.JNT".  Generalizes the single
+   ankle torque of "torque.c" by inverse dynamics (invdyn.c).
+
+   The chain is read from "*.SEG":
+
+         segments  load joint
+         distal joint  proximal joint  mass  com  inertia
+
+   one line per segment, most distal first, joints numbered from 1.
+   Mass is in kg, com the centre of mass from the proximal end as a
+   fraction of the length, inertia about the centre of mass in kg m^2.
+   The force plate load (fy fz of the BEDAS file, as in "torque.c")
+   acts at the load joint; give 0 for a chain with no plate.
+
+   The digitizer's binary "*.TRJ" is used if there is one; otherwise
+   the "*.DAT" text is read and the number of fields skipped is asked
+   for.  Image y runs down, so it is turned over before use.  The
+   coordinates are smoothed (smooth.c) at the cutoff given and the
+   plate is resampled at the field times (align.c).  A value that
+   can't be computed is written as 999.
+
+   Compile with:
+
+         cl /AL /I..\VideoCapture dynamics.c invdyn.c angles.c kinemat.c
+            smooth.c align.c ..\VideoCapture\traject.c
+            ..\VideoCapture\trjfile.c ..\VideoCapture\filemap.c
+            ..\VideoCapture\txtscan.c ..\VideoCapture\worker.c
+
+   (add /DPUMA_THREADS and -lpthread on a system with POSIX threads
+   to spread the fields over every processor).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traject.h"
+#include "trjfile.h"
+#include "txtscan.h"
+#include "kinemat.h"
+#include "smooth.h"
+#include "align.h"
+#include "invdyn.h"
+
+#define MAXSEGS 16
+
+void open_files( void );
+void open_chain( void );
+void open_force( void );
+void calculate( void );
+void save_data( void );
+void all_done( void );
+
+char datafile[9];
+int numsegs, loadjoint, stencil;
+double cutoff;
+
+SEGMENT seg[MAXSEGS];
+TRAJECT *t;
+SIGNAL *force;          /* plate fy fz, one sample per field */
+IDRESULT *r;
+
+FILE *fpNEW;
+
+main()
+{
+   open_files();
+   open_chain();
+   open_force();
+   calculate();
+   save_data();
+   all_done();
+}
+
+
+void open_files( void )
+{
+   int j, length;
+   long n, njts;
+   char sessfile[28], newdatafile[28];
+   double *y;
+   FILE *fpSESS;
+   TXTSCAN *ts;
+   TRJMAP trjmap;
+
+   printf("Enter the name of the datafile (no extension): ");
+   scanf( "%8s", datafile );
+   length = strlen( datafile );
+   strcpy (sessfile, "F:\\FP_DIG.DAT\\");
+   strncat (sessfile, datafile, length + 1 );
+   strcat (sessfile, ".TRJ");
+   if ( trj_map( &trjmap, sessfile ) == 0 )
+     {
+      t = trj_traject( &trjmap );
+      trj_unmap( &trjmap );
+     }
+   else
+     {
+      strcpy (sessfile + strlen( sessfile ) - 4, ".DAT");
+      if ((fpSESS = fopen( sessfile, "r")) == NULL )
+        {
+         printf("\nDatafile not found.");
+         exit( 1 );
+        }
+      ts = txt_open( fpSESS );
+      txt_long( ts, &njts );
+      t = traj_create( (int) njts, 0L );
+      txt_traject( ts, t, -1L, TXT_DAT );
+      txt_close( ts );
+      fclose( fpSESS );
+      printf("\nEnter the number of fields skipped: ");
+      scanf( "%d", &t->skip );
+     }
+   for ( j = 0; j < t->numjoints; j++ )      /* y up */
+     {
+      y = TRAJ_Y( t, j );
+      for ( n = 0; n < t->numframes; n++ )
+         y[n] = -y[n];
+     }
+   printf("\nSmoothing cutoff in Hz (0 for none): ");
+   scanf( "%lf", &cutoff );
+   printf("\nStencil, 3 or 5 point: ");
+   scanf( "%d", &stencil );
+   strcpy ( newdatafile, "F:\\FP_DIG.DAT\\");
+   strncat ( newdatafile, datafile, length + 1 );
+   strcat ( newdatafile, ".JNT");
+   if ((fpNEW = fopen( newdatafile, "w")) == NULL)
+     {
+      printf("\nCannot create new datafile");
+      exit( 1 );
+     }
+}
+
+
+void open_chain( void )
+{
+   int s;
+   long v[2];
+   double p[3];
+   char segfile[28];
+   FILE *fpSEG;
+   TXTSCAN *ts;
+
+   strcpy ( segfile, "F:\\FP_DIG.DAT\\");
+   strcat ( segfile, datafile );
+   strcat ( segfile, ".SEG");
+   if ((fpSEG = fopen( segfile, "r")) == NULL )
+     {
+      printf("\nSegment file not found.");
+      exit( 1 );
+     }
+   ts = txt_open( fpSEG );
+   if ( !txt_long( ts, &v[0] ) || !txt_long( ts, &v[1] )
+        || ( v[0] < 1 ) || ( v[0] > MAXSEGS ))
+     {
+      printf("\nSegment file must start with 1 to %d segments.", MAXSEGS );
+      exit( 1 );
+     }
+   numsegs = (int) v[0];
+   loadjoint = (int) v[1];
+   for ( s = 0; s < numsegs; s++ )
+     {
+      if ( !txt_long( ts, &v[0] ) || !txt_long( ts, &v[1] )
+           || ( txt_doubles( ts, p, 3L ) != 3 ))
+        {
+         printf("\nSegment %d is incomplete.", s + 1 );
+         exit( 1 );
+        }
+      seg[s].distal = (int) v[0] - 1;
+      seg[s].proximal = (int) v[1] - 1;
+      seg[s].mass = p[0];
+      seg[s].com = p[1];
+      seg[s].inertia = p[2];
+     }
+   txt_close( ts );
+   fclose( fpSEG );
+}
+
+
+void open_force( void )
+{
+   int chan;
+   long sync;
+   double rate, level, offset;
+   char forcefile[28];
+   FILE *fpFORCE;
+   TXTSCAN *ts;
+   SIGNAL *plate;
+
+   if ( loadjoint < 1 )
+      return;
+   strcpy ( forcefile, "F:\\FORCE.DAT\\" );
+   strcat ( forcefile, datafile );
+   if ((fpFORCE = fopen( forcefile, "r" )) == NULL )
+     {
+      printf( "\nForce datafile not opened." );
+      exit( 1 );
+     }
+   printf("\nForce plate samples per second: ");
+   scanf( "%lf", &rate );
+   printf("\nRecord of the sync event (-1 if the starts are in step): ");
+   scanf( "%ld", &sync );
+   ts = txt_open( fpFORCE );
+   txt_skip( ts, (long) TXT_BEDASHEAD );
+   plate = sig_create( TXT_BEDASCHAN, 0L, rate, 0.0 );
+   aln_read( plate, ts );
+   txt_close( ts );
+   fclose( fpFORCE );
+   offset = 0.0;
+   if ( sync >= 0 )
+     {
+      printf("\nForce channel (1-6) and level of the sync event: ");
+      scanf( "%d %lf", &chan, &level );
+      if (( chan < 1 ) || ( chan > TXT_BEDASCHAN )
+          || (( offset = aln_onset( plate, chan - 1, level )) < 0.0 ))
+        {
+         printf( "\nSync event not found, starts taken as in step." );
+         offset = 0.0;
+        }
+      else
+         offset -= sync * kin_interval( t );
+     }
+   force = aln_resample( plate, 1.0 / kin_interval( t ), 0.0,
+                         t->numframes, offset, ALN_SINC );
+   sig_free( plate );
+}
+
+
+void calculate( void )
+{
+   IDLOAD load, *lp;
+   double *px, *py, cf;
+   long n;
+
+   if (( cutoff > 0.0 ) && ( smo_filter( t, cutoff, 0 ) < 0 ))
+     {
+      printf("\nCutoff must be below %4.1lf Hz.",
+                  SMO_PASSES / ( 2.0 * kin_interval( t )));
+      exit( 1 );
+     }
+   lp = NULL;
+   px = py = NULL;
+   if ( force != NULL )
+     {
+      if ( loadjoint > t->numjoints )
+        {
+         printf("\nNo joint %d in the datafile.", loadjoint );
+         exit( 1 );
+        }
+      px = (double *) malloc( (size_t) ( 2 * t->numframes + 1 )
+                              * sizeof(double) );
+      if ( px == NULL )
+        {
+         printf("\nNot enough memory.");
+         exit( 1 );
+        }
+      py = px + t->numframes;
+      cf = t->cfactor;
+      for ( n = 0; n < t->numframes; n++ )
+        {
+         px[n] = TRAJ_X( t, loadjoint - 1 )[n] * cf;
+         py[n] = TRAJ_Y( t, loadjoint - 1 )[n] * cf;
+        }
+      load.fx = SIG_COL( force, 1 );          /* plate fy, horizontal */
+      load.fy = SIG_COL( force, 2 );          /* plate fz, vertical */
+      load.px = px;
+      load.py = py;
+      load.mz = NULL;
+      lp = &load;
+     }
+   if (( r = id_solve( t, seg, numsegs, lp, stencil, 0 )) == NULL )
+     {
+      printf("\nCheck the segment joints and the stencil (3 or 5).");
+      exit( 1 );
+     }
+   free( px );
+}
+
+
+void save_data( void )
+{
+   int s;
+   long n;
+
+   fprintf( fpNEW, "%s\n%d\n%ld\n%01.5lf\n", datafile, numsegs,
+                   t->numframes, kin_interval( t ));
+   for ( n = 0; n < t->numframes; n++ )
+     {
+      fprintf( fpNEW, "%04ld", n );
+      for ( s = 0; s < numsegs; s++ )
+         if ( ID_OK( r, s, n ) )
+            fprintf( fpNEW, " %9.3lf %9.3lf %9.3lf", ID_FX( r, s )[n],
+                     ID_FY( r, s )[n], ID_M( r, s )[n] );
+         else
+            fprintf( fpNEW, " %9.0lf %9.0lf %9.0lf", TRAJ_HIDDEN,
+                     TRAJ_HIDDEN, TRAJ_HIDDEN );
+      fprintf( fpNEW, "\n" );
+     }
+}
+
+
+void all_done( void )
+{
+   fclose( fpNEW );
+   id_free( r );
+   sig_free( force );
+   traj_free( t );
+   printf("\nALL DONE.!\n\n");
+}
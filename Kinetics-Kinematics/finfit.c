@@ -0,0 +1,152 @@
+/* Fin Fit Program.
+   ------------------
+   Program fits torque on fin angle for every fin tested and writes
+   the regression parameters that "regression.c" reads.
+   The fins are listed in "F:\TORQUE.DAT\FINLIST.DAT": the number of
+   fins, then the datafile name (no extension) of each.  Each fin's
+   "*.TOR" (from "torque.c") is read in one streaming pass and fitted
+   by least squares (lsfit.c), the fins in parallel.  Records with a
+   hidden point are left out.
+
+   Program prompts for the degree of polynomial, 1 to 3.  The straight
+   line comes out of the same pass and goes to "FINGRAPH.DAT" as
+
+         fin  end  init  yint  reg
+
+   with init and end covering the angles seen.  The fit at the chosen
+   degree, with standard errors, R^2 and residual standard error, goes
+   to "FINFIT.OUT".  Compile with:
+
+         cl /AL /I..\VideoCapture finfit.c lsfit.c
+            ..\VideoCapture\txtscan.c ..\VideoCapture\traject.c
+            ..\VideoCapture\worker.c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "txtscan.h"
+#include "lsfit.h"
+
+#define MAXANGLE 40         /* angles regression.c can hold */
+
+void open_files( void );
+void calculate( void );
+void save_data( void );
+void all_done( void );
+
+int term, degree, *status;
+char **torfile;
+LSQFIT *fits;
+
+FILE *fpGRAPH, *fpNEW;
+
+main()
+{
+   open_files();
+   calculate();
+   save_data();
+   all_done();
+}
+
+
+void open_files( void )
+{
+   int i;
+   long fins;
+   char name[9], listfile[28];
+   FILE *fpLIST;
+   TXTSCAN *ts;
+
+   strcpy (listfile, "F:\\TORQUE.DAT\\FINLIST.DAT");
+   if ((fpLIST = fopen( listfile, "r")) == NULL )
+     {
+      printf("\nFin list not found.");
+      exit( 1 );
+     }
+   ts = txt_open( fpLIST );
+   txt_long( ts, &fins );
+   term = (int) fins;
+   torfile = (char **) calloc( term + 1, sizeof(char *) );
+   fits = (LSQFIT *) calloc( term + 1, sizeof(LSQFIT) );
+   status = (int *) calloc( term + 1, sizeof(int) );
+   if (( torfile == NULL ) || ( fits == NULL ) || ( status == NULL ))
+     {
+      printf("\nNot enough memory.");
+      exit( 1 );
+     }
+   for ( i = 0; i < term; i++ )
+     {
+      if ( !txt_word( ts, name, sizeof(name) ) )
+        {
+         printf("\nOnly %d fins in the list.", i );
+         term = i;
+         break;
+        }
+      if (( torfile[i] = (char *) malloc( 28 )) == NULL )
+        {
+         printf("\nNot enough memory.");
+         exit( 1 );
+        }
+      strcpy ( torfile[i], "F:\\TORQUE.DAT\\");
+      strcat ( torfile[i], name );
+      strcat ( torfile[i], ".TOR");
+     }
+   txt_close( ts );
+   fclose( fpLIST );
+
+   printf("Degree of polynomial (1 - %d): ", LSQ_MAXDEG );
+   scanf( "%d", &degree );
+   if (( degree < 1 ) || ( degree > LSQ_MAXDEG ))
+      degree = 1;
+   if ((fpGRAPH = fopen( "F:\\TORQUE.DAT\\FINGRAPH.DAT", "w")) == NULL)
+     {
+      printf("\nCannot create new datafile");
+      exit( 1 );
+     }
+   if ((fpNEW = fopen( "F:\\TORQUE.DAT\\FINFIT.OUT", "w")) == NULL)
+     {
+      printf("\nCannot create new datafile");
+      exit( 1 );
+     }
+}
+
+
+void calculate( void )
+{
+   lsq_batch( torfile, term, degree, fits, status, 0 );
+}
+
+
+void save_data( void )
+{
+   int i, good;
+
+   for ( good = 0, i = 0; i < term; i++ )
+      if ( status[i] == 0 )
+         good++;
+   fprintf( fpGRAPH, "%d\n", good );
+   fprintf( fpNEW, "Degree %d\n", degree );
+   for ( i = 0; i < term; i++ )
+      if ( status[i] == 0 )
+         lsq_report( &fits[i], torfile[i], MAXANGLE, fpGRAPH, fpNEW );
+      else
+         printf( "\n%s %s.", torfile[i], ( status[i] == -1 )
+                       ? "not found" : "has too few points to fit" );
+}
+
+
+void all_done( void )
+{
+   int i;
+
+   fclose( fpGRAPH );
+   fclose( fpNEW );
+   for ( i = 0; i < term; i++ )
+      free( torfile[i] );
+   free( torfile );
+   free( fits );
+   free( status );
+   printf("\nALL DONE.!\n\n");
+}
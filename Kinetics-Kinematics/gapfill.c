@@ -0,0 +1,318 @@
+/**************************************************************************
+ *  GAPFILL.C
+ *
+ * Spline filling of hidden points. The following functions are public:
+ *
+ *   gap_fill       -   Fills the short gaps of every joint of a session
+ *   gap_free       -   Releases the list of filled gaps
+ *   gap_report     -   Writes the list of filled gaps as text
+ *
+ * Each joint is a task for the worker pool (worker.c) and keeps its own
+ * list of gaps; the lists are joined in joint order afterwards.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gapfill.h"
+#include "worker.h"
+
+/* Shared arguments of the per joint tasks */
+typedef struct _GAPJOB
+{
+    TRAJECT *t;
+    long     maxgap;
+    int      ends;
+    GAPLIST *list;              /* One list per joint                   */
+} GAPJOB;
+
+/* Prototypes for internal functions */
+static void *gap_alloc( long n, size_t size );
+static void  gap_add( GAPLIST *g, int j, long first, long len );
+static double gap_slope( const double *k, const double *v, long n,
+                         int end );
+static void  gap_spline( const double *k, const double *v, double *m,
+                         double *c, long n, int ends );
+static void  gap_stretch( GAPJOB *job, int j, long first, long last,
+                          double *work );
+static void  gap_joint( void *arg, long j );
+
+
+/* gap_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *gap_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  gap_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* gap_add - Appends a filled gap to a list, growing it as needed.
+ */
+static void gap_add( GAPLIST *g, int j, long first, long len )
+{
+    GAP *p;
+
+    if( (g->count & (g->count - 1)) == 0 )   /* 0, 1, 2, 4 ... full */
+      {
+        p = (GAP *) gap_alloc( g->count ? 2 * g->count : 1, sizeof(GAP) );
+        if( g->count > 0 )
+           memcpy( p, g->gap, (size_t) g->count * sizeof(GAP) );
+        free( g->gap );
+        g->gap = p;
+      }
+    g->gap[g->count].joint = j;
+    g->gap[g->count].first = first;
+    g->gap[g->count].len = len;
+    g->count++;
+    g->filled += len;
+}
+
+
+/* gap_slope - Slope at the first (end = 0) or last (end = 1) of the
+ * "n" knots "k" with values "v": that of the parabola through the
+ * three end knots, or of the line through two if that is all there is.
+ */
+static double gap_slope( const double *k, const double *v, long n, int end )
+{
+    double h0, h1;
+
+    if( n < 3 )
+       return (v[1] - v[0]) / (k[1] - k[0]);
+    if( end == 0 )
+      {
+        h0 = k[1] - k[0];
+        h1 = k[2] - k[1];
+        return -(2.0 * h0 + h1) / (h0 * (h0 + h1)) * v[0]
+               + (h0 + h1) / (h0 * h1) * v[1]
+               - h0 / (h1 * (h0 + h1)) * v[2];
+      }
+    h0 = k[n - 2] - k[n - 3];
+    h1 = k[n - 1] - k[n - 2];
+    return h1 / (h0 * (h0 + h1)) * v[n - 3]
+           - (h0 + h1) / (h0 * h1) * v[n - 2]
+           + (2.0 * h1 + h0) / (h1 * (h0 + h1)) * v[n - 1];
+}
+
+
+/* gap_spline - Second derivatives "m" of the splines through the "n"
+ * knots "k" with values v[i] (x) and v[n + i] (y).  Both right hand
+ * sides go through one sweep of the tridiagonal (Thomas) algorithm;
+ * "c" is n doubles of scratch for the eliminated upper diagonal.
+ */
+static void gap_spline( const double *k, const double *v, double *m,
+                        double *c, long n, int ends )
+{
+    long i;
+    int r;
+    double h0, h1, diag, w;
+
+    h1 = k[1] - k[0];                           /* first row */
+    if( ends == GAP_CLAMPED )
+      {
+        c[0] = 0.5;
+        for( r = 0; r < 2; r++ )
+           m[r * n] = 3.0 / h1 * ((v[r * n + 1] - v[r * n]) / h1
+                                  - gap_slope( k, v + r * n, n, 0 ));
+      }
+    else
+      {
+        c[0] = 0.0;
+        m[0] = m[n] = 0.0;
+      }
+    for( i = 1; i < n - 1; i++ )                /* interior rows */
+      {
+        h0 = k[i] - k[i - 1];
+        h1 = k[i + 1] - k[i];
+        diag = 2.0 * (h0 + h1) - h0 * c[i - 1];
+        c[i] = h1 / diag;
+        for( r = 0; r < 2; r++ )
+          {
+            w = 6.0 * ((v[r * n + i + 1] - v[r * n + i]) / h1
+                       - (v[r * n + i] - v[r * n + i - 1]) / h0);
+            m[r * n + i] = (w - h0 * m[r * n + i - 1]) / diag;
+          }
+      }
+    h0 = k[n - 1] - k[n - 2];                   /* last row */
+    if( ends == GAP_CLAMPED )
+      {
+        diag = 2.0 * h0 - h0 * c[n - 2];
+        for( r = 0; r < 2; r++ )
+          {
+            w = 6.0 * (gap_slope( k, v + r * n, n, 1 )
+                       - (v[r * n + n - 1] - v[r * n + n - 2]) / h0);
+            m[r * n + n - 1] = (w - h0 * m[r * n + n - 2]) / diag;
+          }
+      }
+    else
+       m[n - 1] = m[2 * n - 1] = 0.0;
+    for( i = n - 2; i >= 0; i-- )               /* back substitution */
+       for( r = 0; r < 2; r++ )
+          m[r * n + i] -= c[i] * m[r * n + i + 1];
+}
+
+
+/* gap_stretch - Fits splines through the visible fields "first" to
+ * "last" of joint "j" and fills the hidden fields between them.
+ * "work" holds 6 * numframes doubles.
+ */
+static void gap_stretch( GAPJOB *job, int j, long first, long last,
+                         double *work )
+{
+    TRAJECT *t = job->t;
+    double *k, *v, *m, *c, *x, *y, h, a, b;
+    long n, i, f, start;
+
+    x = TRAJ_X( t, j );
+    y = TRAJ_Y( t, j );
+    k = work;
+    c = k + t->numframes;
+    v = c + t->numframes;
+    for( n = 0, f = first; f <= last; f++ )
+       if( TRAJ_OK( t, j, f ) )
+         {
+           k[n] = (double) f;
+           v[n] = x[f];
+           v[t->numframes + n] = y[f];
+           n++;
+         }
+    if( n < 2 )
+       return;
+    /* y values go straight after the x values */
+    memmove( v + n, v + t->numframes, (size_t) n * sizeof(double) );
+    m = v + 2 * n;
+    gap_spline( k, v, m, c, n, job->ends );
+
+    for( i = 0; i < n - 1; i++ )
+      {
+        if( k[i + 1] - k[i] < 2.0 )
+           continue;
+        start = (long) k[i] + 1;
+        h = k[i + 1] - k[i];
+        for( f = start; f < (long) k[i + 1]; f++ )
+          {
+            a = k[i + 1] - f;
+            b = f - k[i];
+            x[f] = (m[i] * a * a * a + m[i + 1] * b * b * b) / (6.0 * h)
+                   + (v[i] / h - m[i] * h / 6.0) * a
+                   + (v[i + 1] / h - m[i + 1] * h / 6.0) * b;
+            y[f] = (m[n + i] * a * a * a + m[n + i + 1] * b * b * b) / (6.0 * h)
+                   + (v[n + i] / h - m[n + i] * h / 6.0) * a
+                   + (v[n + i + 1] / h - m[n + i + 1] * h / 6.0) * b;
+            traj_point( t, j, f, x[f], y[f] );
+          }
+        gap_add( &job->list[j], j, start, (long) k[i + 1] - start );
+      }
+}
+
+
+/* gap_joint - Task: splits joint "j" at its long gaps and fills the
+ * short ones.
+ */
+static void gap_joint( void *arg, long j )
+{
+    GAPJOB *job = (GAPJOB *) arg;
+    TRAJECT *t = job->t;
+    double *work;
+    long n, first, last, hidden;
+
+    work = (double *) gap_alloc( 6 * t->numframes, sizeof(double) );
+    first = -1;
+    last = -1;
+    hidden = 0;
+    for( n = 0; n < t->numframes; n++ )
+      {
+        if( !TRAJ_OK( t, (int) j, n ) )
+          {
+            hidden++;
+            continue;
+          }
+        if( first >= 0 && hidden > job->maxgap )
+          {                             /* too long, end the stretch */
+            gap_stretch( job, (int) j, first, last, work );
+            first = -1;
+          }
+        if( first < 0 )
+           first = n;
+        last = n;
+        hidden = 0;
+      }
+    if( first >= 0 )
+       gap_stretch( job, (int) j, first, last, work );
+    free( work );
+}
+
+
+/* gap_fill - Fills every gap of up to "maxgap" hidden fields (GAP_MAXLEN
+ * if zero or less) in every joint of "t", with GAP_NATURAL or
+ * GAP_CLAMPED spline ends, using up to "nthreads" threads (0 = one per
+ * processor).
+ *
+ * Return: The list of gaps filled
+ */
+GAPLIST *gap_fill( TRAJECT *t, long maxgap, int ends, int nthreads )
+{
+    GAPJOB job;
+    GAPLIST *g;
+    long total;
+    int j;
+
+    job.t = t;
+    job.maxgap = (maxgap > 0) ? maxgap : GAP_MAXLEN;
+    job.ends = ends;
+    job.list = (GAPLIST *) gap_alloc( (long) t->numjoints, sizeof(GAPLIST) );
+    memset( job.list, 0, (size_t) (t->numjoints > 0 ? t->numjoints : 1)
+                         * sizeof(GAPLIST) );
+
+    work_run( (long) t->numjoints, gap_joint, &job, nthreads );
+
+    g = (GAPLIST *) gap_alloc( 1L, sizeof(GAPLIST) );
+    for( total = 0, j = 0; j < t->numjoints; j++ )
+       total += job.list[j].count;
+    g->count = 0;
+    g->filled = 0;
+    g->gap = (GAP *) gap_alloc( total, sizeof(GAP) );
+    for( j = 0; j < t->numjoints; j++ )
+      {
+        if( job.list[j].count > 0 )
+           memcpy( g->gap + g->count, job.list[j].gap,
+                   (size_t) job.list[j].count * sizeof(GAP) );
+        g->count += job.list[j].count;
+        g->filled += job.list[j].filled;
+        free( job.list[j].gap );
+      }
+    free( job.list );
+    return g;
+}
+
+
+/* gap_free - Releases a list of filled gaps.
+ */
+void gap_free( GAPLIST *g )
+{
+    if( g == NULL )
+       return;
+    free( g->gap );
+    free( g );
+}
+
+
+/* gap_report - Writes the number of gaps and fields filled, then one
+ * line per gap:  joint (from 1)  first field  fields.
+ */
+void gap_report( GAPLIST *g, FILE *fp )
+{
+    long i;
+
+    fprintf( fp, "%ld %ld\n", g->count, g->filled );
+    for( i = 0; i < g->count; i++ )
+       fprintf( fp, "%3d %6ld %4ld\n", g->gap[i].joint + 1,
+                g->gap[i].first, g->gap[i].len );
+}
@@ -0,0 +1,49 @@
+/* GAPFILL.H
+ *
+ * Cubic spline filling of hidden points.  A joint's visible fields are
+ * split into stretches wherever a gap is longer than the longest gap
+ * to be filled; a cubic spline is fitted through the visible fields of
+ * each stretch (field number against x and y) and evaluated at the
+ * hidden fields inside it.  Gaps at the very start or end of a session
+ * have nothing on one side and are left hidden.
+ *
+ * The spline ends are either natural (no curvature) or clamped to the
+ * slope of a parabola through the three visible fields at each end.  x and
+ * y share the same knots, so one tridiagonal factorization serves both
+ * right hand sides.
+ *
+ * Filled points become visible; the list returned says which they are.
+ */
+
+/* Include only once */
+#ifndef GAPFILL_H
+#define GAPFILL_H
+
+#include <stdio.h>
+#include "traject.h"
+
+#define GAP_NATURAL  0          /* Spline ends with no curvature        */
+#define GAP_CLAMPED  1          /* Spline ends follow the end slopes    */
+#define GAP_MAXLEN   10         /* Default longest gap filled, fields   */
+
+/* One run of filled fields */
+typedef struct _GAP
+{
+    int     joint;
+    long    first;              /* First field filled                   */
+    long    len;                /* Fields filled                        */
+} GAP;
+
+typedef struct _GAPLIST
+{
+    long    count;              /* Gaps filled                          */
+    long    filled;             /* Fields filled, all joints            */
+    GAP    *gap;                /* In joint, then field order           */
+} GAPLIST;
+
+/* Public gap filling functions */
+GAPLIST *gap_fill( TRAJECT *t, long maxgap, int ends, int nthreads );
+void     gap_free( GAPLIST *g );
+void     gap_report( GAPLIST *g, FILE *fp );
+
+#endif /* GAPFILL_H */
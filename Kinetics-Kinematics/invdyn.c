@@ -0,0 +1,272 @@
+/**************************************************************************
+ *  INVDYN.C
+ *
+ * Planar inverse dynamics. The following functions are public:
+ *
+ *   id_segments    -   Centre of mass and angle columns of segments
+ *   id_solve       -   Joint forces and moments up a chain of segments
+ *   id_free        -   Releases the results
+ *
+ * Centres of mass and segment angles are put in columns of their own
+ * and differentiated by kin_derive() like any joint.  The chain is
+ * then solved for ID_BLOCK fields at a time, each block a task for the
+ * worker pool (worker.c); within a block every segment is one plain
+ * loop down the columns, with the distal load carried in block sized
+ * columns from one segment to the next.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "invdyn.h"
+#include "kinemat.h"
+#include "angles.h"
+#include "worker.h"
+
+/* Shared arguments of the per block tasks */
+typedef struct _IDJOB
+{
+    TRAJECT       *pos;
+    const SEGMENT *seg;
+    const IDLOAD  *load;        /* NULL for no external load            */
+    TRAJECT       *com;         /* Centres of mass, meters              */
+    TRAJECT       *comacc;      /* Their accelerations                  */
+    TRAJECT       *angacc;      /* Angular accelerations, in x columns  */
+    IDRESULT      *r;
+} IDJOB;
+
+/* Prototypes for internal functions */
+static void    *id_alloc( long n, size_t size );
+static void     id_block( void *arg, long b );
+
+
+/* id_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *id_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  id_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* id_segments - Centre of mass (meters) and angle (radians, unwrapped,
+ * in the x columns) of every segment of "seg", one joint of each new
+ * store per segment, with masks from the joints they come from.
+ *
+ * Return: The centres of mass; the angles through "ang"
+ */
+TRAJECT *id_segments( TRAJECT *pos, const SEGMENT *seg, int numsegs,
+                      int nthreads, TRAJECT **ang )
+{
+    TRAJECT *com, *a;
+    ANGSPEC *spec;
+    ANGLES *g;
+    double *xp, *yp, *xd, *yd, *cx, *cy, c, cf;
+    long n, b, bytes;
+    int s;
+
+    com = traj_create( numsegs, pos->numframes );
+    a = traj_create( numsegs, pos->numframes );
+    com->skip = a->skip = pos->skip;
+    com->cfactor = a->cfactor = 1.0;
+    while( com->numframes < pos->numframes )
+      {
+        traj_append( com );
+        traj_append( a );
+      }
+    bytes = (pos->numframes + 7) >> 3;
+    cf = pos->cfactor;
+
+    spec = (ANGSPEC *) id_alloc( (long) numsegs, sizeof(ANGSPEC) );
+    for( s = 0; s < numsegs; s++ )
+      {
+        spec[s].kind = ANG_SEGMENT;
+        spec[s].a = seg[s].proximal;
+        spec[s].b = seg[s].distal;
+        spec[s].c = spec[s].d = 0;
+
+        xp = TRAJ_X( pos, seg[s].proximal );
+        yp = TRAJ_Y( pos, seg[s].proximal );
+        xd = TRAJ_X( pos, seg[s].distal );
+        yd = TRAJ_Y( pos, seg[s].distal );
+        cx = TRAJ_X( com, s );
+        cy = TRAJ_Y( com, s );
+        c = seg[s].com;
+        for( n = 0; n < pos->numframes; n++ )
+          {
+            cx[n] = (xp[n] + c * (xd[n] - xp[n])) * cf;
+            cy[n] = (yp[n] + c * (yd[n] - yp[n])) * cf;
+          }
+        for( b = 0; b < bytes; b++ )
+           TRAJ_MASK( com, s )[b] = (unsigned char)
+                   (TRAJ_MASK( pos, seg[s].proximal )[b]
+                    & TRAJ_MASK( pos, seg[s].distal )[b]);
+      }
+
+    g = ang_compute( pos, spec, numsegs, 1, nthreads );
+    for( s = 0; s < numsegs; s++ )
+      {
+        memcpy( TRAJ_X( a, s ), ANG_COL( g, s ),
+                (size_t) pos->numframes * sizeof(double) );
+        memcpy( TRAJ_MASK( a, s ), ANG_MASK( g, s ), (size_t) bytes );
+      }
+    ang_free( g );
+    free( spec );
+    *ang = a;
+    return com;
+}
+
+
+/* id_block - Task: the whole chain for fields b * ID_BLOCK on.
+ */
+static void id_block( void *arg, long b )
+{
+    IDJOB *job = (IDJOB *) arg;
+    const SEGMENT *sg;
+    const IDLOAD *ld = job->load;
+    IDRESULT *r = job->r;
+    double *fdx, *fdy, *md, *rdx, *rdy, *xp, *yp, *cx, *cy, *ax, *ay, *al,
+           *ofx, *ofy, *om, cf, fpx, fpy, mp, w;
+    unsigned char *m;
+    long n0, len, i, n;
+    int s;
+
+    n0 = b * ID_BLOCK;
+    len = r->numframes - n0;
+    if( len > ID_BLOCK )
+       len = ID_BLOCK;
+    cf = job->pos->cfactor;
+    fdx = (double *) id_alloc( 5L * ID_BLOCK, sizeof(double) );
+    fdy = fdx + ID_BLOCK;
+    md = fdy + ID_BLOCK;
+    rdx = md + ID_BLOCK;
+    rdy = rdx + ID_BLOCK;
+
+    for( i = 0; i < len; i++ )          /* the external load */
+      {
+        n = n0 + i;
+        fdx[i] = (ld != NULL && ld->fx != NULL) ? ld->fx[n] : 0.0;
+        fdy[i] = (ld != NULL && ld->fy != NULL) ? ld->fy[n] : 0.0;
+        md[i] = (ld != NULL && ld->mz != NULL) ? ld->mz[n] : 0.0;
+        rdx[i] = (ld != NULL && ld->px != NULL) ? ld->px[n] : 0.0;
+        rdy[i] = (ld != NULL && ld->py != NULL) ? ld->py[n] : 0.0;
+      }
+
+    for( s = 0; s < r->numsegs; s++ )   /* up the chain */
+      {
+        sg = job->seg + s;
+        xp = TRAJ_X( job->pos, sg->proximal ) + n0;
+        yp = TRAJ_Y( job->pos, sg->proximal ) + n0;
+        cx = TRAJ_X( job->com, s ) + n0;
+        cy = TRAJ_Y( job->com, s ) + n0;
+        ax = TRAJ_X( job->comacc, s ) + n0;
+        ay = TRAJ_Y( job->comacc, s ) + n0;
+        al = TRAJ_X( job->angacc, s ) + n0;
+        ofx = ID_FX( r, s ) + n0;
+        ofy = ID_FY( r, s ) + n0;
+        om = ID_M( r, s ) + n0;
+        m = ID_MASK( r, s );
+        for( i = 0; i < len; i++ )
+          {
+            fpx = sg->mass * ax[i] - fdx[i];
+            fpy = sg->mass * ay[i] - fdy[i] + sg->mass * ID_GRAVITY;
+            mp = sg->inertia * al[i] - md[i]
+                 - ((xp[i] * cf - cx[i]) * fpy - (yp[i] * cf - cy[i]) * fpx)
+                 - ((rdx[i] - cx[i]) * fdy[i] - (rdy[i] - cy[i]) * fdx[i]);
+            w = (double) ((m[(n0 + i) >> 3] >> ((n0 + i) & 7)) & 1);
+            ofx[i] = fpx * w;
+            ofy[i] = fpy * w;
+            om[i] = mp * w;
+            fdx[i] = -fpx;              /* reaction on the next one up */
+            fdy[i] = -fpy;
+            md[i] = -mp;
+            rdx[i] = xp[i] * cf;
+            rdy[i] = yp[i] * cf;
+          }
+      }
+    free( fdx );
+}
+
+
+/* id_solve - Solves the chain of "numsegs" segments "seg" for every
+ * field of "pos", with "load" on segment 0 (NULL for none), using
+ * the given kinemat.c stencil and up to "nthreads" threads (0 = one
+ * per processor).
+ *
+ * Return: The joint forces and moments, or NULL if a segment names a
+ *         joint "pos" doesn't have or the stencil is unknown
+ */
+IDRESULT *id_solve( TRAJECT *pos, const SEGMENT *seg, int numsegs,
+                    const IDLOAD *load, int stencil, int nthreads )
+{
+    IDJOB job;
+    IDRESULT *r;
+    TRAJECT *com, *ang;
+    unsigned char *m;
+    long b, bytes;
+    int s;
+
+    if( stencil != KIN_CENTRAL3 && stencil != KIN_CENTRAL5 )
+       return NULL;
+    for( s = 0; s < numsegs; s++ )
+       if( seg[s].distal < 0 || seg[s].distal >= pos->numjoints
+           || seg[s].proximal < 0 || seg[s].proximal >= pos->numjoints )
+          return NULL;
+
+    r = (IDRESULT *) id_alloc( 1L, sizeof(IDRESULT) );
+    r->numsegs = numsegs;
+    r->numframes = pos->numframes;
+    r->capacity = (pos->numframes + 7) / 8 * 8;
+    if( r->capacity == 0 )
+       r->capacity = 8;
+    r->base = (double *) id_alloc( 3L * numsegs * r->capacity,
+                                   sizeof(double) );
+    r->valid = (unsigned char *) id_alloc( numsegs * (r->capacity >> 3), 1 );
+
+    com = id_segments( pos, seg, numsegs, nthreads, &ang );
+    job.pos = pos;
+    job.seg = seg;
+    job.load = load;
+    job.com = com;
+    job.r = r;
+    kin_derive( com, stencil, nthreads, NULL, &job.comacc );
+    kin_derive( ang, stencil, nthreads, NULL, &job.angacc );
+
+    bytes = r->capacity >> 3;           /* valid up the chain so far */
+    for( s = 0; s < numsegs; s++ )
+      {
+        m = ID_MASK( r, s );
+        for( b = 0; b < bytes; b++ )
+           m[b] = (unsigned char) ((s > 0 ? ID_MASK( r, s - 1 )[b] : 0xFF)
+                                   & TRAJ_MASK( job.comacc, s )[b]
+                                   & TRAJ_MASK( job.angacc, s )[b]);
+      }
+
+    work_run( (r->numframes + ID_BLOCK - 1) / ID_BLOCK, id_block, &job,
+              nthreads );
+
+    traj_free( com );
+    traj_free( ang );
+    traj_free( job.comacc );
+    traj_free( job.angacc );
+    return r;
+}
+
+
+/* id_free - Releases inverse dynamics results.
+ */
+void id_free( IDRESULT *r )
+{
+    if( r == NULL )
+       return;
+    free( r->base );
+    free( r->valid );
+    free( r );
+}
@@ -0,0 +1,75 @@
+/* INVDYN.H
+ *
+ * Planar inverse dynamics over a chain of segments, e.g. fin, shank,
+ * thigh.  Segment 0 is the most distal and carries the external load
+ * (the force plate reading, applied at a point); each later segment's
+ * distal joint is the one before's proximal joint.  Working up the
+ * chain, Newton-Euler gives the force and moment each segment's
+ * proximal joint must supply:
+ *
+ *      Fp = m a - Fd + m g
+ *      Mp = I alpha - Md - (rp - rc) x Fp - (rd - rc) x Fd
+ *
+ * where a and alpha come from differentiating the segment's centre of
+ * mass and angle (kinemat.c), Fd and Md act at its distal end and are
+ * the reverse of those found for the segment below, and rc is the
+ * centre of mass.  Forces are in N, moments in N m, counter clockwise
+ * positive.
+ *
+ * Positions are taken as pos * pos->cfactor meters with y up; smooth
+ * them first (smooth.c).  A result is valid only where the
+ * derivatives of its segment and every segment below it are.
+ */
+
+/* Include only once */
+#ifndef INVDYN_H
+#define INVDYN_H
+
+#include "traject.h"
+
+#define ID_GRAVITY  9.81        /* m/s^2, acting in -y                  */
+#define ID_BLOCK    512         /* Fields per task                      */
+
+/* One link of the chain */
+typedef struct _SEGMENT
+{
+    int     distal;             /* Joint at the distal end              */
+    int     proximal;           /* Joint at the proximal end            */
+    double  mass;               /* kg                                   */
+    double  com;                /* Centre of mass from the proximal end,
+                                   as a fraction of the length          */
+    double  inertia;            /* About the centre of mass, kg m^2     */
+} SEGMENT;
+
+/* External load on segment 0, one value per field (NULL for none) */
+typedef struct _IDLOAD
+{
+    const double *fx, *fy;      /* Force, N                             */
+    const double *px, *py;      /* Where it acts, meters                */
+    const double *mz;           /* Free moment, N m, or NULL            */
+} IDLOAD;
+
+/* Proximal joint force and moment of each segment, every field */
+typedef struct _IDRESULT
+{
+    int     numsegs;
+    long    numframes;
+    long    capacity;           /* Fields in each column                */
+    double *base;               /* fx, fy, m columns of each segment    */
+    unsigned char *valid;       /* capacity / 8 mask bytes per segment  */
+} IDRESULT;
+
+#define ID_FX( r, s )     ((r)->base + (3L * (s)) * (r)->capacity)
+#define ID_FY( r, s )     ((r)->base + (3L * (s) + 1L) * (r)->capacity)
+#define ID_M( r, s )      ((r)->base + (3L * (s) + 2L) * (r)->capacity)
+#define ID_MASK( r, s )   ((r)->valid + (long) (s) * ((r)->capacity >> 3))
+#define ID_OK( r, s, n )  ((ID_MASK( r, s )[(n) >> 3] >> ((n) & 7)) & 1)
+
+/* Public inverse dynamics functions */
+TRAJECT  *id_segments( TRAJECT *pos, const SEGMENT *seg, int numsegs,
+                       int nthreads, TRAJECT **ang );
+IDRESULT *id_solve( TRAJECT *pos, const SEGMENT *seg, int numsegs,
+                    const IDLOAD *load, int stencil, int nthreads );
+void      id_free( IDRESULT *r );
+
+#endif /* INVDYN_H */
@@ -0,0 +1,195 @@
+/**************************************************************************
+ *  KINEMAT.C
+ *
+ * Velocity and acceleration of digitized joints. The following
+ * functions are public:
+ *
+ *   kin_interval   -   Seconds between the fields of a session
+ *   kin_derive     -   Differentiates every joint column of a session
+ *
+ * Each joint is one task for the worker pool (worker.c).  The inner
+ * loops run straight down contiguous, aligned columns with no branches,
+ * so the compiler can vectorize them across fields; hidden points are
+ * masked afterwards by multiplying by 0.0 / 1.0 weights.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "kinemat.h"
+#include "worker.h"
+
+/* Shared arguments of the per joint tasks */
+typedef struct _KINJOB
+{
+    TRAJECT *pos, *vel, *acc;
+    int     half;               /* Fields each side of the centre       */
+    double  dt;
+} KINJOB;
+
+/* Prototypes for internal functions */
+static TRAJECT *kin_like( TRAJECT *pos );
+static void     kin_column( const double *x, double *v, double *a,
+                            long numframes, int half, double dt );
+static void     kin_mask( TRAJECT *t, int j, const double *w );
+static void     kin_joint( void *arg, long j );
+
+
+/* kin_like - Creates a store with the shape of "pos", every field
+ * present and zero.
+ */
+static TRAJECT *kin_like( TRAJECT *pos )
+{
+    TRAJECT *t;
+
+    t = traj_create( pos->numjoints, pos->numframes );
+    t->skip = pos->skip;
+    t->cfactor = pos->cfactor;
+    while( t->numframes < pos->numframes )
+       traj_append( t );
+    return t;
+}
+
+
+/* kin_column - Differentiates one column "x" into "v" and "a" (either
+ * may be NULL) for the fields with a full stencil; the rest are left
+ * alone.
+ */
+static void kin_column( const double *x, double *v, double *a,
+                        long numframes, int half, double dt )
+{
+    long n, last;
+    double s1, s2;
+
+    last = numframes - half;
+    if( half == 2 )
+      {
+        s1 = 1.0 / (12.0 * dt);
+        s2 = 1.0 / (12.0 * dt * dt);
+        if( v != NULL )
+           for( n = 2; n < last; n++ )
+              v[n] = (x[n - 2] - 8.0 * x[n - 1]
+                      + 8.0 * x[n + 1] - x[n + 2]) * s1;
+        if( a != NULL )
+           for( n = 2; n < last; n++ )
+              a[n] = (-x[n - 2] + 16.0 * x[n - 1] - 30.0 * x[n]
+                      + 16.0 * x[n + 1] - x[n + 2]) * s2;
+      }
+    else
+      {
+        s1 = 1.0 / (2.0 * dt);
+        s2 = 1.0 / (dt * dt);
+        if( v != NULL )
+           for( n = 1; n < last; n++ )
+              v[n] = (x[n + 1] - x[n - 1]) * s1;
+        if( a != NULL )
+           for( n = 1; n < last; n++ )
+              a[n] = (x[n + 1] - 2.0 * x[n] + x[n - 1]) * s2;
+      }
+}
+
+
+/* kin_mask - Zeroes joint "j" of "t" wherever "w" is 0.0 and clears
+ * the matching mask bits.
+ */
+static void kin_mask( TRAJECT *t, int j, const double *w )
+{
+    double *x, *y;
+    unsigned char *m;
+    long n;
+
+    x = TRAJ_X( t, j );
+    y = TRAJ_Y( t, j );
+    m = TRAJ_MASK( t, j );
+    for( n = 0; n < t->numframes; n++ )
+      {
+        x[n] *= w[n];
+        y[n] *= w[n];
+        m[n >> 3] &= (unsigned char) ~((1 - (int) w[n]) << (n & 7));
+      }
+}
+
+
+/* kin_joint - Task: velocity and acceleration of joint "j".
+ */
+static void kin_joint( void *arg, long j )
+{
+    KINJOB *job = (KINJOB *) arg;
+    TRAJECT *pos = job->pos;
+    double *w, *wo;
+    long n, numframes;
+    int k;
+
+    numframes = pos->numframes;
+    w = (double *) malloc( (size_t) (2 * numframes + 1) * sizeof(double) );
+    if( w == NULL )
+      {
+        printf( "Error:  kin_joint()  malloc failed.\n" );
+        exit( 1 );
+      }
+    wo = w + numframes;
+
+                /* A result needs its whole stencil visible */
+    traj_weights( pos, (int) j, 0L, numframes, w );
+    for( n = 0; n < numframes; n++ )
+       wo[n] = 0.0;
+    for( n = job->half; n < numframes - job->half; n++ )
+      {
+        wo[n] = 1.0;
+        for( k = -job->half; k <= job->half; k++ )
+           wo[n] *= w[n + k];
+      }
+
+    kin_column( TRAJ_X( pos, j ),
+                job->vel ? TRAJ_X( job->vel, j ) : NULL,
+                job->acc ? TRAJ_X( job->acc, j ) : NULL,
+                numframes, job->half, job->dt );
+    kin_column( TRAJ_Y( pos, j ),
+                job->vel ? TRAJ_Y( job->vel, j ) : NULL,
+                job->acc ? TRAJ_Y( job->acc, j ) : NULL,
+                numframes, job->half, job->dt );
+    if( job->vel != NULL )
+       kin_mask( job->vel, (int) j, wo );
+    if( job->acc != NULL )
+       kin_mask( job->acc, (int) j, wo );
+    free( w );
+}
+
+
+/* kin_interval - Time between two stored fields of "t".
+ *
+ * Return: Seconds per field, (skip + 1) / KIN_FIELDRATE
+ */
+double kin_interval( TRAJECT *t )
+{
+    return (t->skip + 1) / KIN_FIELDRATE;
+}
+
+
+/* kin_derive - Differentiates every joint of "pos" with the given
+ * stencil (KIN_CENTRAL3 or KIN_CENTRAL5), using up to "nthreads"
+ * threads (0 = one per processor).  New stores are returned through
+ * "vel" and "acc"; pass NULL for either one that is not wanted.
+ *
+ * Return: 0 on success, -1 for an unknown stencil
+ */
+int kin_derive( TRAJECT *pos, int stencil, int nthreads,
+                TRAJECT **vel, TRAJECT **acc )
+{
+    KINJOB job;
+
+    if( stencil != KIN_CENTRAL3 && stencil != KIN_CENTRAL5 )
+       return -1;
+    job.pos = pos;
+    job.half = stencil / 2;
+    job.dt = kin_interval( pos );
+    job.vel = (vel != NULL) ? kin_like( pos ) : NULL;
+    job.acc = (acc != NULL) ? kin_like( pos ) : NULL;
+
+    work_run( (long) pos->numjoints, kin_joint, &job, nthreads );
+
+    if( vel != NULL )
+       *vel = job.vel;
+    if( acc != NULL )
+       *acc = job.acc;
+    return 0;
+}
@@ -0,0 +1,30 @@
+/* KINEMAT.H
+ *
+ * Finite difference velocity and acceleration for every joint of a
+ * session.  Positions come from a TRAJECT and the results go into two
+ * more of the same shape, so x velocity of joint j is TRAJ_X( vel, j )
+ * and so on, in position units per second (per second squared).
+ *
+ * The field interval is (skip + 1) / KIN_FIELDRATE seconds, from the
+ * skip stored with the session.  A derivative is valid only where
+ * every field of its stencil is; elsewhere, and within half a stencil
+ * of either end of the session, its mask bit is clear and it is zero.
+ */
+
+/* Include only once */
+#ifndef KINEMAT_H
+#define KINEMAT_H
+
+#include "traject.h"
+
+#define KIN_FIELDRATE  60.0     /* Video fields per second              */
+
+#define KIN_CENTRAL3   3        /* 3 point central difference, O(h^2)   */
+#define KIN_CENTRAL5   5        /* 5 point central difference, O(h^4)   */
+
+/* Public kinematics functions */
+double kin_interval( TRAJECT *t );
+int    kin_derive( TRAJECT *pos, int stencil, int nthreads,
+                   TRAJECT **vel, TRAJECT **acc );
+
+#endif /* KINEMAT_H */
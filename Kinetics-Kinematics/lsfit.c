@@ -0,0 +1,258 @@
+/**************************************************************************
+ *  LSFIT.C
+ *
+ * Streaming least squares. The following functions are public:
+ *
+ *   lsq_init       -   Starts an empty fit
+ *   lsq_add        -   Folds one point into a fit
+ *   lsq_solve      -   Coefficients and statistics of a fit
+ *   lsq_eval       -   Value of a solved fit at x
+ *   lsq_tor        -   Fits the torque on angle of one .TOR file
+ *   lsq_batch      -   Fits many .TOR files over the worker pool
+ *   lsq_report     -   Writes a fit for regression.c and as statistics
+ *
+ * The method is described in LSFIT.H.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "lsfit.h"
+#include "txtscan.h"
+#include "traject.h"
+#include "worker.h"
+
+#define LSQ_TORCOLS  6          /* fin fy fz gamma rel_gamma torque     */
+
+/* Shared arguments of the per file tasks */
+typedef struct _LSQJOB
+{
+    char  **paths;
+    int     degree;
+    LSQFIT *fits;
+    int    *status;
+} LSQJOB;
+
+/* Prototypes for internal functions */
+static void lsq_task( void *arg, long i );
+
+
+/* lsq_init - Starts an empty fit of polynomial "degree" (clipped to
+ * 0 .. LSQ_MAXDEG).
+ */
+void lsq_init( LSQFIT *f, int degree )
+{
+    memset( f, 0, sizeof(LSQFIT) );
+    f->degree = (degree < 0) ? 0 : (degree > LSQ_MAXDEG) ? LSQ_MAXDEG
+                                                          : degree;
+    f->xmin = HUGE_VAL;
+    f->xmax = -HUGE_VAL;
+}
+
+
+/* lsq_add - Folds the point (x, y) into the fit.
+ */
+void lsq_add( LSQFIT *f, double x, double y )
+{
+    double a[LSQ_MAXTERMS], c, s, h, t, e, d;
+    int p, j, k;
+
+    p = f->degree + 1;
+    a[0] = 1.0;
+    for( j = 1; j < p; j++ )
+       a[j] = a[j - 1] * x;
+
+    e = y;
+    for( k = 0; k < p; k++ )            /* rotate the row into R */
+      {
+        if( a[k] == 0.0 )
+           continue;
+        h = sqrt( f->r[k][k] * f->r[k][k] + a[k] * a[k] );
+        c = f->r[k][k] / h;
+        s = a[k] / h;
+        f->r[k][k] = h;
+        for( j = k + 1; j < p; j++ )
+          {
+            t = f->r[k][j];
+            f->r[k][j] = c * t + s * a[j];
+            a[j] = c * a[j] - s * t;
+          }
+        t = f->z[k];
+        f->z[k] = c * t + s * e;
+        e = c * e - s * t;
+      }
+    f->sse += e * e;                    /* what R can't reach */
+
+    f->n++;                             /* Welford, for R^2 */
+    d = y - f->ymean;
+    f->ymean += d / f->n;
+    f->yss += d * (y - f->ymean);
+    if( x < f->xmin )
+       f->xmin = x;
+    if( x > f->xmax )
+       f->xmax = x;
+}
+
+
+/* lsq_solve - Solves the fit for a polynomial of "degree" (no more
+ * than it was started with), filling in coef, se, r2 and rse.
+ *
+ * Return: 0 on success, -1 if there are too few distinct points
+ */
+int lsq_solve( LSQFIT *f, int degree )
+{
+    double inv[LSQ_MAXTERMS][LSQ_MAXTERMS], sse, s2, sum;
+    int p, i, j, k;
+
+    if( degree > f->degree )
+       degree = f->degree;
+    p = degree + 1;
+    if( f->n < p )
+       return -1;
+    for( k = 0; k < p; k++ )
+       if( fabs( f->r[k][k] ) <= 1e-12 * fabs( f->r[0][0] ) )
+          return -1;
+
+    for( i = p - 1; i >= 0; i-- )       /* R coef = z */
+      {
+        sum = f->z[i];
+        for( j = i + 1; j < p; j++ )
+           sum -= f->r[i][j] * f->coef[j];
+        f->coef[i] = sum / f->r[i][i];
+      }
+    for( i = p; i < LSQ_MAXTERMS; i++ )
+       f->coef[i] = 0.0;
+
+    sse = f->sse;                       /* higher terms left out */
+    for( k = p; k <= f->degree; k++ )
+       sse += f->z[k] * f->z[k];
+    s2 = (f->n > p) ? sse / (f->n - p) : 0.0;
+
+    for( k = 0; k < p; k++ )            /* R inverse, for the errors */
+      {
+        for( i = 0; i < p; i++ )
+           inv[i][k] = 0.0;
+        inv[k][k] = 1.0 / f->r[k][k];
+        for( i = k - 1; i >= 0; i-- )
+          {
+            for( sum = 0.0, j = i + 1; j <= k; j++ )
+               sum += f->r[i][j] * inv[j][k];
+            inv[i][k] = -sum / f->r[i][i];
+          }
+      }
+    for( i = 0; i < p; i++ )
+      {
+        for( sum = 0.0, j = i; j < p; j++ )
+           sum += inv[i][j] * inv[i][j];
+        f->se[i] = sqrt( s2 * sum );
+      }
+
+    f->terms = p;
+    f->r2 = (f->yss > 0.0) ? 1.0 - sse / f->yss : 1.0;
+    f->rse = sqrt( s2 );
+    return 0;
+}
+
+
+/* lsq_eval - The solved polynomial at "x".
+ *
+ * Return: coef[0] + coef[1] x + ...
+ */
+double lsq_eval( const LSQFIT *f, double x )
+{
+    double y = 0.0;
+    int k;
+
+    for( k = f->terms - 1; k >= 0; k-- )
+       y = y * x + f->coef[k];
+    return y;
+}
+
+
+/* lsq_tor - Fits torque on rel_gamma from the "*.TOR" file at "path"
+ * with a polynomial of "degree", leaving out records with a hidden
+ * point, and solves it at that degree.
+ *
+ * Return: 0 on success, -1 if the file can't be opened, -2 if there
+ *         are too few points to fit
+ */
+int lsq_tor( const char *path, int degree, LSQFIT *f )
+{
+    FILE *fp;
+    TXTSCAN *ts;
+    double rec[LSQ_TORCOLS];
+
+    lsq_init( f, degree );
+    if( (fp = fopen( path, "r" )) == NULL )
+       return -1;
+    ts = txt_open( fp );
+    while( txt_doubles( ts, rec, (long) LSQ_TORCOLS ) == LSQ_TORCOLS )
+      {
+        f->fin = (int) rec[0];
+        if( rec[4] != TRAJ_HIDDEN )
+           lsq_add( f, rec[4], rec[5] );
+      }
+    txt_close( ts );
+    fclose( fp );
+    return (lsq_solve( f, degree ) == 0) ? 0 : -2;
+}
+
+
+/* lsq_task - Task: file "i" of the batch.
+ */
+static void lsq_task( void *arg, long i )
+{
+    LSQJOB *job = (LSQJOB *) arg;
+
+    job->status[i] = lsq_tor( job->paths[i], job->degree, job->fits + i );
+}
+
+
+/* lsq_batch - Fits each of the "nfiles" .TOR files "paths" into
+ * fits[i] (see lsq_tor(), whose return goes in status[i]), using up
+ * to "nthreads" threads (0 = one per processor).
+ */
+void lsq_batch( char **paths, int nfiles, int degree, LSQFIT *fits,
+                int *status, int nthreads )
+{
+    LSQJOB job;
+
+    job.paths = paths;
+    job.degree = degree;
+    job.fits = fits;
+    job.status = status;
+    work_run( (long) nfiles, lsq_task, &job, nthreads );
+}
+
+
+/* lsq_report - Writes the straight line of the solved fit "f" to
+ * "graph" as one FINGRAPH.DAT line for regression.c,
+ *
+ *      fin  end  init  yint  reg
+ *
+ * with init the largest whole angle seen and end the angles from there
+ * down to the smallest, no more than "maxangle"; and the fit at its
+ * solved degree, with standard errors, R^2 and residual standard
+ * error, to "stats" under "name".
+ */
+void lsq_report( const LSQFIT *f, const char *name, int maxangle,
+                 FILE *graph, FILE *stats )
+{
+    LSQFIT line;
+    int k, init, end;
+
+    line = *f;                          /* the leading part of R */
+    lsq_solve( &line, 1 );
+    init = (int) floor( f->xmax + 0.5 );
+    end = init - (int) floor( f->xmin + 0.5 ) + 1;
+    if( end > maxangle )
+       end = maxangle;
+    fprintf( graph, "%d %d %d %10.4lf %10.4lf\n", f->fin, end, init,
+             line.coef[0], line.coef[1] );
+
+    fprintf( stats, "\n%s  fin %d  points %ld  R^2 %6.4lf  RSE %8.4lf\n",
+             name, f->fin, f->n, f->r2, f->rse );
+    for( k = 0; k < f->terms; k++ )
+       fprintf( stats, "   x^%d %12.6lf  (se %10.6lf)\n", k, f->coef[k],
+                f->se[k] );
+}
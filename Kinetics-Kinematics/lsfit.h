@@ -0,0 +1,60 @@
+/* LSFIT.H
+ *
+ * Streaming least squares fits of y on a polynomial in x (torque on
+ * fin angle).  Points are added one at a time and never stored: each
+ * row (1, x, x^2 ...) is folded into an upper triangular R by Givens
+ * rotations, so the fit is a QR factorization built as the data goes
+ * by and never forms the badly conditioned normal equations.  The
+ * part of y the rotations leave over adds straight into the residual
+ * sum of squares, and y's mean and spread are kept by Welford's
+ * method for R^2.
+ *
+ * Because R is built column by column, the leading terms of a fit
+ * are themselves the fit of lower degree: one pass gives the straight
+ * line and the higher polynomial together.
+ *
+ * lsq_tor() fits the rel_gamma and torque columns of a "*.TOR" file
+ * from torque.c; lsq_batch() fits many files, one to a thread.
+ * lsq_report() writes a fit as regression.c reads it (FINGRAPH.DAT).
+ */
+
+/* Include only once */
+#ifndef LSFIT_H
+#define LSFIT_H
+
+#include <stdio.h>
+
+#define LSQ_MAXDEG    3         /* Highest degree of polynomial         */
+#define LSQ_MAXTERMS  (LSQ_MAXDEG + 1)
+
+typedef struct _LSQFIT
+{
+    int     degree;             /* Degree accumulated                   */
+    long    n;                  /* Points added                         */
+    double  r[LSQ_MAXTERMS][LSQ_MAXTERMS];  /* Upper triangular R       */
+    double  z[LSQ_MAXTERMS];    /* Q'y                                  */
+    double  sse;                /* Residual sum of squares, full degree */
+    double  ymean, yss;         /* Welford mean and sum of squares of y */
+    double  xmin, xmax;         /* Range of x                           */
+
+    /* Filled in by lsq_solve() */
+    int     terms;              /* Coefficients solved for              */
+    double  coef[LSQ_MAXTERMS]; /* y = coef[0] + coef[1] x + ...        */
+    double  se[LSQ_MAXTERMS];   /* Their standard errors                */
+    double  r2;                 /* Coefficient of determination         */
+    double  rse;                /* Residual standard error              */
+    int     fin;                /* Fin number, from lsq_tor()           */
+} LSQFIT;
+
+/* Public least squares functions */
+void   lsq_init( LSQFIT *f, int degree );
+void   lsq_add( LSQFIT *f, double x, double y );
+int    lsq_solve( LSQFIT *f, int degree );
+double lsq_eval( const LSQFIT *f, double x );
+int    lsq_tor( const char *path, int degree, LSQFIT *f );
+void   lsq_batch( char **paths, int nfiles, int degree, LSQFIT *fits,
+                  int *status, int nthreads );
+void   lsq_report( const LSQFIT *f, const char *name, int maxangle,
+                   FILE *graph, FILE *stats );
+
+#endif /* LSFIT_H */
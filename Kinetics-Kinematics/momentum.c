@@ -0,0 +1,300 @@
+/* Momentum Program.
+   ------------------
+   Program prompts for the datafile names of one or more trials of a
+   subject and the subject's body mass, and writes the whole body
+   centre of mass, its velocity and the angular momentum about it, for
+   every field of each trial, to that trial's "*.MOM" (body.c).  The
+   trials are worked out together, one to a processor.
+
+   Segments are found by joint name: the names come from the
+   digitizer's binary "*.TRJ", or are asked for when only the "*.DAT"
+   text is there.  The anthropometric table is read from "*.ANT" if
+   there is one, a line per segment:
+
+         distal joint name  proximal joint name  mass  com  gyration
+
+   (fractions of body mass and of segment length); otherwise Winter's
+   table for hand, forearm, upper arm, foot, leg, thigh and head, arms
+   and trunk is used, with joints named finger, wrist, elbow,
+   shoulder, toe, ankle, knee and hip.  The joint names, the table and
+   the segment lengths are the first trial's; every other trial must
+   have the same joints.  Image y runs down, so it is turned over
+   before use.  A value that can't be computed is written
+   as 999.
+
+   "*.MOM" holds the datafile name, segments found, fields and seconds
+   per field, then one line per field:  field  x y  vx vy  H.
+
+   Compile with:
+
+         cl /AL /I..\VideoCapture momentum.c body.c invdyn.c angles.c
+            kinemat.c smooth.c ..\VideoCapture\traject.c
+            ..\VideoCapture\trjfile.c ..\VideoCapture\filemap.c
+            ..\VideoCapture\txtscan.c ..\VideoCapture\worker.c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traject.h"
+#include "trjfile.h"
+#include "txtscan.h"
+#include "kinemat.h"
+#include "smooth.h"
+#include "body.h"
+
+#define MAXPARMS 32
+#define MAXTRIALS 16
+
+void open_files( void );
+void open_trial( int i );
+void open_table( void );
+void calculate( void );
+void save_data( void );
+void all_done( void );
+
+char datafile[MAXTRIALS][9], *names;
+int ntrials, ntab, numsegs, stencil;
+double bodymass, cutoff;
+
+BODYPARM tab[MAXPARMS];
+SEGMENT seg[MAXPARMS];
+TRAJECT *t[MAXTRIALS];
+BODY *b[MAXTRIALS];
+
+FILE *fpNEW[MAXTRIALS];
+
+main()
+{
+   open_files();
+   open_table();
+   calculate();
+   save_data();
+   all_done();
+}
+
+
+void open_files( void )
+{
+   int i, length;
+   char newdatafile[28];
+
+   printf("Enter the number of trials (1 to %d): ", MAXTRIALS );
+   scanf( "%d", &ntrials );
+   if (( ntrials < 1 ) || ( ntrials > MAXTRIALS ))
+     {
+      printf("\nFrom 1 to %d trials.", MAXTRIALS );
+      exit( 1 );
+     }
+   for ( i = 0; i < ntrials; i++ )
+      open_trial( i );
+   printf("\nBody mass in kg: ");
+   scanf( "%lf", &bodymass );
+   printf("\nSmoothing cutoff in Hz (0 for none): ");
+   scanf( "%lf", &cutoff );
+   printf("\nStencil, 3 or 5 point: ");
+   scanf( "%d", &stencil );
+   for ( i = 0; i < ntrials; i++ )
+     {
+      length = strlen( datafile[i] );
+      strcpy ( newdatafile, "F:\\FP_DIG.DAT\\");
+      strncat ( newdatafile, datafile[i], length + 1 );
+      strcat ( newdatafile, ".MOM");
+      if ((fpNEW[i] = fopen( newdatafile, "w")) == NULL)
+        {
+         printf("\nCannot create new datafile %s", newdatafile );
+         exit( 1 );
+        }
+     }
+}
+
+
+void open_trial( int i )
+{
+   int j, length;
+   long n, njts;
+   char sessfile[28];
+   double *y;
+   FILE *fpSESS;
+   TXTSCAN *ts;
+   TRJMAP trjmap;
+
+   printf("\nEnter the name of datafile %d (no extension): ", i + 1 );
+   scanf( "%8s", datafile[i] );
+   length = strlen( datafile[i] );
+   strcpy (sessfile, "F:\\FP_DIG.DAT\\");
+   strncat (sessfile, datafile[i], length + 1 );
+   strcat (sessfile, ".TRJ");
+   if ( trj_map( &trjmap, sessfile ) == 0 )
+     {
+      t[i] = trj_traject( &trjmap );
+      if ( i == 0 )
+        {
+         names = (char *) calloc( t[i]->numjoints * TRJ_NAMELEN + 1, 1 );
+         if ( names != NULL )
+            memcpy( names, trjmap.names, t[i]->numjoints * TRJ_NAMELEN );
+        }
+      else if (( t[i]->numjoints == t[0]->numjoints )
+               && ( memcmp( names, trjmap.names,
+                            t[i]->numjoints * TRJ_NAMELEN ) != 0 ))
+        {
+         printf("\nThe joints of %s are not those of %s.", datafile[i],
+                datafile[0] );
+         exit( 1 );
+        }
+      trj_unmap( &trjmap );
+     }
+   else
+     {
+      strcpy (sessfile + strlen( sessfile ) - 4, ".DAT");
+      if ((fpSESS = fopen( sessfile, "r")) == NULL )
+        {
+         printf("\nDatafile %s not found.", datafile[i] );
+         exit( 1 );
+        }
+      ts = txt_open( fpSESS );
+      txt_long( ts, &njts );
+      t[i] = traj_create( (int) njts, 0L );
+      txt_traject( ts, t[i], -1L, TXT_DAT );
+      txt_close( ts );
+      fclose( fpSESS );
+      printf("\nEnter the number of fields skipped: ");
+      scanf( "%d", &t[i]->skip );
+      if ( i == 0 )
+        {
+         names = (char *) calloc( t[i]->numjoints * TRJ_NAMELEN + 1, 1 );
+         for ( j = 0; ( names != NULL ) && ( j < t[i]->numjoints ); j++ )
+           {
+            printf("\nName of joint %d: ", j + 1 );
+            scanf( "%15s", names + j * TRJ_NAMELEN );
+           }
+        }
+     }
+   if ( names == NULL )
+     {
+      printf("\nNot enough memory.");
+      exit( 1 );
+     }
+   if ( t[i]->numjoints != t[0]->numjoints )
+     {
+      printf("\n%s has %d joints, %s has %d.", datafile[i],
+             t[i]->numjoints, datafile[0], t[0]->numjoints );
+      exit( 1 );
+     }
+   for ( j = 0; j < t[i]->numjoints; j++ )      /* y up */
+     {
+      y = TRAJ_Y( t[i], j );
+      for ( n = 0; n < t[i]->numframes; n++ )
+         y[n] = -y[n];
+     }
+}
+
+
+void open_table( void )
+{
+   double p[3];
+   char antfile[28];
+   FILE *fpANT;
+   TXTSCAN *ts;
+
+   strcpy ( antfile, "F:\\FP_DIG.DAT\\");
+   strcat ( antfile, datafile[0] );
+   strcat ( antfile, ".ANT");
+   if ((fpANT = fopen( antfile, "r")) == NULL )
+     {
+      memcpy( tab, bod_winter, sizeof(bod_winter) );
+      ntab = BOD_WINTER;
+      return;
+     }
+   ts = txt_open( fpANT );
+   for ( ntab = 0; ntab < MAXPARMS; ntab++ )
+      if ( !txt_word( ts, tab[ntab].distal, BOD_NAMELEN )
+           || !txt_word( ts, tab[ntab].proximal, BOD_NAMELEN )
+           || ( txt_doubles( ts, p, 3L ) != 3 ))
+         break;
+      else
+        {
+         tab[ntab].mass = p[0];
+         tab[ntab].com = p[1];
+         tab[ntab].gyration = p[2];
+        }
+   txt_close( ts );
+   fclose( fpANT );
+}
+
+
+void calculate( void )
+{
+   int i;
+
+   for ( i = 0; i < ntrials; i++ )
+      if (( cutoff > 0.0 ) && ( smo_filter( t[i], cutoff, 0 ) < 0 ))
+        {
+         printf("\nCutoff must be below %4.1lf Hz.",
+                     SMO_PASSES / ( 2.0 * kin_interval( t[i] )));
+         exit( 1 );
+        }
+   numsegs = bod_map( t[0], names, TRJ_NAMELEN, tab, ntab, bodymass,
+                      seg );
+   if ( numsegs == 0 )
+     {
+      printf("\nNo segment of the table has both its joints named.");
+      exit( 1 );
+     }
+   printf("\n%d segments found.", numsegs );
+   bod_batch( t, ntrials, seg, numsegs, stencil, 0, b );
+   if ( b[0] == NULL )
+     {
+      printf("\nStencil must be 3 or 5.");
+      exit( 1 );
+     }
+}
+
+
+void save_data( void )
+{
+   int i;
+   long n;
+   BODY *bt;
+   FILE *fp;
+
+   for ( i = 0; i < ntrials; i++ )
+     {
+      bt = b[i];
+      fp = fpNEW[i];
+      fprintf( fp, "%s\n%d\n%ld\n%01.5lf\n", datafile[i], numsegs,
+                   t[i]->numframes, kin_interval( t[i] ));
+      for ( n = 0; n < t[i]->numframes; n++ )
+        {
+         fprintf( fp, "%04ld", n );
+         if ( TRAJ_OK( bt->whole, BOD_COM, n ) )
+            fprintf( fp, " %8.4lf %8.4lf", TRAJ_X( bt->whole, BOD_COM )[n],
+                     TRAJ_Y( bt->whole, BOD_COM )[n] );
+         else
+            fprintf( fp, " %8.0lf %8.0lf", TRAJ_HIDDEN, TRAJ_HIDDEN );
+         if ( TRAJ_OK( bt->whole, BOD_VCOM, n ) )
+            fprintf( fp, " %8.4lf %8.4lf %9.4lf",
+                     TRAJ_X( bt->whole, BOD_VCOM )[n],
+                     TRAJ_Y( bt->whole, BOD_VCOM )[n], bt->angmom[n] );
+         else
+            fprintf( fp, " %8.0lf %8.0lf %9.0lf", TRAJ_HIDDEN,
+                     TRAJ_HIDDEN, TRAJ_HIDDEN );
+         fprintf( fp, "\n" );
+        }
+     }
+}
+
+
+void all_done( void )
+{
+   int i;
+
+   for ( i = 0; i < ntrials; i++ )
+     {
+      fclose( fpNEW[i] );
+      bod_free( b[i] );
+      traj_free( t[i] );
+     }
+   free( names );
+   printf("\nALL DONE.!\n\n");
+}
@@ -0,0 +1,313 @@
+/**************************************************************************
+ *  PIPE.C
+ *
+ * Ankle, torque and fit in one pass. The following function is public:
+ *
+ *   pip_run        -   Runs a session through the three stages
+ *
+ * Each block of records is read into the same source store, and each
+ * stage works down whole columns of the block before handing it on.
+ * The only state carried from block to block is what the programs
+ * carry from record to record: the zero fin angle, the last angle for
+ * unwrapping and the fit itself.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "pipe.h"
+#include "angles.h"
+#include "vmarker.h"
+
+#define PI       3.14159265     /* As torque.c, so the .TOR agrees      */
+#define TWOPI    6.28318530717959
+#define CFACTOR  0.00318        /* Meters per pixel, ankle.c & torque.c */
+
+/* What the stages carry between blocks */
+typedef struct _PIPESTATE
+{
+    TRAJECT *src;               /* Fin points of the block, pixels      */
+    TRAJECT *tq;                /* Ankle and fin points, torque.c units */
+    long     first;             /* Record number of the block's first   */
+    long     dtapos;            /* Where the .DTA record count goes     */
+    int      zeroed;            /* zero_angle is set                    */
+    double   zero_angle;
+    int      seen;              /* last is set                          */
+    double   last, turns;       /* For unwrapping across blocks         */
+} PIPESTATE;
+
+/* Prototypes for internal functions */
+static long pip_read( const PIPESPEC *p, PIPESTATE *st, long count );
+static void pip_ankle( const PIPESPEC *p, PIPESTATE *st,
+                       const VMARKER *vm, int nthreads );
+static void pip_unwrap( PIPESTATE *st, double *a,
+                        const unsigned char *mask, long len );
+static void pip_torque( const PIPESPEC *p, PIPESTATE *st, PIPERESULT *r,
+                        int nthreads );
+
+
+/* pip_read - Reads the next "count" records of fin points into the
+ * source store, from the mapped .TRJ or the .DAT scanner.
+ *
+ * Return: The number of records read
+ */
+static long pip_read( const PIPESPEC *p, PIPESTATE *st, long count )
+{
+    st->src->numframes = 0;
+    if( p->map == NULL )
+       return txt_traject( p->ts, st->src, count, TXT_DAT );
+    return trj_read( p->map, st->src, st->first, count );
+}
+
+
+/* pip_ankle - The ankle stage: turns the block to ankle.c's pixels
+ * (origin lower left, whole pixels), places the ankle, writes the
+ * .DTA records if asked and fills the torque stage's store.
+ */
+static void pip_ankle( const PIPESPEC *p, PIPESTATE *st,
+                       const VMARKER *vm, int nthreads )
+{
+    TRAJECT *src = st->src, *tq = st->tq, *ankle;
+    const char *fmt;
+    double *x, *y, *ty, *tz, scale, m;
+    size_t cols, bytes;
+    long k;
+    int j;
+
+    scale = src->cfactor / CFACTOR;
+    for( j = 0; j < src->numjoints; j++ )
+      {
+        x = TRAJ_X( src, j );
+        y = TRAJ_Y( src, j );
+        for( k = 0; k < src->numframes; k++ )
+          {
+            x[k] = floor( (x[k] * scale) + 0.5 );
+            y[k] = 480 - floor( (y[k] * scale) + 0.5 );
+          }
+      }
+    ankle = vm_build( src, vm, 1, nthreads );
+
+                  /* whole columns across: the ankle, then the fin */
+    tq->numframes = src->numframes;
+    cols = (size_t) src->numframes * sizeof(double);
+    bytes = (size_t) ((src->numframes + 7) >> 3);
+    x = TRAJ_X( ankle, 0 );
+    y = TRAJ_Y( ankle, 0 );
+    ty = TRAJ_X( tq, 0 );
+    tz = TRAJ_Y( tq, 0 );
+    for( k = 0; k < src->numframes; k++ )
+      {
+        m = (double) TRAJ_OK( ankle, 0, k );
+        ty[k] = floor( x[k] + 0.5 ) * m;
+        tz[k] = floor( y[k] + 0.5 ) * m;
+      }
+    memcpy( TRAJ_MASK( tq, 0 ), TRAJ_MASK( ankle, 0 ), bytes );
+    for( j = 0; j < src->numjoints; j++ )
+      {
+        memcpy( TRAJ_X( tq, j + 1 ), TRAJ_X( src, j ), cols );
+        memcpy( TRAJ_Y( tq, j + 1 ), TRAJ_Y( src, j ), cols );
+        memcpy( TRAJ_MASK( tq, j + 1 ), TRAJ_MASK( src, j ), bytes );
+      }
+    traj_free( ankle );
+
+    if( p->dta != NULL )                /* as ankle.c writes it */
+       for( k = 0; k < tq->numframes; k++ )
+         {
+           for( j = 0; j < tq->numjoints; j++ )
+             {
+               fmt = (j == 0) ? "%4.0lf%5.0lf" : "%6.0lf%5.0lf";
+               if( TRAJ_OK( tq, j, k ) )
+                  fprintf( p->dta, fmt, TRAJ_X( tq, j )[k],
+                           TRAJ_Y( tq, j )[k] );
+               else
+                  fprintf( p->dta, fmt, TRAJ_HIDDEN, TRAJ_HIDDEN );
+             }
+           fprintf( p->dta, "\n" );
+         }
+
+    for( j = 0; j < tq->numjoints; j++ )    /* to torque.c's cm */
+      {
+        ty = TRAJ_X( tq, j );
+        tz = TRAJ_Y( tq, j );
+        for( k = 0; k < tq->numframes; k++ )
+          {
+            ty[k] = (640 - (ty[k] * CFACTOR * 100));
+            tz[k] = (tz[k] * CFACTOR * 100);
+          }
+      }
+}
+
+
+/* pip_unwrap - ang_unwrap() carried on from the last block.
+ */
+static void pip_unwrap( PIPESTATE *st, double *a,
+                        const unsigned char *mask, long len )
+{
+    double w;
+    long n;
+
+    for( n = 0; n < len; n++ )
+      {
+        if( !((mask[n >> 3] >> (n & 7)) & 1) )
+           continue;
+        a[n] += st->turns;
+        if( st->seen )
+          {
+            w = TWOPI * floor( (a[n] - st->last + TWOPI / 2.0) / TWOPI );
+            a[n] -= w;
+            st->turns -= w;
+          }
+        st->last = a[n];
+        st->seen = 1;
+      }
+}
+
+
+/* pip_torque - The torque stage and the fit: the fin angle and the
+ * plate at each record of the block give gamma, rel_gamma and the
+ * torque about the ankle, as torque.c finds them.
+ */
+static void pip_torque( const PIPESPEC *p, PIPESTATE *st, PIPERESULT *r,
+                        int nthreads )
+{
+    static ANGSPEC fin_spec = { ANG_JOINT, 0, 2, 2, 4 };
+    TRAJECT *tq = st->tq;
+    ANGLES *g;
+    SIGNAL *force;
+    double *a, *yc[3], *zc[3], fy, fz, gamma, rel_gamma, torque;
+    long k;
+    int i, ok;
+
+    g = ang_compute( tq, &fin_spec, 1, 0, nthreads );
+    a = ANG_COL( g, 0 );
+    pip_unwrap( st, a, ANG_MASK( g, 0 ), tq->numframes );
+    force = aln_resample( p->plate, PIP_RECRATE, st->first / PIP_RECRATE,
+                          tq->numframes, p->offset, p->method );
+    for( i = 0; i < 3; i++ )
+      {
+        yc[i] = TRAJ_X( tq, 2 * i );
+        zc[i] = TRAJ_Y( tq, 2 * i );
+      }
+
+    for( k = 0; k < tq->numframes; k++ )
+      {
+        fy = SIG_COL( force, 1 )[k];
+        fz = SIG_COL( force, 2 )[k];
+        ok = TRAJ_OK( tq, 0, k ) & TRAJ_OK( tq, 2, k )
+             & TRAJ_OK( tq, 4, k );
+        if( !ok )
+           r->hidden++;
+        else if( (yc[1][k] - yc[0][k] < 0 && zc[1][k] - zc[0][k] > 0)
+                 || yc[2][k] - yc[1][k] < 0 || zc[2][k] - zc[1][k] > 0 )
+          {
+            r->badfin++;
+            ok = 0;
+          }
+
+        if( !ok )
+          {
+            gamma = rel_gamma = TRAJ_HIDDEN;
+            torque = 0.0;
+          }
+        else
+          {
+            gamma = 180 - (a[k] * 180 / PI);
+            if( !st->zeroed )           /* first record with every point */
+              {
+                st->zero_angle = gamma;
+                st->zeroed = 1;
+              }
+            rel_gamma = st->zero_angle - gamma;
+            torque = ((fz * (yc[2][k] - yc[0][k]))
+                      - (fy * (zc[2][k] - zc[0][k]))) / 100;
+            lsq_add( &r->fit, rel_gamma, torque );
+          }
+
+        if( p->tor != NULL )            /* as torque.c writes it */
+           fprintf( p->tor, "%d%10.3lf%10.3lf%10.3lf%10.3lf%10.3lf\n",
+                    p->fin, fy, fz, gamma, rel_gamma, torque );
+      }
+    sig_free( force );
+    ang_free( g );
+}
+
+
+/* pip_run - Runs the session described by "p" through the ankle,
+ * torque and fit stages, a block at a time, using up to "nthreads"
+ * threads (0 = one per processor) within each stage.  The counts and
+ * the solved fit go in "r".
+ *
+ * Return: 0 on success, -1 if the session has too few fin points
+ */
+int pip_run( const PIPESPEC *p, PIPERESULT *r, int nthreads )
+{
+    PIPESTATE st;
+    VMARKER vm;
+    double rad_alpha, distance;
+    long want, got;
+    int numjoints;
+
+    numjoints = (p->map != NULL) ? (int) p->map->head->numjoints
+                                 : p->numjoints;
+    if( numjoints < PIP_MINJTS )
+       return -1;
+
+    r->records = r->hidden = r->badfin = 0;
+    lsq_init( &r->fit, p->degree );
+    r->fit.fin = p->fin;
+    st.src = traj_create( numjoints, (long) PIP_BLOCK );
+    if( p->map != NULL )
+      {
+        st.src->cfactor = p->map->head->cfactor;
+        st.src->skip = (int) p->map->head->skip;
+      }
+    st.tq = traj_create( numjoints + 1, (long) PIP_BLOCK );
+    st.first = st.dtapos = 0L;
+    st.zeroed = st.seen = 0;
+    st.zero_angle = st.last = st.turns = 0.0;
+
+                   /* The ankle in the fin's frame, as ankle.c has it */
+    rad_alpha = (p->alpha / 180.0) * 3.1415927;
+    distance = (p->distance / 100) / CFACTOR;
+    vm.nreal = 2;
+    vm.real[0] = 0;
+    vm.rx[0] = vm.ry[0] = 0.0;
+    vm.real[1] = 1;
+    vm.rx[1] = -1.0;
+    vm.ry[1] = 0.0;
+    vm.vx = distance * cos( rad_alpha );
+    vm.vy = -distance * sin( rad_alpha );
+
+    if( p->dta != NULL )                /* the count is known at the end */
+      {
+        fprintf( p->dta, "%s\n", p->name );
+        st.dtapos = ftell( p->dta );
+        fprintf( p->dta, "%8ld\n%d\n", 0L, p->fin );
+      }
+
+    for( ;; )
+      {
+        want = PIP_BLOCK;
+        if( p->records > 0 && p->records - st.first < want )
+           want = p->records - st.first;
+        if( want <= 0 || (got = pip_read( p, &st, want )) == 0 )
+           break;
+        pip_ankle( p, &st, &vm, nthreads );
+        pip_torque( p, &st, r, nthreads );
+        st.first += got;
+        if( got < want )
+           break;
+      }
+    r->records = st.first;
+
+    if( p->dta != NULL )
+      {
+        fseek( p->dta, st.dtapos, SEEK_SET );
+        fprintf( p->dta, "%8ld", r->records );
+        fseek( p->dta, 0L, SEEK_END );
+      }
+    r->solved = lsq_solve( &r->fit, p->degree );
+    traj_free( st.src );
+    traj_free( st.tq );
+    return 0;
+}
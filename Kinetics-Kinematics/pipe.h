@@ -0,0 +1,78 @@
+/* PIPE.H
+ *
+ * One pass from digitized fin points to a torque-angle fit.  The work
+ * of ankle.c, torque.c and finfit.c is done as three stages over the
+ * same records, a block of PIP_BLOCK records at a time:
+ *
+ *      ankle   -  the ankle placed as a virtual marker (vmarker.c)
+ *      torque  -  the fin angle (angles.c) and the plate, resampled at
+ *                 the block's record times (align.c), give the torque
+ *      fit     -  each (rel_gamma, torque) is folded into the least
+ *                 squares fit (lsfit.c)
+ *
+ * Only one block of each stage's output is held, however long the
+ * session, and nothing is written or parsed between stages.  The
+ * "*.DTA" and "*.TOR" files can still be written as the records go by,
+ * in the same layout as ankle.c and torque.c, by giving them files.
+ *
+ * Records come from a mapped "*.TRJ" or, failing that, from a scanner
+ * left past the header of a "*.DAT".  The numbers match the three
+ * programs run in turn, except that a record with the fin pointing
+ * the wrong way is left out (and counted) where torque.c stops.
+ */
+
+/* Include only once */
+#ifndef PIPE_H
+#define PIPE_H
+
+#include <stdio.h>
+#include "traject.h"
+#include "trjfile.h"
+#include "txtscan.h"
+#include "align.h"
+#include "lsfit.h"
+
+#define PIP_BLOCK    512        /* Records in flight at once            */
+#define PIP_RECRATE  60.0       /* Records per second                   */
+#define PIP_MINJTS   4          /* Fin points the torque stage needs    */
+
+typedef struct _PIPESPEC
+{
+    /* Source: a mapped .TRJ, or else a .DAT scanner past its header */
+    TRJMAP     *map;
+    TXTSCAN    *ts;
+    int         numjoints;      /* Fin points per record (.DAT only)    */
+    long        records;        /* Records to run, <= 0 for all         */
+
+    /* Ankle stage */
+    const char *name;           /* Datafile name, for the .DTA header   */
+    int         fin;            /* Fin number                           */
+    double      alpha;          /* Ankle angle from the fin, degrees    */
+    double      distance;       /* Ankle distance from the fin, cm      */
+
+    /* Torque stage */
+    SIGNAL     *plate;          /* The whole force plate signal         */
+    double      offset;         /* Plate time at record zero            */
+    int         method;         /* ALN_LINEAR or ALN_SINC               */
+
+    /* Fit stage */
+    int         degree;         /* Of the polynomial, up to LSQ_MAXDEG  */
+
+    /* Intermediate files, NULL for none */
+    FILE       *dta;
+    FILE       *tor;
+} PIPESPEC;
+
+typedef struct _PIPERESULT
+{
+    long    records;            /* Records run                          */
+    long    hidden;             /* With a hidden ankle, toe or fin      */
+    long    badfin;             /* With the fin pointing the wrong way  */
+    LSQFIT  fit;                /* Solved at the spec's degree          */
+    int     solved;             /* 0, or -1 if too few points to fit    */
+} PIPERESULT;
+
+/* Public pipeline functions */
+int pip_run( const PIPESPEC *p, PIPERESULT *r, int nthreads );
+
+#endif /* PIPE_H */
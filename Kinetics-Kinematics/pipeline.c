@@ -0,0 +1,120 @@
+/* Pipeline Program.
+   ------------------
+   Program runs a whole study from a manifest, with no prompting: each
+   fin trial goes through the ankle, torque and regression steps in one
+   pass (pipe.c), in place of running "ankle.c", "torque.c" and
+   "finfit.c" in turn, and each velocity trial as "velocity.c" would
+   run it.  The trials are spread over every processor (batch.c).
+
+   The manifest is named on the command line, or else is
+   "F:\TORQUE.DAT\FINRUN.DAT":
+
+         rate  method  degree  keep
+         fin       name  fin  angle  distance  records  sync  chan  level
+         velocity  name  lane  records
+
+   rate is the force plate samples per second (300 for the old plate),
+   method 0 linear or 1 sinc interpolation of the plate, degree of the
+   fit 1 to 3, and keep 1 to write the "*.DTA" and "*.TOR" files as
+   well, the same as those programs write them.  For a fin, give the
+   datafile name (no extension), fin number, the ankle's angle
+   (degrees) and distance (cm) from the fin, the records to run (0 for
+   all), the record of the sync event (-1 if the starts are in step)
+   and the force channel (1-6) and level that mark it.  Fin points come
+   from "*.TRJ" if the digitizer left one, else from "*.DAT"; the force
+   from "F:\FORCE.DAT\name".  For velocity, give the raw datafile, the
+   lane and the records (0 for all).
+
+   "FINGRAPH.DAT" and "FINFIT.OUT" are written as "finfit.c" does, so
+   "regression.c" can be run straight after; velocity lines are added
+   to "velocity.dat".  How every trial went, in manifest order, is
+   shown and written to "F:\TORQUE.DAT\BATCH.LOG"; a trial that fails
+   does not stop the others.
+
+   Results are cached in "F:\TORQUE.DAT\CACHE\", if that directory
+   is there, under a fingerprint of each trial's files and parameters:
+   a rerun only works through the trials that changed.  Empty the
+   directory to force everything to be run again.  Compile with:
+
+         cl /AL /I..\VideoCapture pipeline.c batch.c cache.c pipe.c
+            lsfit.c angles.c align.c vmarker.c ..\VideoCapture\traject.c
+            ..\VideoCapture\trjfile.c ..\VideoCapture\filemap.c
+            ..\VideoCapture\txtscan.c ..\VideoCapture\worker.c
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "txtscan.h"
+#include "batch.h"
+
+#define MAXANGLE 40         /* angles regression.c can hold */
+
+void open_files( char *listfile );
+void save_data( void );
+void all_done( void );
+
+int failed;
+
+BATCH *b;
+
+FILE *fpGRAPH, *fpNEW, *fpVEL, *fpLOG;
+
+main( int argc, char *argv[] )
+{
+   open_files( ( argc > 1 ) ? argv[1] : "F:\\TORQUE.DAT\\FINRUN.DAT" );
+   bat_run( b, 0 );
+   save_data();
+   all_done();
+}
+
+
+void open_files( char *listfile )
+{
+   FILE *fpLIST;
+   TXTSCAN *ts;
+
+   if ((fpLIST = fopen( listfile, "r")) == NULL )
+     {
+      printf("\nManifest %s not found.", listfile );
+      exit( 1 );
+     }
+   ts = txt_open( fpLIST );
+   b = bat_read( ts, "F:\\FP_DIG.DAT\\", "F:\\FORCE.DAT\\",
+                     "F:\\TORQUE.DAT\\", "F:\\TORQUE.DAT\\CACHE\\" );
+   txt_close( ts );
+   fclose( fpLIST );
+   if ( b == NULL )
+     {
+      printf("\nManifest %s has no settings line.", listfile );
+      exit( 1 );
+     }
+   printf("%d trials.\n", b->numtrials );
+   if ((fpGRAPH = fopen( "F:\\TORQUE.DAT\\FINGRAPH.DAT", "w")) == NULL
+       || (fpNEW = fopen( "F:\\TORQUE.DAT\\FINFIT.OUT", "w")) == NULL
+       || (fpVEL = fopen( "velocity.dat", "a")) == NULL
+       || (fpLOG = fopen( "F:\\TORQUE.DAT\\BATCH.LOG", "w")) == NULL)
+     {
+      printf("\nCannot create new datafile");
+      exit( 1 );
+     }
+}
+
+
+void save_data( void )
+{
+   failed = bat_report( b, MAXANGLE, fpGRAPH, fpNEW, fpVEL );
+   bat_log( b, fpLOG );
+   bat_log( b, stdout );
+}
+
+
+void all_done( void )
+{
+   fclose( fpGRAPH );
+   fclose( fpNEW );
+   fclose( fpVEL );
+   fclose( fpLOG );
+   printf("\n%d of %d trials failed.", failed, b->numtrials );
+   bat_free( b );
+   printf("\nALL DONE.!\n\n");
+}
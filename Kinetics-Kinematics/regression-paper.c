@@ -2,6 +2,7 @@
    ------------------
    Program calculates the torque around the ankle based on
    the regression parameters provided.
+   "FINGRAPH.DAT" is written by "finfit.c" from the "*.TOR" files.
 */
 
 #include <stdio.h>
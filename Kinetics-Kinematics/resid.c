@@ -0,0 +1,232 @@
+/**************************************************************************
+ *  RESID.C
+ *
+ * Residual analysis of smoothing cutoffs. The following functions are
+ * public:
+ *
+ *   res_sweep      -   Residual curves and best cutoff for every joint
+ *   res_free       -   Releases the results
+ *   res_report     -   Writes the curves and cutoffs as text
+ *
+ * Every (joint, cutoff) pair is a task for the worker pool (worker.c),
+ * so a sweep keeps all the processors busy even for a few joints.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "resid.h"
+#include "smooth.h"
+#include "kinemat.h"
+#include "worker.h"
+
+/* Shared arguments of the residual tasks */
+typedef struct _RESJOB
+{
+    TRAJECT  *t;
+    RESIDUAL *r;
+    double    rate;             /* Fields per second                    */
+} RESJOB;
+
+/* Prototypes for internal functions */
+static void *res_alloc( long n, size_t size );
+static void  res_task( void *arg, long i );
+static void  res_choose( RESIDUAL *r, int j );
+
+
+/* res_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *res_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  res_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* res_task - Task "i": joint i / ncut smoothed at cutoff i % ncut.
+ * Each visible run is smoothed on its own, as smo_filter() would.
+ */
+static void res_task( void *arg, long i )
+{
+    RESJOB *job = (RESJOB *) arg;
+    TRAJECT *t = job->t;
+    SMOCOEF c;
+    double *buf, *x, *y, sum = 0.0, d;
+    long n, start, end, count = 0;
+    int j, k;
+
+    j = (int) (i / job->r->ncut);
+    k = (int) (i % job->r->ncut);
+    if( smo_coeffs( job->r->cutoff[k], job->rate, &c ) < 0 )
+      {
+        RES_CURVE( job->r, j )[k] = 0.0;
+        return;
+      }
+    x = TRAJ_X( t, j );
+    y = TRAJ_Y( t, j );
+    buf = (double *) res_alloc( t->numframes, sizeof(double) );
+
+    for( start = 0; start < t->numframes; start = end )
+      {
+        while( start < t->numframes && !TRAJ_OK( t, j, start ) )
+           start++;
+        for( end = start; end < t->numframes && TRAJ_OK( t, j, end ); end++ )
+          ;
+        smo_series( &c, x + start, buf, end - start );
+        for( n = start; n < end; n++ )
+          {
+            d = x[n] - buf[n - start];
+            sum += d * d;
+          }
+        smo_series( &c, y + start, buf, end - start );
+        for( n = start; n < end; n++ )
+          {
+            d = y[n] - buf[n - start];
+            sum += d * d;
+          }
+        count += 2 * (end - start);
+      }
+    RES_CURVE( job->r, j )[k] = (count > 0) ? sqrt( sum / count ) : 0.0;
+    free( buf );
+}
+
+
+/* res_choose - Fits the noise line to the tail of joint "j"'s curve and
+ * picks its cutoff, interpolating between sweep points.
+ */
+static void res_choose( RESIDUAL *r, int j )
+{
+    double *R, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, m, a, f;
+    int k, first, n;
+
+    R = RES_CURVE( r, j );
+    first = (int) (r->ncut * (1.0 - RES_TAIL));
+    if( first > r->ncut - 2 )
+       first = r->ncut - 2;
+    if( first < 0 )
+       first = 0;
+    n = r->ncut - first;
+    for( k = first; k < r->ncut; k++ )
+      {
+        sx += r->cutoff[k];
+        sy += R[k];
+        sxx += r->cutoff[k] * r->cutoff[k];
+        sxy += r->cutoff[k] * R[k];
+      }
+    m = (n * sxx - sx * sx != 0.0) ? (n * sxy - sx * sy) / (n * sxx - sx * sx)
+                                   : 0.0;
+    a = (sy - m * sx) / n;
+    r->noise[j] = a;
+
+    r->best[j] = r->cutoff[r->ncut - 1];
+    for( k = 0; k < r->ncut; k++ )
+       if( R[k] <= a )
+         {
+           if( k == 0 || R[k - 1] == R[k] )
+              f = r->cutoff[k];
+           else
+              f = r->cutoff[k - 1] + (r->cutoff[k] - r->cutoff[k - 1])
+                  * (R[k - 1] - a) / (R[k - 1] - R[k]);
+           r->best[j] = f;
+           break;
+         }
+}
+
+
+/* res_sweep - Smooths every joint of "t" at cutoffs "low" to "high" Hz
+ * in steps of "step" (the RES_ defaults if any is zero or less), using
+ * up to "nthreads" threads (0 = one per processor).  Cutoffs too high
+ * for the session's field rate are dropped from the sweep.
+ *
+ * Return: The curves and chosen cutoffs, or NULL if no cutoff in the
+ *         sweep is usable
+ */
+RESIDUAL *res_sweep( TRAJECT *t, double low, double high, double step,
+                     int nthreads )
+{
+    RESIDUAL *r;
+    RESJOB job;
+    SMOCOEF c;
+    double rate;
+    int k, ncut;
+
+    if( low <= 0.0 || high <= 0.0 || step <= 0.0 )
+      {
+        low = RES_LOW;
+        high = RES_HIGH;
+        step = RES_STEP;
+      }
+    rate = 1.0 / kin_interval( t );
+    for( ncut = 0; low + ncut * step <= high + step * 1e-6; ncut++ )
+       if( smo_coeffs( low + ncut * step, rate, &c ) < 0 )
+          break;
+    if( ncut < 2 )
+       return NULL;
+
+    r = (RESIDUAL *) res_alloc( 1L, sizeof(RESIDUAL) );
+    r->numjoints = t->numjoints;
+    r->ncut = ncut;
+    r->cutoff = (double *) res_alloc( (long) ncut, sizeof(double) );
+    r->resid = (double *) res_alloc( (long) ncut * t->numjoints,
+                                     sizeof(double) );
+    r->noise = (double *) res_alloc( (long) t->numjoints, sizeof(double) );
+    r->best = (double *) res_alloc( (long) t->numjoints, sizeof(double) );
+    for( k = 0; k < ncut; k++ )
+       r->cutoff[k] = low + k * step;
+
+    job.t = t;
+    job.r = r;
+    job.rate = rate;
+    work_run( (long) ncut * t->numjoints, res_task, &job, nthreads );
+
+    for( k = 0; k < t->numjoints; k++ )
+       res_choose( r, k );
+    return r;
+}
+
+
+/* res_free - Releases residual results.
+ */
+void res_free( RESIDUAL *r )
+{
+    if( r == NULL )
+       return;
+    free( r->cutoff );
+    free( r->resid );
+    free( r->noise );
+    free( r->best );
+    free( r );
+}
+
+
+/* res_report - Writes the joints and cutoffs in the sweep, then one line
+ * per joint: name (if "names" is given, every "namestride" bytes),
+ * chosen cutoff, noise intercept and the residual at each cutoff.
+ */
+void res_report( RESIDUAL *r, FILE *fp, const char *names, int namestride )
+{
+    int j, k;
+
+    fprintf( fp, "%d %d\n", r->numjoints, r->ncut );
+    for( k = 0; k < r->ncut; k++ )
+       fprintf( fp, "%6.2lf", r->cutoff[k] );
+    fprintf( fp, "\n" );
+    for( j = 0; j < r->numjoints; j++ )
+      {
+        if( names != NULL )
+           fprintf( fp, "%-12s", names + (long) j * namestride );
+        else
+           fprintf( fp, "JOINT%-7d", j + 1 );
+        fprintf( fp, " %6.2lf %10.5lf", r->best[j], r->noise[j] );
+        for( k = 0; k < r->ncut; k++ )
+           fprintf( fp, " %10.5lf", RES_CURVE( r, j )[k] );
+        fprintf( fp, "\n" );
+      }
+}
@@ -0,0 +1,44 @@
+/* RESID.H
+ *
+ * Residual analysis for choosing each joint's smoothing cutoff.  Every
+ * joint is smoothed at each cutoff of a sweep and the RMS difference
+ * between raw and smoothed coordinates (x and y together, visible
+ * fields only) is recorded.  Above the signal band the residual falls
+ * on a straight line made by the noise; a line fitted to the top
+ * RES_TAIL of the sweep is run back to 0 Hz, and the chosen cutoff is
+ * the lowest one whose residual is no more than that intercept.
+ */
+
+/* Include only once */
+#ifndef RESID_H
+#define RESID_H
+
+#include <stdio.h>
+#include "traject.h"
+
+#define RES_TAIL    0.5         /* Fraction of the sweep fitted as noise */
+#define RES_LOW     1.0         /* Default sweep, Hz                    */
+#define RES_HIGH    15.0
+#define RES_STEP    0.5
+
+/* Residual curves and chosen cutoffs of one session */
+typedef struct _RESIDUAL
+{
+    int     numjoints;
+    int     ncut;               /* Cutoffs in the sweep                 */
+    double *cutoff;             /* ncut frequencies, Hz                 */
+    double *resid;              /* ncut residuals per joint             */
+    double *noise;              /* Intercept of each joint's noise line */
+    double *best;               /* Chosen cutoff of each joint, Hz      */
+} RESIDUAL;
+
+#define RES_CURVE( r, j )  ((r)->resid + (long) (j) * (r)->ncut)
+
+/* Public residual analysis functions */
+RESIDUAL *res_sweep( TRAJECT *t, double low, double high, double step,
+                     int nthreads );
+void      res_free( RESIDUAL *r );
+void      res_report( RESIDUAL *r, FILE *fp, const char *names,
+                      int namestride );
+
+#endif /* RESID_H */
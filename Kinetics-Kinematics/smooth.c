@@ -0,0 +1,385 @@
+/**************************************************************************
+ *  SMOOTH.C
+ *
+ * Butterworth smoothing of trajectories. The following functions are
+ * public:
+ *
+ *   smo_coeffs     -   Filter coefficients for a cutoff and sample rate
+ *   smo_series     -   Smooths one run of samples
+ *   smo_filter     -   Smooths every joint of a session in place
+ *   smo_joints     -   The same, with a cutoff of its own for each joint
+ *
+ * The filter works on a row buffer holding "width" interleaved columns
+ * (row r, column k at buf[r * width + k]).  Joints with no hidden
+ * points are copied in SMO_GROUP at a time, so the recursion, which
+ * can't be vectorized along time, is vectorized across columns
+ * instead.  Joints with gaps are filtered one run at a time.  Groups
+ * and gapped joints are tasks for the worker pool (worker.c).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "smooth.h"
+#include "kinemat.h"
+#include "worker.h"
+
+#define PI  3.14159265358979
+
+/* Shared arguments of the smoothing tasks */
+typedef struct _SMOJOB
+{
+    TRAJECT *t;
+    SMOCOEF *c;                 /* Coefficients of each joint           */
+    int     *plain;             /* Gap free joints                      */
+    int      nplain;
+    int     *gapped;            /* Joints with hidden points            */
+    int      ngapped;
+    long     ngroups;           /* Tasks for the gap free joints        */
+} SMOJOB;
+
+/* Prototypes for internal functions */
+static void  *smo_alloc( long n, size_t size );
+static long   smo_padlen( long len );
+static void   smo_reflect( double *buf, long len, long pad, int width );
+static void   smo_pass( const SMOCOEF *c, const double *in, double *out,
+                        long rows, int width, int dir );
+static void   smo_rows( const SMOCOEF *c, double *buf, double *tmp,
+                        long len, long pad, int width );
+static int    smo_plain( TRAJECT *t, int j );
+static void   smo_group( SMOJOB *job, long g );
+static void   smo_gapped( SMOJOB *job, int j );
+static void   smo_task( void *arg, long i );
+
+
+/* smo_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *smo_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  smo_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* smo_padlen - Padding for a run of "len" samples.
+ */
+static long smo_padlen( long len )
+{
+    return (len - 1 < SMO_PAD) ? len - 1 : SMO_PAD;
+}
+
+
+/* smo_reflect - Fills the "pad" rows before and after the "len" data
+ * rows of "buf" with the data reflected through the end points.
+ */
+static void smo_reflect( double *buf, long len, long pad, int width )
+{
+    double *first, *last;
+    long r;
+    int k;
+
+    first = buf + pad * width;
+    last = buf + (pad + len - 1) * width;
+    for( r = 1; r <= pad; r++ )
+       for( k = 0; k < width; k++ )
+         {
+           first[-r * width + k] = 2.0 * first[k] - first[r * width + k];
+           last[r * width + k] = 2.0 * last[k] - last[-r * width + k];
+         }
+}
+
+
+/* smo_pass - Runs the filter down (dir = 1) or up (dir = -1) "rows"
+ * rows of "in" into "out".  The first two outputs are taken equal to
+ * their inputs, so a constant signal passes through unchanged.
+ */
+static void smo_pass( const SMOCOEF *c, const double *in, double *out,
+                      long rows, int width, int dir )
+{
+    long r, r0, step;
+    const double *x, *x1, *x2;
+    double *y, *y1, *y2;
+    int k;
+
+    r0 = (dir > 0) ? 0 : rows - 1;
+    step = (long) dir * width;
+    x = in + r0 * width;
+    y = out + r0 * width;
+    for( k = 0; k < width; k++ )
+       y[k] = x[k];
+    if( rows < 2 )
+       return;
+    for( k = 0; k < width; k++ )
+       y[step + k] = x[step + k];
+    for( r = 2; r < rows; r++ )
+      {
+        x = in + (r0 + r * dir) * width;
+        x1 = x - step;
+        x2 = x1 - step;
+        y = out + (r0 + r * dir) * width;
+        y1 = y - step;
+        y2 = y1 - step;
+        for( k = 0; k < width; k++ )
+           y[k] = c->a0 * x[k] + c->a1 * x1[k] + c->a2 * x2[k]
+                  + c->b1 * y1[k] + c->b2 * y2[k];
+      }
+}
+
+
+/* smo_rows - Pads, filters forward and back, and leaves the result in
+ * the data rows of "buf".  "tmp" is the same size as "buf".
+ */
+static void smo_rows( const SMOCOEF *c, double *buf, double *tmp,
+                      long len, long pad, int width )
+{
+    smo_reflect( buf, len, pad, width );
+    smo_pass( c, buf, tmp, len + 2 * pad, width, 1 );
+    smo_pass( c, tmp, buf, len + 2 * pad, width, -1 );
+}
+
+
+/* smo_plain - TRUE if joint "j" has no hidden fields.
+ */
+static int smo_plain( TRAJECT *t, int j )
+{
+    long n;
+
+    for( n = 0; n < t->numframes; n++ )
+       if( !TRAJ_OK( t, j, n ) )
+          return 0;
+    return 1;
+}
+
+
+/* smo_group - Filters gap free joints g * SMO_GROUP onward, all their
+ * columns side by side.
+ */
+static void smo_group( SMOJOB *job, long g )
+{
+    TRAJECT *t = job->t;
+    double *buf, *tmp, *col;
+    long n, len, pad, rows;
+    int i, k, first, count, width;
+
+    first = (int) (g * SMO_GROUP);
+    count = job->nplain - first;
+    if( count > SMO_GROUP )
+       count = SMO_GROUP;
+    width = 2 * count;
+    len = t->numframes;
+    pad = smo_padlen( len );
+    rows = len + 2 * pad;
+    buf = (double *) smo_alloc( 2 * rows * width, sizeof(double) );
+    tmp = buf + rows * width;
+
+    for( i = 0; i < count; i++ )
+       for( k = 0; k < 2; k++ )
+         {
+           col = k ? TRAJ_Y( t, job->plain[first + i] )
+                   : TRAJ_X( t, job->plain[first + i] );
+           for( n = 0; n < len; n++ )
+              buf[(pad + n) * width + 2 * i + k] = col[n];
+         }
+    smo_rows( &job->c[job->plain[first]], buf, tmp, len, pad, width );
+    for( i = 0; i < count; i++ )
+       for( k = 0; k < 2; k++ )
+         {
+           col = k ? TRAJ_Y( t, job->plain[first + i] )
+                   : TRAJ_X( t, job->plain[first + i] );
+           for( n = 0; n < len; n++ )
+              col[n] = buf[(pad + n) * width + 2 * i + k];
+         }
+    free( buf );
+}
+
+
+/* smo_gapped - Filters each visible run of joint "j" separately (a
+ * joint with no gaps is one run).
+ */
+static void smo_gapped( SMOJOB *job, int j )
+{
+    TRAJECT *t = job->t;
+    double *buf, *tmp, *x, *y;
+    long n, start, len, pad;
+
+    x = TRAJ_X( t, j );
+    y = TRAJ_Y( t, j );
+    buf = (double *) smo_alloc( 4 * (t->numframes + 2 * SMO_PAD),
+                                sizeof(double) );
+    tmp = buf + 2 * (t->numframes + 2 * SMO_PAD);
+
+    for( start = 0; start < t->numframes; start = n )
+      {
+        while( start < t->numframes && !TRAJ_OK( t, j, start ) )
+           start++;
+        for( n = start; n < t->numframes && TRAJ_OK( t, j, n ); n++ )
+          ;
+        len = n - start;
+        if( len < 3 )               /* too short to filter */
+           continue;
+        pad = smo_padlen( len );
+        for( n = start; n < start + len; n++ )
+          {
+            buf[2 * (pad + n - start)] = x[n];
+            buf[2 * (pad + n - start) + 1] = y[n];
+          }
+        smo_rows( &job->c[j], buf, tmp, len, pad, 2 );
+        for( n = start; n < start + len; n++ )
+          {
+            x[n] = buf[2 * (pad + n - start)];
+            y[n] = buf[2 * (pad + n - start) + 1];
+          }
+      }
+    free( buf );
+}
+
+
+/* smo_task - Task "i": a group of gap free joints, then the gapped
+ * joints one each.
+ */
+static void smo_task( void *arg, long i )
+{
+    SMOJOB *job = (SMOJOB *) arg;
+
+    if( i < job->ngroups )
+       smo_group( job, i );
+    else
+       smo_gapped( job, job->gapped[i - job->ngroups] );
+}
+
+
+/* smo_coeffs - Works out the coefficients of one pass for a two pass
+ * cutoff of "cutoff" Hz at "rate" samples per second.
+ *
+ * Return: 0 on success, -1 if the cutoff is not below the corrected
+ *         Nyquist frequency
+ */
+int smo_coeffs( double cutoff, double rate, SMOCOEF *c )
+{
+    double wc, k1, k2, k3;
+
+    if( cutoff <= 0.0 || cutoff / SMO_PASSES >= rate / 2.0 )
+       return -1;
+    wc = tan( PI * cutoff / rate ) / SMO_PASSES;
+    k1 = sqrt( 2.0 ) * wc;
+    k2 = wc * wc;
+    c->a0 = k2 / (1.0 + k1 + k2);
+    c->a1 = 2.0 * c->a0;
+    c->a2 = c->a0;
+    k3 = 2.0 * c->a0 / k2;
+    c->b1 = -2.0 * c->a0 + k3;
+    c->b2 = 1.0 - 2.0 * c->a0 - k3;
+    return 0;
+}
+
+
+/* smo_series - Smooths the "len" samples of "x" into "y" (which may be
+ * "x"), padding both ends.  Runs of fewer than 3 samples are copied.
+ */
+void smo_series( const SMOCOEF *c, const double *x, double *y, long len )
+{
+    double *buf;
+    long n, pad;
+
+    if( len < 3 )
+      {
+        for( n = 0; n < len; n++ )
+           y[n] = x[n];
+        return;
+      }
+    pad = smo_padlen( len );
+    buf = (double *) smo_alloc( 2 * (len + 2 * pad), sizeof(double) );
+    for( n = 0; n < len; n++ )
+       buf[pad + n] = x[n];
+    smo_rows( c, buf, buf + len + 2 * pad, len, pad, 1 );
+    for( n = 0; n < len; n++ )
+       y[n] = buf[pad + n];
+    free( buf );
+}
+
+
+/* smo_filter - Smooths every joint of "t" in place at "cutoff" Hz,
+ * the sample rate following from the session's skip, using up to
+ * "nthreads" threads (0 = one per processor).
+ *
+ * Return: 0 on success, -1 if the cutoff is too high for the rate
+ */
+int smo_filter( TRAJECT *t, double cutoff, int nthreads )
+{
+    SMOJOB job;
+    int j;
+
+    job.c = (SMOCOEF *) smo_alloc( (long) t->numjoints, sizeof(SMOCOEF) );
+    if( smo_coeffs( cutoff, 1.0 / kin_interval( t ), &job.c[0] ) < 0 )
+      {
+        free( job.c );
+        return -1;
+      }
+    for( j = 1; j < t->numjoints; j++ )
+       job.c[j] = job.c[0];
+    job.t = t;
+    job.plain = (int *) smo_alloc( (long) t->numjoints, sizeof(int) );
+    job.gapped = (int *) smo_alloc( (long) t->numjoints, sizeof(int) );
+    job.nplain = job.ngapped = 0;
+    for( j = 0; j < t->numjoints; j++ )
+       if( smo_plain( t, j ) )
+          job.plain[job.nplain++] = j;
+       else
+          job.gapped[job.ngapped++] = j;
+    job.ngroups = (job.nplain + SMO_GROUP - 1) / SMO_GROUP;
+
+    if( t->numframes >= 3 )
+       work_run( job.ngroups + job.ngapped, smo_task, &job, nthreads );
+
+    free( job.c );
+    free( job.plain );
+    free( job.gapped );
+    return 0;
+}
+
+
+/* smo_joints - Smooths joint j of "t" in place at cutoff[j] Hz, each
+ * joint a task of its own.  A joint whose cutoff is zero or negative
+ * is left as it is.
+ *
+ * Return: 0 on success, -1 if a cutoff is too high for the rate
+ */
+int smo_joints( TRAJECT *t, const double *cutoff, int nthreads )
+{
+    SMOJOB job;
+    int j;
+
+    job.c = (SMOCOEF *) smo_alloc( (long) t->numjoints, sizeof(SMOCOEF) );
+    job.t = t;
+    job.plain = NULL;
+    job.nplain = 0;
+    job.ngroups = 0;
+    job.gapped = (int *) smo_alloc( (long) t->numjoints, sizeof(int) );
+    job.ngapped = 0;
+    for( j = 0; j < t->numjoints; j++ )
+      {
+        if( cutoff[j] <= 0.0 )
+           continue;
+        if( smo_coeffs( cutoff[j], 1.0 / kin_interval( t ), &job.c[j] ) < 0 )
+          {
+            free( job.c );
+            free( job.gapped );
+            return -1;
+          }
+        job.gapped[job.ngapped++] = j;
+      }
+
+    if( t->numframes >= 3 )
+       work_run( (long) job.ngapped, smo_task, &job, nthreads );
+
+    free( job.c );
+    free( job.gapped );
+    return 0;
+}
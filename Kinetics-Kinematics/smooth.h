@@ -0,0 +1,41 @@
+/* SMOOTH.H
+ *
+ * Zero lag low-pass smoothing of digitized coordinates.  A second
+ * order Butterworth filter is run forward and then backward over each
+ * column, which cancels its phase lag and gives a fourth order
+ * response.  The cutoff is corrected for the second pass (SMO_PASSES)
+ * so that the two passes together are 3 dB down at the cutoff asked
+ * for.
+ *
+ * Each visible run of a joint is filtered on its own, so hidden points
+ * stay hidden and never leak into their neighbours.  Runs are padded
+ * at both ends with up to SMO_PAD fields reflected through the end
+ * point to keep the start up transient out of the data.
+ */
+
+/* Include only once */
+#ifndef SMOOTH_H
+#define SMOOTH_H
+
+#include "traject.h"
+
+#define SMO_PAD     30          /* Reflected fields added at each end   */
+#define SMO_PASSES  0.802       /* Cutoff correction for two passes     */
+#define SMO_GROUP   8           /* Gap free joints filtered side by side */
+
+/* Difference equation coefficients:
+ *   y[n] = a0 x[n] + a1 x[n-1] + a2 x[n-2] + b1 y[n-1] + b2 y[n-2]
+ */
+typedef struct _SMOCOEF
+{
+    double  a0, a1, a2;
+    double  b1, b2;
+} SMOCOEF;
+
+/* Public smoothing functions */
+int  smo_coeffs( double cutoff, double rate, SMOCOEF *c );
+void smo_series( const SMOCOEF *c, const double *x, double *y, long len );
+int  smo_filter( TRAJECT *t, double cutoff, int nthreads );
+int  smo_joints( TRAJECT *t, const double *cutoff, int nthreads );
+
+#endif /* SMOOTH_H */
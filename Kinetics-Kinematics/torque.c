@@ -7,6 +7,24 @@
    Program opens both "BEDAS" output file and the "*.dta" file
    (from "ankle.c" ) and combines them to develop a torque file
    ( "*.tor" ).
+
+   The "*.dta" points are read once into a columnar trajectory
+   store (traject.c in ..\VideoCapture).  Both files are read with
+   the buffered scanner (txtscan.c).  The fin angle of every record
+   is found in one pass by the angle engine (angles.c).
+
+   The whole force file is read, then resampled at the record times
+   (align.c), so the plate can run at any rate, not just a whole
+   multiple of the records.  If the starts were not in step, give the
+   record where a sync event is seen and the force channel and level
+   that mark it in the force file.
+
+   Each "*.tor" line is:  fin  fy  fz  gamma  rel_gamma  torque,
+   ready for the torque-angle fit (finfit.c).  Compile with:
+
+         cl /AL /I..\VideoCapture torque.c angles.c align.c
+            ..\VideoCapture\traject.c ..\VideoCapture\txtscan.c
+            ..\VideoCapture\worker.c
 */
 
 #include <stdio.h>
@@ -16,8 +34,13 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <alloc.h>
+#include "traject.h"
+#include "txtscan.h"
+#include "angles.h"
+#include "align.h"
 
 #define PI 3.14159265
+#define RECRATE 60.0        /* records per second */
 
 void open_files( void );
 void input_data( void );
@@ -26,35 +49,26 @@ void calculate( void );
 void save_data( void );
 void all_done( void );
 
-int n, end, fin;
+int n, end, fin, zeroed;
 double fy, fz, gamma, rel_gamma, zero_angle, torque;
 
 
 
-struct jttype
-{
-   double y, z;
-};
-
-typedef struct frametype
-{
-   struct jttype joint[6];
-} FRAMETYPE;
-
-typedef struct frametype FRAME;
-
-FRAME *f;
+TRAJECT *t;         /* joint y in TRAJ_X columns, z in TRAJ_Y columns */
+ANGLES *fin_angle;  /* heel-toe line to toe-fin line, every record */
+SIGNAL *force;      /* force channels, one sample per record */
 
 FILE *fpSESS, *fpNEW, *fpFORCE;
+TXTSCAN *tsSESS, *tsFORCE;
 
 main()
 {
    open_files();
+   convert();
    for( n = 0; n < end; n++)
     {
 /*      printf("\n%d ", n ); */
       input_data();
-      convert();
       calculate();
       save_data();
 /*      printf("%d", n );        */
@@ -63,34 +77,14 @@ main()
 }
 
 
-FRAME *create_frame( void )
-{
-   int i;
-   FRAME *f;
-
-   f = (FRAME *) malloc( sizeof(FRAME) );
-   if( f == NULL )
-     {
-       printf( "Error:  Can't allocate memory.\n" );
-       exit( 1 );
-     }
-   else
-     {
-       for( i = 0; i < 6; i++)
-         {
-            f->joint[i].y = 0;
-            f->joint[i].z = 0;
-          }
-     }
-   return f;
-}
-
-
 void open_files( void )
 {
-   int i, length;
-   char datafile[9], name[9], string[40],
+   int length, method, chan;
+   long rec, fins, sync;
+   double rate, level, offset;
+   char datafile[9], name[9],
            forcefile[28], sessfile[28], newdatafile[28];
+   SIGNAL *plate;
 
    printf("Enter the name of the datafile (no extension): ");
    scanf( "%8s", &datafile);
@@ -100,7 +94,6 @@ void open_files( void )
    strcat (sessfile, ".DTA");
    if ((fpSESS = fopen( sessfile, "r")) == NULL )
       printf("\nDatafile not found.");
-   f = create_frame();
    strcpy ( newdatafile, "F:\\TORQUE.DAT\\");
    strncat ( newdatafile, datafile, length + 1 );
    strcat ( newdatafile, ".TOR");
@@ -110,43 +103,64 @@ void open_files( void )
    strcat ( forcefile, datafile );
    if ((fpFORCE = fopen( forcefile, "r" )) == NULL )
       printf( "\nForce datafile not opened." );
-   fscanf( fpSESS, "%s\n%d\n%d\n", &name, &end, &fin );
-   for ( i = 0; i < 74; i++ )
-      fscanf( fpFORCE, "\n%s", string );
-
+   tsSESS = txt_open( fpSESS );
+   tsFORCE = txt_open( fpFORCE );
+   txt_word( tsSESS, name, sizeof(name) );
+   txt_long( tsSESS, &rec );
+   txt_long( tsSESS, &fins );
+   end = (int) rec;
+   fin = (int) fins;
+   t = traj_create( 6, end );
+   if ( txt_traject( tsSESS, t, (long) end, TXT_DAT ) < end )
+     {
+      printf( "\nOnly %ld records in datafile.", t->numframes );
+      end = (int) t->numframes;
+     }
+   txt_skip( tsFORCE, (long) TXT_BEDASHEAD );
+
+   printf("\nForce plate samples per second (300 for the old plate): ");
+   scanf( "%lf", &rate );
+   printf("\nInterpolation, 0 linear or 1 sinc: ");
+   scanf( "%d", &method );
+   printf("\nRecord of the sync event (-1 if the starts are in step): ");
+   scanf( "%ld", &sync );
+   plate = sig_create( TXT_BEDASCHAN, 0L, rate, 0.0 );
+   aln_read( plate, tsFORCE );
+   offset = 0.0;
+   if ( sync >= 0 )
+     {
+      printf("\nForce channel (1-6) and level of the sync event: ");
+      scanf( "%d %lf", &chan, &level );
+      if (( chan < 1 ) || ( chan > TXT_BEDASCHAN )
+          || (( offset = aln_onset( plate, chan - 1, level )) < 0.0 ))
+        {
+         printf( "\nSync event not found, starts taken as in step." );
+         offset = 0.0;
+        }
+      else
+         offset -= sync / RECRATE;
+     }
+   force = aln_resample( plate, RECRATE, 0.0, (long) end, offset,
+                         ( method == 1 ) ? ALN_SINC : ALN_LINEAR );
+   sig_free( plate );
 }
 
 
 void input_data( void )
 {
-   int i;
-   double temp, fx, mx, my, mz;
-
-   if ( n == 0 )
-   {
-    fscanf( fpFORCE, "%lf%lf%lf%lf%lf%lf",
-      &fx, &fy, &fz, &mx, &my, &mz );
-    for ( i = 0; i < 6; i++ )
-      fscanf( fpSESS, "%lf%lf", &f->joint[i].y, &f->joint[i].z);
-   }
-   else if ( n > 0 )
-   {
-    for ( i = 0; i < 24; i++ )
-       fscanf( fpFORCE, "%lf", &temp );
-    fscanf( fpFORCE, "%lf%lf%lf%lf%lf%lf",
-               &fx, &fy, &fz, &mx, &my, &mz );
-    i = 0;
-    fscanf( fpSESS, "\n%lf%lf", &f->joint[i].y, &f->joint[i].z);
-    for ( i = 1; i < 6; i++ )
-       fscanf( fpSESS, "%lf%lf", &f->joint[i].y, &f->joint[i].z);
-   }
+   double fx, mx, my, mz;
+
+              /* The plate resampled at this record's time */
+   fx = SIG_COL( force, 0 )[n];  fy = SIG_COL( force, 1 )[n];
+   fz = SIG_COL( force, 2 )[n];  mx = SIG_COL( force, 3 )[n];
+   my = SIG_COL( force, 4 )[n];  mz = SIG_COL( force, 5 )[n];
 /*
      printf( "\nForce - Moment values:\n" );
      printf( "%5.2lf%7.2lf%7.2lf%7.2lf%7.2lf%7.2lf",
         fx, fy, fz, mx, my, mz );
      printf( "\nData Points \(1 - 6\) \n" );
      for ( i = 0; i < 6; i++)
-        printf( "%3.0lf %4.0lf   ", f->joint[i].y, f->joint[i].z );
+        printf( "%3.0lf %4.0lf   ", TRAJ_X( t, i )[n], TRAJ_Y( t, i )[n] );
      getchar();
 */
 }
@@ -154,34 +168,50 @@ void input_data( void )
 
 void convert( void )
 {
+   static ANGSPEC fin_spec = { ANG_JOINT, 0, 2, 2, 4 };
    int i;
-   double cfactor = 0.00318;
+   long k;
+   double *y, *z, cfactor = 0.00318;
 
                    /* Converting data from pixels to centimeters */
+           /* and moving origin from lower left to lower right, */
+                          /* one joint column over every record */
    for ( i = 0; i < 6; i++ )
      {
-        f->joint[i].y = ( f->joint[i].y * cfactor * 100);
-        f->joint[i].z = ( f->joint[i].z * cfactor * 100);
+        y = TRAJ_X( t, i );
+        z = TRAJ_Y( t, i );
+        for ( k = 0; k < t->numframes; k++ )
+          {
+             y[k] = ( 640 - ( y[k] * cfactor * 100));
+             z[k] = ( z[k] * cfactor * 100);
+          }
      }
 
-           /* Moving origin from lower left to lower right */
-   for ( i = 0; i < 6; i++ )
-     f->joint[i].y = ( 640 - f->joint[i].y );
-
+   fin_angle = ang_compute( t, &fin_spec, 1, 1, 0 );
 }
 
 
 void calculate( void)
 {
-   double y1, z1, y2, z2, y3, z3, alpha, beta;
+   double y1, z1, y2, z2, y3, z3;
+
+        /* A hidden heel, toe or fin point leaves no angle or torque */
+
+   if ( !( TRAJ_OK( t, 0, n ) & TRAJ_OK( t, 2, n ) & TRAJ_OK( t, 4, n )))
+     {
+      gamma = rel_gamma = TRAJ_HIDDEN;
+      torque = 0.0;
+      printf( "\nRecord %d has a hidden point.", n );
+      return;
+     }
 
 
    /* First, finding the angle between ankle, toe, and fin */
 
         /* Finding the coordinate change from heel to toe */
 
-   y1 = ( f->joint[2].y - f->joint[0].y );
-   z1 = ( f->joint[2].z - f->joint[0].z );
+   y1 = ( TRAJ_X( t, 2 )[n] - TRAJ_X( t, 0 )[n] );
+   z1 = ( TRAJ_Y( t, 2 )[n] - TRAJ_Y( t, 0 )[n] );
 
    if (( y1 < 0 ) && ( z1 > 0 ))
       {
@@ -193,8 +223,8 @@ void calculate( void)
 
        /* Finding the coordinate change from toe to fin */
 
-   y2 = ( f->joint[4].y - f->joint[2].y );
-   z2 = ( f->joint[4].z - f->joint[2].z );
+   y2 = ( TRAJ_X( t, 4 )[n] - TRAJ_X( t, 2 )[n] );
+   z2 = ( TRAJ_Y( t, 4 )[n] - TRAJ_Y( t, 2 )[n] );
    if (( y2 < 0 ) || ( z2 > 0 ))
       {
         printf( "\n\nERROR 2 IN FIN ORIENTATION !! ( Line : %d", n );
@@ -203,34 +233,17 @@ void calculate( void)
         exit( 2 );
       }
 
-                /* Testing for the fin orientation */
-
-   if ( y1 == 0 )
-     alpha = 0;
-
-   if ( z1 == 0 )
-     alpha = 0;
-
-   if ( y2 == 0 )
-     beta = ( PI / 2 );
-
-   if ( z2 == 0 )
-      beta = 0;
+             /* The fin's turn from the heel-toe line, unwrapped */
 
-   if (( y1 != 0 ) && ( z1 != 0 ))
-      alpha = atan2( z1, y1 );
+   gamma = ( 180 - ( ANG_COL( fin_angle, 0 )[n] * 180 / PI ));
 
-   if (( y2 != 0 ) && ( z2 != 0 ))
-      beta = atan2( z2, y2 );
-
-   if ((( y1 > 0 ) && ( z1 > 0 )) || (( y1 > 0 ) && ( z1 < 0 )))
-      gamma = ( 360 - (( PI + beta - alpha ) * 180 / PI ));
-   else if (( y1 < 0 ) && ( z1 < 0 ))
-      gamma = (( 180 - ( beta - alpha ) * 180 / PI ));
-
-   if ( n == 0 )
+   if ( !zeroed )                /* first record with every point */
+     {
       zero_angle = gamma;
-   else if ( n > 0 )
+      rel_gamma = 0.0;
+      zeroed = 1;
+     }
+   else
       rel_gamma = ( zero_angle - gamma );
 
 
@@ -238,8 +251,8 @@ void calculate( void)
 
                                /* Finally, finding the torque */
 
-   y3 = ( f->joint[4].y - f->joint[0].y );
-   z3 = ( f->joint[4].z - f->joint[0].z );
+   y3 = ( TRAJ_X( t, 4 )[n] - TRAJ_X( t, 0 )[n] );
+   z3 = ( TRAJ_Y( t, 4 )[n] - TRAJ_Y( t, 0 )[n] );
 
                                /* Torque in NEWTON METERS */
 
@@ -257,15 +270,20 @@ void save_data( void )
 {
    int i;
 
-   fprintf( fpNEW, "%d%10.3lf%10.3lf%10.3lf%10.3lf\n", 
-                             fin, fy, fz, gamma, rel_gamma );       
+   fprintf( fpNEW, "%d%10.3lf%10.3lf%10.3lf%10.3lf%10.3lf\n",
+                             fin, fy, fz, gamma, rel_gamma, torque );
 }       
 
 void all_done( void )
 {
    fclose( fpNEW );
+   txt_close( tsSESS );
+   txt_close( tsFORCE );
    fclose( fpSESS );
    fclose( fpFORCE );
+   ang_free( fin_angle );
+   sig_free( force );
+   traj_free( t );
    printf("\n\nAll Done !\n");
 }
 
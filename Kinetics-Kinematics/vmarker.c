@@ -0,0 +1,144 @@
+/**************************************************************************
+ *  VMARKER.C
+ *
+ * Virtual marker reconstruction. The following functions are public:
+ *
+ *   vm_build       -   Places every virtual marker in every field
+ *
+ * Each virtual marker is a task for the worker pool (worker.c).  The
+ * cross and dot sums are built one real marker at a time down whole
+ * columns, then the rotation is applied down the columns in one more
+ * pass; every loop is branch free over contiguous memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "vmarker.h"
+#include "worker.h"
+
+/* Shared arguments of the per marker tasks */
+typedef struct _VMJOB
+{
+    TRAJECT       *t;
+    const VMARKER *vm;
+    TRAJECT       *out;
+} VMJOB;
+
+/* Prototypes for internal functions */
+static void *vm_alloc( long n, size_t size );
+static void  vm_task( void *arg, long i );
+
+
+/* vm_alloc - Allocates "n" items of "size" bytes or exits.
+ */
+static void *vm_alloc( long n, size_t size )
+{
+    void *p;
+
+    p = malloc( (size_t) (n > 0 ? n : 1) * size );
+    if( p == NULL )
+      {
+        printf( "Error:  vm_alloc()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return p;
+}
+
+
+/* vm_task - Task: virtual marker "i" over every field.
+ */
+static void vm_task( void *arg, long i )
+{
+    VMJOB *job = (VMJOB *) arg;
+    TRAJECT *t = job->t;
+    const VMARKER *v = job->vm + i;
+    double *cr, *dt, *x0, *y0, *xk, *yk, *ox, *oy, dx, dy, len, c, s;
+    unsigned char *m, *mk;
+    long n, b, bytes;
+    int k;
+
+    cr = (double *) vm_alloc( 2 * t->numframes, sizeof(double) );
+    dt = cr + t->numframes;
+    x0 = TRAJ_X( t, v->real[0] );
+    y0 = TRAJ_Y( t, v->real[0] );
+    ox = TRAJ_X( job->out, (int) i );
+    oy = TRAJ_Y( job->out, (int) i );
+    m = TRAJ_MASK( job->out, (int) i );
+    bytes = (t->numframes + 7) >> 3;
+
+    for( b = 0; b < bytes; b++ )
+       m[b] = TRAJ_MASK( t, v->real[0] )[b];
+    for( n = 0; n < t->numframes; n++ )
+       cr[n] = dt[n] = 0.0;
+    for( k = 1; k < v->nreal; k++ )     /* sums over the real markers */
+      {
+        xk = TRAJ_X( t, v->real[k] );
+        yk = TRAJ_Y( t, v->real[k] );
+        mk = TRAJ_MASK( t, v->real[k] );
+        for( n = 0; n < t->numframes; n++ )
+          {
+            dx = xk[n] - x0[n];
+            dy = yk[n] - y0[n];
+            cr[n] += v->rx[k] * dy - v->ry[k] * dx;
+            dt[n] += v->rx[k] * dx + v->ry[k] * dy;
+          }
+        for( b = 0; b < bytes; b++ )
+           m[b] &= mk[b];
+      }
+
+    for( n = 0; n < t->numframes; n++ )  /* rotate into the field */
+      {
+        len = sqrt( cr[n] * cr[n] + dt[n] * dt[n] );
+        len += (len == 0.0);                    /* hidden: stays 0 */
+        c = dt[n] / len;
+        s = cr[n] / len;
+        ox[n] = x0[n] + c * v->vx - s * v->vy;
+        oy[n] = y0[n] + s * v->vx + c * v->vy;
+      }
+    for( n = 0; n < t->numframes; n++ )  /* hidden points hold zero */
+      {
+        c = (double) ((m[n >> 3] >> (n & 7)) & 1);
+        ox[n] *= c;
+        oy[n] *= c;
+      }
+    free( cr );
+}
+
+
+/* vm_build - Places the "numvirtual" virtual markers "vm" in every
+ * field of "t", using up to "nthreads" threads (0 = one per
+ * processor).  Virtual marker i is joint i of the new store, in the
+ * units of "t".
+ *
+ * Return: The virtual markers, or NULL if one names a joint "t"
+ *         doesn't have or has fewer than two real markers
+ */
+TRAJECT *vm_build( TRAJECT *t, const VMARKER *vm, int numvirtual,
+                   int nthreads )
+{
+    TRAJECT *out;
+    VMJOB job;
+    int i, k;
+
+    for( i = 0; i < numvirtual; i++ )
+      {
+        if( vm[i].nreal < 2 || vm[i].nreal > VM_MAXREAL )
+           return NULL;
+        for( k = 0; k < vm[i].nreal; k++ )
+           if( vm[i].real[k] < 0 || vm[i].real[k] >= t->numjoints )
+              return NULL;
+      }
+
+    out = traj_create( numvirtual, t->numframes );
+    out->skip = t->skip;
+    out->cfactor = t->cfactor;
+    while( out->numframes < t->numframes )
+       traj_append( out );
+
+    job.t = t;
+    job.vm = vm;
+    job.out = out;
+    work_run( (long) numvirtual, vm_task, &job, nthreads );
+    return out;
+}
@@ -0,0 +1,39 @@
+/* VMARKER.H
+ *
+ * Virtual markers: points that can't be digitized (the ankle inside a
+ * fin, a joint centre) placed at fixed offsets from markers that can.
+ * Each virtual marker has a local frame built from two or more real
+ * markers.  The first real marker is the origin; the frame is turned
+ * to best fit the rest (least squares rotation about the origin) to
+ * where they are in each field.  With two real markers that is simply
+ * the direction from the first to the second.
+ *
+ * The rotation is found from the summed cross and dot products of the
+ * local and field offsets, normalized, so there are no quadrants and
+ * no trig in the per field loops; any orientation works.  A virtual
+ * marker is visible in a field only when all of its real markers are.
+ */
+
+/* Include only once */
+#ifndef VMARKER_H
+#define VMARKER_H
+
+#include "traject.h"
+
+#define VM_MAXREAL  8           /* Most real markers in one frame       */
+
+/* One virtual marker */
+typedef struct _VMARKER
+{
+    int     nreal;              /* Real markers in the frame, 2 or more */
+    int     real[VM_MAXREAL];   /* Their joints, the origin first       */
+    double  rx[VM_MAXREAL];     /* Their local positions (the origin's  */
+    double  ry[VM_MAXREAL];     /*   is taken as 0,0)                   */
+    double  vx, vy;             /* Local position of the virtual marker */
+} VMARKER;
+
+/* Public virtual marker functions */
+TRAJECT *vm_build( TRAJECT *t, const VMARKER *vm, int numvirtual,
+                   int nthreads );
+
+#endif /* VMARKER_H */
@@ -0,0 +1,136 @@
+/**************************************************************************
+ *  ARENA.C
+ *
+ * Session scoped memory. The following functions are public:
+ *
+ *   arena_create   -   Creates an empty arena
+ *   arena_alloc    -   Carves zeroed, aligned memory from the arena
+ *   arena_strdup   -   Copies a string into the arena
+ *   arena_mark     -   Remembers the current top of the arena
+ *   arena_release  -   Gives back everything allocated after a mark
+ *   arena_free     -   Releases the arena and all of its memory at once
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/* Header size, rounded so the first allocation is aligned */
+#define ARENA_HEAD  (((long) sizeof(ARENABLK) + ARENA_ALIGN - 1) \
+                     & ~(long) (ARENA_ALIGN - 1))
+#define ARENA_DATA( b )  ((char *) (b) + ARENA_HEAD)
+
+
+/* arena_create - Creates an arena that grows "blocksize" bytes at a
+ * time (ARENA_BLOCK if zero).  No block is allocated until needed.
+ *
+ * Return: The new arena
+ */
+ARENA *arena_create( long blocksize )
+{
+    ARENA *a;
+
+    a = (ARENA *) malloc( sizeof(ARENA) );
+    if( a == NULL )
+      {
+        printf( "Error:  arena_create()  malloc failed.\n" );
+        exit( 1 );
+      }
+    a->top = NULL;
+    a->blocksize = (blocksize > 0) ? blocksize : ARENA_BLOCK;
+    return a;
+}
+
+
+/* arena_alloc - Returns "size" bytes of zeroed memory, aligned to
+ * ARENA_ALIGN, that live until the arena is freed or released past.
+ *
+ * Return: Pointer to the memory
+ */
+void *arena_alloc( ARENA *a, long size )
+{
+    ARENABLK *b;
+    long need;
+    char *p;
+
+    size = (size + ARENA_ALIGN - 1) & ~(long) (ARENA_ALIGN - 1);
+    b = a->top;
+    if( b == NULL || b->used + size > b->size )
+      {
+        need = (size > a->blocksize) ? size : a->blocksize;
+        b = (ARENABLK *) malloc( (size_t) (ARENA_HEAD + need) );
+        if( b == NULL )
+          {
+            printf( "Error:  arena_alloc()  malloc failed.\n" );
+            exit( 1 );
+          }
+        b->prev = a->top;
+        b->size = need;
+        b->used = 0;
+        a->top = b;
+      }
+    p = ARENA_DATA( b ) + b->used;
+    b->used += size;
+    memset( p, 0, (size_t) size );
+    return p;
+}
+
+
+/* arena_strdup - Copies "s" into the arena.
+ *
+ * Return: Pointer to the copy
+ */
+char *arena_strdup( ARENA *a, const char *s )
+{
+    char *p;
+
+    p = (char *) arena_alloc( a, (long) strlen( s ) + 1 );
+    strcpy( p, s );
+    return p;
+}
+
+
+/* arena_mark - Records the top of "a" in "m" for arena_release().
+ */
+void arena_mark( ARENA *a, ARENAMARK *m )
+{
+    m->top = a->top;
+    m->used = (a->top != NULL) ? a->top->used : 0;
+}
+
+
+/* arena_release - Frees the blocks allocated since "m" was taken and
+ * rewinds the block that was on top at the time.  Everything carved
+ * out after the mark becomes invalid.
+ */
+void arena_release( ARENA *a, ARENAMARK *m )
+{
+    ARENABLK *b;
+
+    while( a->top != NULL && a->top != m->top )
+      {
+        b = a->top;
+        a->top = b->prev;
+        free( b );
+      }
+    if( a->top != NULL )
+       a->top->used = m->used;
+}
+
+
+/* arena_free - Frees every block and the arena itself.
+ */
+void arena_free( ARENA *a )
+{
+    ARENABLK *b;
+
+    if( a == NULL )
+       return;
+    while( (b = a->top) != NULL )
+      {
+        a->top = b->prev;
+        free( b );
+      }
+    free( a );
+}
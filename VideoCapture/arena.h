@@ -0,0 +1,50 @@
+/* ARENA.H
+ *
+ * Session arena.  Everything whose lifetime is one digitizing session
+ * (joint names, frames, scratch space) is carved out of a chain of
+ * blocks and released together, instead of being malloc'ed and freed
+ * piece by piece.  A mark taken with arena_mark() lets a caller hand
+ * back everything allocated after it, so per-call scratch costs no
+ * heap traffic once the blocks exist.
+ *
+ * Blocks are kept under 64K so that the large model malloc() can
+ * supply them; a request bigger than the block size gets a block of
+ * its own.
+ */
+
+/* Include only once */
+#ifndef ARENA_H
+#define ARENA_H
+
+#define ARENA_BLOCK   8192      /* Default block size in bytes          */
+#define ARENA_ALIGN   8         /* Alignment of every allocation        */
+
+typedef struct _ARENABLK
+{
+    struct _ARENABLK *prev;     /* Block allocated before this one      */
+    long    size;               /* Usable bytes after the header        */
+    long    used;               /* Bytes handed out                     */
+} ARENABLK;
+
+typedef struct _ARENA
+{
+    ARENABLK *top;              /* Block currently being carved         */
+    long    blocksize;
+} ARENA;
+
+/* A position to release back to */
+typedef struct _ARENAMARK
+{
+    ARENABLK *top;
+    long    used;
+} ARENAMARK;
+
+/* Public arena functions */
+ARENA *arena_create( long blocksize );
+void  *arena_alloc( ARENA *a, long size );
+char  *arena_strdup( ARENA *a, const char *s );
+void   arena_mark( ARENA *a, ARENAMARK *m );
+void   arena_release( ARENA *a, ARENAMARK *m );
+void   arena_free( ARENA *a );
+
+#endif /* ARENA_H */
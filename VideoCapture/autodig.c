@@ -0,0 +1,254 @@
+/**************************************************************************
+ *  AUTODIG.C
+ *
+ * Auto digitizing of recorded clips. The following functions are
+ * public:
+ *
+ *   adig_run       -   Tracks every joint through a set of clips
+ *   adig_save      -   Writes a clip's scores to a text file
+ *   adig_free      -   Frees a clip's scores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "autodig.h"
+#include "track.h"
+#include "worker.h"
+
+/* Shared state of one adig_run() call */
+typedef struct _ADIGJOB
+{
+    ADIGCLIP *clips;
+    int     reach;
+    int     per;                /* Joints in a task                     */
+    int     groups;             /* Tasks in a clip                      */
+} ADIGJOB;
+
+/* Prototypes for internal functions */
+static int  adig_field( ADIGCLIP *c, long n, TRKFIELD *f );
+static void adig_task( void *arg, long i );
+
+
+/* adig_field - Points "f" at field "n" of clip "c".
+ *
+ * Return: 1, or 0 if the field is missing, was dropped or is more
+ *         than a TRKFIELD can reach
+ */
+static int adig_field( ADIGCLIP *c, long n, TRKFIELD *f )
+{
+    FSRCPIX p = NULL;
+
+    if( FSRC_REACH( c->src ) <= FSRC_FARMAX )   /* f->pix isn't huge */
+       p = fsrc_field( c->src, c->first + n * c->step );
+    f->pix = (const unsigned char *) p;
+    f->width = c->src->width;
+    f->height = c->src->height;
+    f->pitch = c->src->pitch;
+    return f->pix != NULL;
+}
+
+
+/* adig_task - Tracks task "i"'s joints through its clip, a field at a
+ * time.  Each task has trackers of its own and writes only its own
+ * joints' columns, masks and scores.
+ */
+static void adig_task( void *arg, long i )
+{
+    ADIGJOB *job = (ADIGJOB *) arg;
+    ADIGCLIP *c;
+    TRACKER *t, *anchor;
+    TRKFIELD f;
+    int *lastx, *lasty;
+    int lo, hi, j, k, x, y, ax, ay, s, seen;
+    long n;
+
+    c = &job->clips[i / job->groups];
+    lo = (int) (i % job->groups) * job->per;
+    hi = lo + job->per;
+    if( hi > c->traj->numjoints )
+       hi = c->traj->numjoints;
+    if( lo >= hi )
+       return;                      /* a clip with fewer joints */
+    t = trk_open( hi - lo, TRK_HALF, job->reach );
+    anchor = trk_open( hi - lo, TRK_HALF, ADIG_ANCHOR );
+    lastx = (int *) malloc( (hi - lo) * sizeof(int) );
+    lasty = (int *) malloc( (hi - lo) * sizeof(int) );
+    if( lastx == NULL || lasty == NULL )
+      {
+        printf( "Error:  adig_run()  malloc failed.\n" );
+        exit( 1 );
+      }
+
+    /* The hand digitized field gives the templates */
+    seen = adig_field( c, 0L, &f );
+    for( j = lo, k = 0; j < hi; j++, k++ )
+      {
+        lastx[k] = lasty[k] = 0;
+        c->score[j][0] = 0;
+        if( !TRAJ_OK( c->traj, j, c->row ) )
+           continue;
+        lastx[k] = (int) TRAJ_X( c->traj, j )[c->row];
+        lasty[k] = (int) TRAJ_Y( c->traj, j )[c->row];
+        c->score[j][0] = TRK_SCALE;
+        if( seen )
+          {
+            trk_learn( t, k, &f, lastx[k], lasty[k] );
+            trk_learn( anchor, k, &f, lastx[k], lasty[k] );
+          }
+      }
+
+    for( n = 1; n < c->count; n++ )
+      {
+        seen = adig_field( c, n, &f );
+        for( j = lo, k = 0; j < hi; j++, k++ )
+          {
+            x = lastx[k];
+            y = lasty[k];
+            s = seen ? trk_find( t, k, &f, &x, &y ) : -1;
+            c->score[j][n] = (short) ((s > 0) ? s : 0);
+            if( s < ADIG_LOST )
+              {
+                traj_hide( c->traj, j, c->row + n );
+                continue;
+              }
+            ax = x;
+            ay = y;
+            if( trk_find( anchor, k, &f, &ax, &ay ) >= ADIG_LOST )
+              {                     /* undo the renewed template's drift */
+                x = ax;
+                y = ay;
+              }
+            traj_point( c->traj, j, c->row + n, (double) x, (double) y );
+            lastx[k] = x;
+            lasty[k] = y;
+            if( s >= ADIG_KEEP )
+               trk_learn( t, k, &f, x, y );
+          }
+      }
+
+    free( lastx );
+    free( lasty );
+    trk_close( t );
+    trk_close( anchor );
+}
+
+
+/* adig_run - Digitizes "nclips" clips from their first fields, with
+ * joints looked for "reach" pixels each way of where they were (the
+ * tracker's default if zero), using up to "nthreads" threads (0 = one
+ * per processor).  Each clip's traj gets rows up to row + count - 1
+ * and its score and review are filled in.  Exits if memory cannot be
+ * allocated.
+ */
+void adig_run( ADIGCLIP *clips, int nclips, int reach, int nthreads )
+{
+    ADIGJOB job;
+    ADIGCLIP *c;
+    long n;
+    int i, j, joints, mapped;
+
+    joints = 1;
+    mapped = 1;
+    for( i = 0; i < nclips; i++ )
+      {
+        c = &clips[i];
+        if( c->step < 1 )
+           c->step = 1;
+        if( c->first + (c->count - 1) * c->step >= c->src->fields )
+           c->count = (c->src->fields - 1 - c->first) / c->step + 1;
+        if( c->count < 1 )
+           c->count = 1;
+        while( c->traj->numframes < c->row + c->count )
+           traj_append( c->traj );     /* no growing once threads run */
+        c->score = (short **) calloc( c->traj->numjoints, sizeof(short *) );
+        if( c->score == NULL )
+          {
+            printf( "Error:  adig_run()  malloc failed.\n" );
+            exit( 1 );
+          }
+        for( j = 0; j < c->traj->numjoints; j++ )   /* a column each, as */
+          {                                          /*   the traj has    */
+            c->score[j] = (short *) malloc( (size_t) c->count
+                                            * sizeof(short) );
+            if( c->score[j] == NULL )
+              {
+                printf( "Error:  adig_run()  malloc failed.\n" );
+                exit( 1 );
+              }
+          }
+        if( c->traj->numjoints > joints )
+           joints = c->traj->numjoints;
+        if( !c->src->map.mapped )
+           mapped = 0;
+      }
+
+    job.clips = clips;
+    job.reach = reach;
+    if( mapped )
+      {
+        job.per = 1;                    /* a task for every joint */
+        job.groups = joints;
+      }
+    else
+      {
+        job.per = joints;               /* a task for every clip, */
+        job.groups = 1;                 /*   a field at a time   */
+        nthreads = 1;
+      }
+    work_run( (long) nclips * job.groups, adig_task, &job, nthreads );
+
+    for( i = 0; i < nclips; i++ )
+      {
+        c = &clips[i];
+        c->review = 0L;
+        for( j = 0; j < c->traj->numjoints; j++ )
+           for( n = 1; n < c->count; n++ )
+              if( c->score[j][n] < ADIG_REVIEW )
+                 c->review++;
+      }
+}
+
+
+/* adig_save - Writes clip "c"'s scores to "path": the number of joints,
+ * then a line for each field with the field number in the recording
+ * and every joint's score, 0 to TRK_SCALE, in the order of the .DAT
+ * file's points.
+ *
+ * Return: 0, or -1 if the file can't be written
+ */
+int adig_save( const ADIGCLIP *c, const char *path )
+{
+    FILE *fp;
+    long n;
+    int j;
+
+    if( (fp = fopen( path, "w" )) == NULL )
+       return -1;
+    fprintf( fp, "%d\n", c->traj->numjoints );
+    for( n = 0; n < c->count; n++ )
+      {
+        fprintf( fp, "%07ld", c->first + n * c->step );
+        for( j = 0; j < c->traj->numjoints; j++ )
+           fprintf( fp, " %4d", c->score[j][n] );
+        fprintf( fp, "\n" );
+      }
+    if( fclose( fp ) != 0 )
+       return -1;
+    return 0;
+}
+
+
+/* adig_free - Frees clip "c"'s scores.  The clip's traj is the
+ * caller's.
+ */
+void adig_free( ADIGCLIP *c )
+{
+    int j;
+
+    if( c->score == NULL )
+       return;
+    for( j = 0; j < c->traj->numjoints; j++ )
+       free( c->score[j] );
+    free( c->score );
+    c->score = NULL;
+}
@@ -0,0 +1,62 @@
+/* AUTODIG.H
+ *
+ * Digitizing a whole recorded clip without the operator.  One field of
+ * the clip is digitized by hand; every joint is then tracked (track.c)
+ * from field to field through the rest of it, and each point found is
+ * kept with its tracking score, so the operator need only look over
+ * the points that scored low instead of placing every one.
+ *
+ * A clip is a run of fields of a recording: a camera's footage, or a
+ * stretch of one tape that has its own hand digitized first field.
+ * Each joint's track through a clip depends on nothing but the
+ * recording, so with PUMA_THREADS defined the joints of every clip
+ * are run at once over the worker pool (worker.c).  Threads share a
+ * recording only when it is mapped (FMAP_MMAP); otherwise the clips
+ * run one after another, each a field at a time for all its joints,
+ * so every field is read once.
+ *
+ * A joint is taken as lost when its score falls under ADIG_LOST: the
+ * point is hidden and the joint is looked for around where it was last
+ * seen until it turns up again.  A joint hidden in the first field has
+ * nothing to look for and stays hidden.  The template a joint is
+ * matched against follows it, renewed from every field where it scores
+ * ADIG_KEEP or more.  Renewing lets a template slide a pixel at a time
+ * off the marker, so each point found is matched again, within
+ * ADIG_ANCHOR pixels, against the template from the first field, and
+ * moved to that match while the first template still knows the marker.
+ */
+
+/* Include only once */
+#ifndef AUTODIG_H
+#define AUTODIG_H
+
+#include "traject.h"
+#include "fieldsrc.h"
+
+#define ADIG_KEEP     700       /* Score to renew a joint's template    */
+#define ADIG_LOST     400       /* Under this the point is hidden       */
+#define ADIG_REVIEW   900       /* Under this the operator should look  */
+#define ADIG_ANCHOR   2         /* Pixels the first template may move a */
+                                /*   point                              */
+
+typedef struct _ADIGCLIP
+{
+    FIELDSRC *src;              /* The recording                        */
+    long    first;              /* Its field digitized by hand          */
+    long    step;               /* Fields from one digitized to the next */
+    long    count;              /* Fields to digitize, the first included */
+
+    TRAJECT *traj;              /* Pixel coordinates, rows row to       */
+    long    row;                /*   row + count - 1; row is the hand   */
+                                /*   digitized field, already filled    */
+    short **score;              /* Joint j's score in field n of the    */
+                                /*   clip at score[j][n]                */
+    long    review;             /* Points scored under ADIG_REVIEW      */
+} ADIGCLIP;
+
+/* Public auto digitizing functions */
+void adig_run( ADIGCLIP *clips, int nclips, int reach, int nthreads );
+int  adig_save( const ADIGCLIP *c, const char *path );
+void adig_free( ADIGCLIP *c );
+
+#endif /* AUTODIG_H */
@@ -0,0 +1,398 @@
+/**************************************************************************
+ *  CAPTURE.C
+ *
+ * Capture ring and field writer. The following functions are public:
+ *
+ *   cap_open       -   Allocates the ring and creates the field file
+ *   cap_slot       -   Finds a free slot for the next field
+ *   cap_put        -   Hands a filled slot to the writer
+ *   cap_drop       -   Gives up a slot that couldn't be filled
+ *   cap_skip       -   Counts fields that went by ungrabbed as dropped
+ *   cap_drain      -   Writes waiting fields, without PUMA_THREADS
+ *   cap_close      -   Writes the rest and the index, and reports
+ *
+ * One grabber and one writer share the ring: only the grabber moves
+ * "head" and only the writer moves "tail", each under the lock, and a
+ * slot between them belongs to the writer until "tail" passes it.
+ * The writer alone touches the file and the index.  Compile with
+ * PUMA_THREADS defined (and link -lpthread) for the writer thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "capture.h"
+
+/* A slot's memory.  halloc() gives a block starting a segment, so the
+   CAP_CHUNK byte pieces a field is written in never cross one. */
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+#include <malloc.h>
+#define CAP_ALLOC( n )  ((CAPPIX) halloc( (n), 1 ))
+#define CAP_FREE( p )   hfree( (void _huge *) (p) )
+#else
+#define CAP_ALLOC( n )  ((CAPPIX) malloc( (size_t) (n) ))
+#define CAP_FREE( p )   free( p )
+#endif
+#define CAP_CHUNK       0x8000L
+#define CAP_RESERVE     0x8000L /* Left free by the slots, for stdio    */
+
+/* Prototypes for internal functions */
+static void cap_entry( CAPRING *r, long page, long bytes, const char *tc );
+static int  cap_fwrite( CAPPIX p, long len, FILE *fp );
+static void cap_write( CAPRING *r, long n );
+#ifdef PUMA_THREADS
+static void *cap_writer( void *p );
+#endif
+
+
+/* cap_entry - Adds the next field's entry to the index.
+ */
+static void cap_entry( CAPRING *r, long page, long bytes, const char *tc )
+{
+    FLDINDEX e;
+
+    memset( &e, 0, sizeof(FLDINDEX) );
+    e.page = (FLD_I32) page;
+    e.bytes = (FLD_I32) bytes;
+    if( tc != NULL )
+       strncpy( e.timecode, tc, FLD_TCLEN - 1 );
+    if( fwrite( &e, sizeof(FLDINDEX), 1, r->ixfp ) != 1 )
+       r->error = 1;
+    r->written++;
+}
+
+
+/* cap_fwrite - Writes the "len" bytes at "p" to "fp", CAP_CHUNK bytes
+ * at a time.
+ *
+ * Return: 0, or -1 on a write error
+ */
+static int cap_fwrite( CAPPIX p, long len, FILE *fp )
+{
+    size_t n;
+
+    for( ; len > 0; len -= (long) n, p += n )
+      {
+        n = (size_t) ((len < CAP_CHUNK) ? len : CAP_CHUNK);
+        if( fwrite( (const void *) p, 1, n, fp ) != n )
+           return -1;
+      }
+    return 0;
+}
+
+
+/* cap_write - Writes the "n" slots after "tail" to the file, each on
+ * pages of its own, with an empty entry for each field dropped before
+ * them.  A field that can't be written gets an empty entry too, and
+ * the next is written over its pages, so every entry with a page has
+ * all its bytes in the file.  Called only by the writer; the caller
+ * moves "tail" afterwards.
+ */
+static void cap_write( CAPRING *r, long n )
+{
+    long k, pad;
+    int slot;
+
+    pad = r->hdr.stride - r->fieldsize;
+    for( k = 0; k < n; k++ )
+      {
+        slot = (int) ((r->tail + k) % r->slots);
+        while( r->written < r->seq[slot] )
+           cap_entry( r, 0L, 0L, NULL );
+        if( fseek( r->fp, r->page * FLD_PAGE, SEEK_SET ) != 0
+            || cap_fwrite( r->slot[slot], r->fieldsize, r->fp ) != 0
+            || (pad > 0
+                && fwrite( r->pad, 1, (size_t) pad, r->fp ) != (size_t) pad) )
+          {                             /* no pixels to point at */
+            r->error = 1;
+            cap_entry( r, 0L, 0L, r->tc[slot] );
+            continue;
+          }
+        cap_entry( r, r->page, r->fieldsize, r->tc[slot] );
+        r->page += r->hdr.stride / FLD_PAGE;
+      }
+}
+
+
+#ifdef PUMA_THREADS
+/* cap_writer - Writer thread: empties the ring as slots are handed to
+ * it, until cap_close() says no more are coming.
+ */
+static void *cap_writer( void *p )
+{
+    CAPRING *r = (CAPRING *) p;
+    long n;
+
+    pthread_mutex_lock( &r->lock );
+    for( ;; )
+      {
+        while( r->head == r->tail && !r->closing )
+           pthread_cond_wait( &r->ready, &r->lock );
+        if( (n = r->head - r->tail) == 0 )
+           break;
+        pthread_mutex_unlock( &r->lock );
+        cap_write( r, n );
+        pthread_mutex_lock( &r->lock );
+        r->tail += n;
+      }
+    pthread_mutex_unlock( &r->lock );
+    return NULL;
+}
+#endif
+
+
+/* cap_open - Allocates a ring of up to "slots" fields of "width" by
+ * "height" pixels and creates the field file "path" for it.  The
+ * ring's bookkeeping is allocated first; then slots are taken while
+ * memory allows, less CAP_RESERVE bytes kept back for stdio.
+ *
+ * Return: The ring, or NULL if a field would be bigger than
+ *         CAP_MAXFIELD or the file can't be created.  Exits if memory
+ *         cannot be allocated for even one slot.
+ */
+CAPRING *cap_open( const char *path, int width, int height, int slots )
+{
+    CAPRING *r;
+    void *reserve;
+    long k;
+
+    if( width <= 0 || height <= 0 || height > CAP_MAXFIELD / width )
+       return NULL;
+    r = (CAPRING *) calloc( 1, sizeof(CAPRING) );
+    if( r == NULL )
+      {
+        printf( "Error:  cap_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    if( (r->fp = fopen( path, "wb" )) == NULL )
+      {
+        free( r );
+        return NULL;
+      }
+    if( (r->ixfp = tmpfile()) == NULL )
+      {
+        fclose( r->fp );
+        remove( path );
+        free( r );
+        return NULL;
+      }
+    r->fieldsize = (long) width * height;
+    r->slots = (slots > 0) ? slots : 1;
+    r->slot = (CAPPIX *) malloc( r->slots * sizeof(CAPPIX) );
+    r->seq = (long *) malloc( r->slots * sizeof(long) );
+    r->tc = (char (*)[FLD_TCLEN]) malloc( r->slots * FLD_TCLEN );
+    r->pad = (unsigned char *) calloc( 1, (size_t) FLD_PAGE );
+    reserve = malloc( (size_t) CAP_RESERVE );
+    if( r->slot == NULL || r->seq == NULL || r->tc == NULL
+        || r->pad == NULL || reserve == NULL )
+      {
+        printf( "Error:  cap_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    for( k = 0; k < r->slots; k++ )     /* as many as there is room for */
+       if( (r->slot[k] = CAP_ALLOC( r->fieldsize )) == NULL )
+          break;
+    r->slots = (int) k;
+    free( reserve );                    /* for the files' buffers */
+    if( r->slots == 0 )
+      {
+        printf( "Error:  cap_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+
+    memcpy( r->hdr.magic, FLD_MAGIC, sizeof(r->hdr.magic) );
+    r->hdr.version = FLD_VERSION;
+    r->hdr.headsize = FLD_HEADSIZE;
+    r->hdr.width = width;
+    r->hdr.height = height;
+    r->hdr.fieldsize = (FLD_I32) r->fieldsize;
+    r->hdr.stride = (FLD_I32) ((r->fieldsize + FLD_PAGE - 1)
+                                / FLD_PAGE * FLD_PAGE);
+    r->hdr.dataoff = (FLD_I32) FLD_PAGE;
+    r->page = 1L;
+    fwrite( &r->hdr, sizeof(FLDHEAD), 1, r->fp );
+    for( k = sizeof(FLDHEAD); k < FLD_PAGE; k++ )
+       fputc( 0, r->fp );
+    if( ferror( r->fp ) )
+       r->error = 1;
+
+#ifdef PUMA_THREADS
+    pthread_mutex_init( &r->lock, NULL );
+    pthread_cond_init( &r->ready, NULL );
+    r->threaded = ( pthread_create( &r->writer, NULL, cap_writer, r ) == 0 );
+#endif
+    return r;
+}
+
+
+/* cap_slot - Finds the slot the next field is to be grabbed into.  If
+ * the ring is full the field is dropped.
+ *
+ * Return: The slot, to be handed on with cap_put() (or cap_drop()),
+ *         or NULL if the field was dropped
+ */
+CAPPIX cap_slot( CAPRING *r )
+{
+    long used;
+
+#ifdef PUMA_THREADS
+    pthread_mutex_lock( &r->lock );
+    used = r->head - r->tail;
+    pthread_mutex_unlock( &r->lock );
+#else
+    used = r->head - r->tail;
+#endif
+    if( used >= r->slots )
+      {
+        r->dropped++;
+        r->next++;
+        return NULL;
+      }
+    return r->slot[r->head % r->slots];
+}
+
+
+/* cap_put - Hands the slot from cap_slot(), now filled, to the writer,
+ * with the field's tape time code (NULL if not known).
+ */
+void cap_put( CAPRING *r, const char *tc )
+{
+    long used;
+    int slot;
+
+    slot = (int) (r->head % r->slots);
+    r->seq[slot] = r->next++;
+    memset( r->tc[slot], 0, FLD_TCLEN );
+    if( tc != NULL )
+       strncpy( r->tc[slot], tc, FLD_TCLEN - 1 );
+#ifdef PUMA_THREADS
+    pthread_mutex_lock( &r->lock );
+    used = ++r->head - r->tail;
+    pthread_cond_signal( &r->ready );
+    pthread_mutex_unlock( &r->lock );
+#else
+    used = ++r->head - r->tail;
+#endif
+    if( used > r->highwater )
+       r->highwater = (int) used;
+}
+
+
+/* cap_drop - Gives up the slot from cap_slot() when the field couldn't
+ * be grabbed; it is indexed like a dropped field.
+ */
+void cap_drop( CAPRING *r )
+{
+    r->dropped++;
+    r->next++;
+}
+
+
+/* cap_skip - Counts "n" fields that went by with nothing grabbing them,
+ * while the grabber's loop was writing, as dropped.
+ */
+void cap_skip( CAPRING *r, long n )
+{
+    if( n <= 0 )
+       return;
+    r->dropped += n;
+    r->next += n;
+}
+
+
+/* cap_drain - Writes up to "max" of the waiting fields in the calling
+ * thread.  With the writer thread running there is nothing to do.
+ *
+ * Return: The fields written
+ */
+long cap_drain( CAPRING *r, long max )
+{
+    long n;
+
+#ifdef PUMA_THREADS
+    if( r->threaded )
+       return 0L;
+#endif
+    n = r->head - r->tail;
+    if( n > max )
+       n = max;
+    cap_write( r, n );
+    r->tail += n;
+    return n;
+}
+
+
+/* cap_close - Waits for every field to be written, indexes any dropped
+ * at the end of the pass, writes the index and the final header,
+ * closes the file and frees the ring.  "st" (if not NULL) gets the
+ * pass's counts.
+ *
+ * Return: 0, or -1 if the file couldn't all be written
+ */
+int cap_close( CAPRING *r, CAPSTATS *st )
+{
+    long left;
+    size_t n;
+    int bad, k;
+
+#ifdef PUMA_THREADS
+    if( r->threaded )
+      {
+        pthread_mutex_lock( &r->lock );
+        r->closing = 1;
+        pthread_cond_signal( &r->ready );
+        pthread_mutex_unlock( &r->lock );
+        pthread_join( r->writer, NULL );
+        r->threaded = 0;
+      }
+    pthread_cond_destroy( &r->ready );
+    pthread_mutex_destroy( &r->lock );
+#endif
+    cap_drain( r, r->head - r->tail );
+    while( r->written < r->next )
+       cap_entry( r, 0L, 0L, NULL );
+
+    r->hdr.numfields = (FLD_I32) r->written;
+    r->hdr.indexpage = (FLD_I32) r->page;     /* after the last field */
+    r->hdr.dropped = (FLD_I32) r->dropped;
+    left = r->written * (long) sizeof(FLDINDEX);
+    if( fflush( r->ixfp ) != 0 || fseek( r->ixfp, 0L, SEEK_SET ) != 0
+        || fseek( r->fp, r->page * FLD_PAGE, SEEK_SET ) != 0 )
+      {
+        r->error = 1;
+        left = 0L;
+      }
+    for( ; left > 0; left -= (long) n )     /* the pad is scratch now */
+      {
+        n = (size_t) ((left < FLD_PAGE) ? left : FLD_PAGE);
+        if( fread( r->pad, 1, n, r->ixfp ) != n
+            || fwrite( r->pad, 1, n, r->fp ) != n )
+          {
+            r->error = 1;
+            break;
+          }
+      }
+    fclose( r->ixfp );
+    if( fseek( r->fp, 0L, SEEK_SET ) != 0
+        || fwrite( &r->hdr, sizeof(FLDHEAD), 1, r->fp ) != 1 )
+       r->error = 1;
+    if( fclose( r->fp ) != 0 )
+       r->error = 1;
+    bad = r->error;
+    if( st != NULL )
+      {
+        st->fields = r->next;
+        st->dropped = r->dropped;
+        st->slots = r->slots;
+        st->highwater = r->highwater;
+        st->error = r->error;
+      }
+    for( k = 0; k < r->slots; k++ )
+       CAP_FREE( r->slot[k] );
+    free( r->slot );
+    free( r->seq );
+    free( r->tc );
+    free( r->pad );
+    free( r );
+    return bad ? -1 : 0;
+}
@@ -0,0 +1,97 @@
+/* CAPTURE.H
+ *
+ * Fields grabbed during one pass of the tape, in PLAY or slow play,
+ * instead of one at a time with the VCR in PAUSE.  The grabber fills
+ * slots of a ring allocated up front; a writer behind it empties the
+ * ring into a field file (.FLD, see fieldsrc.h) on disk, which is then
+ * digitized from as a recording.
+ *
+ * The grabber never waits for the disk.  A field that comes while
+ * every slot is still waiting to be written is dropped and counted;
+ * it gets an entry in the file's index but no pixels, so field n of
+ * the file is always the n-th field of the pass.  The most slots ever
+ * waiting (the high-water mark) shows how near the ring came to
+ * dropping.
+ *
+ * With PUMA_THREADS defined the writer is a thread of its own.
+ * Otherwise, as under DOS, the grabber's loop calls cap_drain() to
+ * write fields between grabs.  The fields that go by during a write
+ * are never grabbed.  The loop finds how many there were, from the
+ * tape's time code, and counts them with cap_skip().
+ *
+ * Each slot is allocated on its own.  Under DOS a grabber field is
+ * bigger than 64K, so slots are huge (CAPPIX) and come from halloc(),
+ * and the ring holds as many as there is memory for, up to the number
+ * asked, with some memory left over for the files' buffers.  No field may be bigger than CAP_MAXFIELD, the most whole
+ * pages a field file's stride can give it.  The index grows with the
+ * pass, past what one segment holds, so its entries go to a temporary
+ * file until cap_close() copies them after the last field.
+ */
+
+/* Include only once */
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include "fieldsrc.h"
+#ifdef PUMA_THREADS
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+typedef unsigned char _huge *CAPPIX;    /* 16 bit compilers             */
+#else
+typedef unsigned char *CAPPIX;
+#endif
+
+#define CAP_MAXFIELD 0x7FFFF000L   /* Bytes in the biggest field        */
+
+typedef struct _CAPSTATS
+{
+    long    fields;             /* Fields of the pass                   */
+    long    dropped;            /* Of them, with no pixels              */
+    int     slots;              /* Size of the ring                     */
+    int     highwater;          /* Most slots waiting to be written     */
+    int     error;              /* TRUE if the file couldn't be written */
+} CAPSTATS;
+
+typedef struct _CAPRING
+{
+    FILE   *fp;                 /* The field file                       */
+    FLDHEAD hdr;                /* Written again, complete, on close    */
+    long    fieldsize;          /* Bytes in a field                     */
+    int     slots;
+    CAPPIX *slot;               /* Each slot's field                    */
+    long   *seq;                /* Field number in each slot            */
+    char  (*tc)[FLD_TCLEN];     /* Time code of each slot's field       */
+    unsigned char *pad;         /* Zeros to fill out a field's pages    */
+    FILE   *ixfp;               /* Entries for the fields written       */
+    long    page;               /* Page the next field's pixels go on   */
+
+    long    head;               /* Slots handed to the writer           */
+    long    tail;               /* Slots written                        */
+    long    next;               /* Number of the next field             */
+    long    written;            /* Index entries, dropped included      */
+    long    dropped;
+    int     highwater;
+    int     error;
+    int     closing;            /* No more fields are coming            */
+#ifdef PUMA_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t  ready;      /* Slots are waiting, or closing        */
+    pthread_t       writer;
+    int     threaded;           /* The writer thread is running         */
+#endif
+} CAPRING;
+
+/* Public capture functions */
+CAPRING       *cap_open( const char *path, int width, int height,
+                         int slots );
+CAPPIX         cap_slot( CAPRING *r );
+void           cap_put( CAPRING *r, const char *tc );
+void           cap_drop( CAPRING *r );
+void           cap_skip( CAPRING *r, long n );
+long           cap_drain( CAPRING *r, long max );
+int            cap_close( CAPRING *r, CAPSTATS *st );
+
+#endif /* CAPTURE_H */
@@ -0,0 +1,433 @@
+/**************************************************************************
+ *  FIELDSRC.C
+ *
+ * Video fields from a recording on disk. The following functions are
+ * public:
+ *
+ *   fsrc_open      -   Opens a field file, or a raw, PGM or Y4M recording
+ *   fsrc_field     -   Finds any field's pixels
+ *   fsrc_close     -   Closes a recording
+ *
+ * Only the first frame's header is read when a recording is opened;
+ * each later frame's header is checked against it when that frame is
+ * asked for, so opening a long recording costs no more than a short
+ * one.  A mapped field file is marked for random access, so the
+ * system doesn't read ahead into fields that are being skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fieldsrc.h"
+
+#ifdef FMAP_MMAP
+#include <sys/mman.h>
+#endif
+
+/* The frame buffer and index where there is no mmap().  halloc() gives
+   a block starting a segment, so the FSRC_CHUNK byte pieces they are
+   read in never cross one. */
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+#include <malloc.h>
+#define FSRC_ALLOC( n, size )  halloc( (n), (size) )
+#define FSRC_FREE( p )         hfree( (void _huge *) (p) )
+#else
+#define FSRC_ALLOC( n, size )  malloc( (size_t) (n) * (size) )
+#define FSRC_FREE( p )         free( (void *) (p) )
+#endif
+#define FSRC_CHUNK             0x8000L
+
+/* Prototypes for internal functions */
+static const char *fsrc_number( const char *p, const char *end, long *v );
+static int  fsrc_pgm( FIELDSRC *s, const char *h, long n );
+static int  fsrc_y4m( FIELDSRC *s, const char *h, long n );
+static int  fsrc_fld( FIELDSRC *s, const char *h, long n, long size );
+static FSRCPIX fsrc_read( FIELDSRC *s, long off, long len );
+#ifndef FMAP_MMAP
+static int  fsrc_fread( FSRCPIX p, long len, FILE *fp );
+#endif
+
+
+/* fsrc_number - Reads the whole number at "p", after any blanks and
+ * PGM comments.
+ *
+ * Return: The character after the number, or NULL if there is none
+ *         before "end"
+ */
+static const char *fsrc_number( const char *p, const char *end, long *v )
+{
+    while( p < end && (*p == ' ' || *p == '\t' || *p == '\r'
+                       || *p == '\n' || *p == '#') )
+      {
+        if( *p == '#' )
+          {
+            while( p < end && *p != '\n' )
+               p++;
+          }
+        else
+           p++;
+      }
+    if( p >= end || *p < '0' || *p > '9' )
+       return NULL;
+    for( *v = 0L; p < end && *p >= '0' && *p <= '9'; p++ )
+       *v = *v * 10L + (*p - '0');
+    return p;
+}
+
+
+/* fsrc_pgm - Fills in the layout of a PGM recording from its first
+ * "n" bytes at "h".
+ *
+ * Return: 0, or -1 if it isn't an 8 bit binary PGM
+ */
+static int fsrc_pgm( FIELDSRC *s, const char *h, long n )
+{
+    const char *p, *end = h + n;
+    long w, ht, maxval;
+
+    if( (p = fsrc_number( h + 2, end, &w )) == NULL
+        || (p = fsrc_number( p, end, &ht )) == NULL
+        || (p = fsrc_number( p, end, &maxval )) == NULL
+        || p >= end || w <= 0 || ht <= 0 || maxval <= 0 || maxval > 255 )
+       return -1;
+    s->kind = FSRC_PGM;
+    s->width = (int) w;
+    s->height = (int) ht;
+    s->pitch = w;
+    s->perframe = 1;
+    s->first = 0L;
+    s->headlen = (long) (p + 1 - h);    /* one blank ends the header */
+    s->stride = s->headlen + w * ht;
+    memcpy( s->head, h, (size_t) s->headlen );
+    return 0;
+}
+
+
+/* fsrc_y4m - Fills in the layout of a YUV4MPEG2 recording from its
+ * first "n" bytes at "h".
+ *
+ * Return: 0, or -1 if it isn't a Y4M stream with 8 bit planes
+ */
+static int fsrc_y4m( FIELDSRC *s, const char *h, long n )
+{
+    const char *p, *q, *end = h + n;
+    long w = 0L, ht = 0L, cw, ch, planes;
+    char interlace = 'p';
+    char chroma[16];
+
+    strcpy( chroma, "420" );
+    for( p = h + 9; p < end && *p != '\n'; )
+      {
+        if( *p == ' ' )
+          {
+            p++;
+            continue;
+          }
+        for( q = p; q < end && *q != ' ' && *q != '\n'; q++ )
+           ;
+        if( *p == 'W' )
+           fsrc_number( p + 1, q, &w );
+        else if( *p == 'H' )
+           fsrc_number( p + 1, q, &ht );
+        else if( *p == 'I' && q > p + 1 )
+           interlace = p[1];
+        else if( *p == 'C' )
+          {
+            sprintf( chroma, "%.*s", (int) (q - p - 1 < 15 ? q - p - 1 : 15),
+                     p + 1 );
+          }
+        p = q;
+      }
+    if( p >= end || w <= 0 || ht <= 0 )
+       return -1;
+
+    cw = (w + 1) / 2;
+    ch = (ht + 1) / 2;
+    if( strcmp( chroma, "mono" ) == 0 )
+       planes = w * ht;
+    else if( strcmp( chroma, "444" ) == 0 )
+       planes = 3L * w * ht;
+    else if( strcmp( chroma, "422" ) == 0 )
+       planes = w * ht + 2L * cw * ht;
+    else if( strcmp( chroma, "420" ) == 0 || strcmp( chroma, "420jpeg" ) == 0
+             || strcmp( chroma, "420mpeg2" ) == 0
+             || strcmp( chroma, "420paldv" ) == 0 )
+       planes = w * ht + 2L * cw * ch;
+    else
+       return -1;                       /* 411, alpha, or deeper than 8 */
+
+    s->kind = FSRC_Y4M;
+    s->first = (long) (p + 1 - h);
+    for( q = p + 1; q < end && *q != '\n'; q++ )
+       ;
+    if( q >= end || q - (p + 1) < 5 || memcmp( p + 1, "FRAME", 5 ) != 0 )
+       return -1;
+    s->headlen = (long) (q + 1 - (p + 1));
+    memcpy( s->head, p + 1, (size_t) s->headlen );
+    s->stride = s->headlen + planes;
+    s->width = (int) w;
+    if( interlace == 't' || interlace == 'b' )
+      {
+        s->perframe = 2;
+        s->lower = (interlace == 'b');
+        s->height = (int) (ht / 2);
+        s->pitch = 2L * w;
+      }
+    else
+      {
+        s->perframe = 1;
+        s->height = (int) ht;
+        s->pitch = w;
+      }
+    return 0;
+}
+
+
+/* fsrc_fld - Fills in the layout of a field file from its first "n"
+ * bytes at "h", and finds its index.
+ *
+ * Return: 0, or -1 if the header is not one this version writes
+ */
+static int fsrc_fld( FIELDSRC *s, const char *h, long n, long size )
+{
+    FLDHEAD fh;
+    long off, len;
+
+    if( n < (long) sizeof(FLDHEAD) )
+       return -1;
+    memcpy( &fh, h, sizeof(FLDHEAD) );
+    if( fh.version != FLD_VERSION || fh.headsize != FLD_HEADSIZE
+        || fh.width <= 0 || fh.height <= 0
+        || fh.fieldsize < (long) fh.width * fh.height
+        || fh.stride < fh.fieldsize || fh.dataoff < FLD_HEADSIZE )
+       return -1;
+    s->kind = FSRC_FLD;
+    s->width = (int) fh.width;
+    s->height = (int) fh.height;
+    s->pitch = fh.width;
+    s->perframe = 1;
+    s->first = fh.dataoff;
+    s->stride = fh.stride;
+    s->headlen = 0L;
+
+    off = fh.indexpage * FLD_PAGE;
+    if( fh.indexpage <= 0 || fh.indexpage > size / FLD_PAGE
+        || fh.numfields < 0
+        || fh.numfields > (size - off) / (long) sizeof(FLDINDEX) )
+      {                                 /* never closed */
+        s->fields = ( size > s->first ) ? (size - s->first) / s->stride : 0L;
+        return 0;
+      }
+    s->fields = fh.numfields;
+    len = fh.numfields * (long) sizeof(FLDINDEX);
+    if( len == 0 )
+       return 0;
+#ifdef FMAP_MMAP
+    s->index = (FSRCIDX) (s->map.base + off);
+#else
+    s->index = (FSRCIDX) FSRC_ALLOC( fh.numfields, sizeof(FLDINDEX) );
+    if( s->index == NULL )
+      {
+        printf( "Error:  fsrc_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    if( fseek( s->fp, off, SEEK_SET ) != 0
+        || fsrc_fread( (FSRCPIX) s->index, len, s->fp ) != 0 )
+       return -1;
+#endif
+    return 0;
+}
+
+
+/* fsrc_open - Opens the recording at "path".  "width" and "height"
+ * give the field size of a raw recording and are ignored otherwise.
+ *
+ * Return: The source, or NULL if the file can't be opened or its
+ *         layout isn't understood.  Exits if memory cannot be
+ *         allocated.
+ */
+FIELDSRC *fsrc_open( const char *path, int width, int height )
+{
+    FIELDSRC *s;
+    char h[FSRC_HEADMAX];
+    long n, size;
+    int bad;
+
+    s = (FIELDSRC *) calloc( 1, sizeof(FIELDSRC) );
+    if( s == NULL )
+      {
+        printf( "Error:  fsrc_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    s->inbuf = -1L;
+#ifdef FMAP_MMAP
+    if( fmap_open( &s->map, path ) != 0 )
+      {
+        free( s );
+        return NULL;
+      }
+    size = s->map.size;
+    n = ( size < FSRC_HEADMAX ) ? size : FSRC_HEADMAX;
+    if( n > 0 )
+       memcpy( h, s->map.base, (size_t) n );
+#else
+    if( (s->fp = fopen( path, "rb" )) == NULL )
+      {
+        free( s );
+        return NULL;
+      }
+    fseek( s->fp, 0L, SEEK_END );
+    size = ftell( s->fp );
+    fseek( s->fp, 0L, SEEK_SET );
+    n = (long) fread( h, 1, FSRC_HEADMAX, s->fp );
+#endif
+
+    s->size = size;
+    if( n >= 8 && memcmp( h, FLD_MAGIC, 8 ) == 0 )
+       bad = fsrc_fld( s, h, n, size );
+    else if( n >= 2 && h[0] == 'P' && h[1] == '5' )
+       bad = fsrc_pgm( s, h, n );
+    else if( n >= 10 && memcmp( h, "YUV4MPEG2 ", 10 ) == 0 )
+       bad = fsrc_y4m( s, h, n );
+    else if( width > 0 && height > 0 )
+      {
+        s->kind = FSRC_RAW;
+        s->width = width;
+        s->height = height;
+        s->pitch = width;
+        s->perframe = 1;
+        s->stride = (long) width * height;
+        bad = 0;
+      }
+    else
+       bad = -1;
+
+    if( bad || (s->kind != FSRC_FLD && size - s->first < s->stride) )
+      {
+        fsrc_close( s );
+        return NULL;
+      }
+    if( s->kind != FSRC_FLD )
+       s->fields = (size - s->first) / s->stride * s->perframe;
+#ifdef FMAP_MMAP
+#ifdef POSIX_MADV_RANDOM
+    else if( s->map.size > 0 )
+       posix_madvise( s->map.base, (size_t) s->map.size, POSIX_MADV_RANDOM );
+#endif
+#else
+    s->buf = (FSRCPIX) FSRC_ALLOC( s->stride, 1 );
+    if( s->buf == NULL )
+      {
+        printf( "Error:  fsrc_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+#endif
+    return s;
+}
+
+
+#ifndef FMAP_MMAP
+/* fsrc_fread - Reads "len" bytes from "fp" to "p", FSRC_CHUNK bytes at a
+ * time.
+ *
+ * Return: 0, or -1 if they can't all be read
+ */
+static int fsrc_fread( FSRCPIX p, long len, FILE *fp )
+{
+    size_t n;
+
+    for( ; len > 0; len -= (long) n, p += n )
+      {
+        n = (size_t) ((len < FSRC_CHUNK) ? len : FSRC_CHUNK);
+        if( fread( (void *) p, 1, n, fp ) != n )
+           return -1;
+      }
+    return 0;
+}
+#endif
+
+
+/* fsrc_read - Finds the "len" bytes at offset "off" of the file.
+ *
+ * Return: The bytes, or NULL if they can't be read
+ */
+static FSRCPIX fsrc_read( FIELDSRC *s, long off, long len )
+{
+#ifdef FMAP_MMAP
+    if( off + len > s->map.size )
+       return NULL;
+    return (FSRCPIX) s->map.base + off;
+#else
+    if( s->inbuf != off )
+      {
+        s->inbuf = -1L;
+        if( fseek( s->fp, off, SEEK_SET ) != 0
+            || fsrc_fread( s->buf, len, s->fp ) != 0 )
+           return NULL;
+        s->inbuf = off;
+      }
+    return s->buf;
+#endif
+}
+
+
+/* fsrc_field - Finds field "n" (from 0) of the recording.  Rows of the
+ * field are s->pitch bytes apart.
+ *
+ * Return: The field's first pixel, or NULL if there is no such field,
+ *         it was dropped during capture or its frame is damaged.  The
+ *         pixels stay put until the next call or fsrc_close().
+ */
+FSRCPIX fsrc_field( FIELDSRC *s, long n )
+{
+    FSRCPIX p;
+    FLDINDEX e;
+    long f;
+    int odd;
+
+    if( n < 0 || n >= s->fields )
+       return NULL;
+    if( s->kind == FSRC_FLD )
+      {
+        if( s->index == NULL )
+           return fsrc_read( s, s->first + n * s->stride,
+                             (long) s->width * s->height );
+        e = s->index[n];
+        if( e.page <= 0
+            || e.bytes < (long) s->width * s->height || e.bytes > s->stride
+            || e.page > (s->size - e.bytes) / FLD_PAGE )
+           return NULL;                 /* dropped, or a damaged entry */
+        return fsrc_read( s, e.page * FLD_PAGE, (long) e.bytes );
+      }
+    f = n / s->perframe;
+    if( (p = fsrc_read( s, s->first + f * s->stride, s->stride )) == NULL
+        || (s->headlen > 0
+            && memcmp( p, s->head, (size_t) s->headlen ) != 0) )
+       return NULL;
+    p += s->headlen;
+    if( s->perframe == 2 )
+      {
+        odd = (int) (n % 2) ^ s->lower;     /* rows 1, 3, 5, ... */
+        p += odd * (s->pitch / 2);
+      }
+    return p;
+}
+
+
+/* fsrc_close - Closes the recording and frees the source.
+ */
+void fsrc_close( FIELDSRC *s )
+{
+    if( s == NULL )
+       return;
+    fmap_close( &s->map );
+    if( s->fp != NULL )
+       fclose( s->fp );
+#ifndef FMAP_MMAP
+    if( s->index != NULL )
+       FSRC_FREE( s->index );
+    if( s->buf != NULL )
+       FSRC_FREE( s->buf );
+#endif
+    free( s );
+}
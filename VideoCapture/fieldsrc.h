@@ -0,0 +1,138 @@
+/* FIELDSRC.H
+ *
+ * Recorded video fields read straight from a file, so a session can be
+ * digitized from footage on disk instead of from the VCR through the
+ * frame grabber.  Four layouts are understood, told apart by the
+ * start of the file:
+ *
+ *      FLD     the field file written by CAPTURE TAPE (capture.c),
+ *              below
+ *      raw     8 bit grey fields one after another, no header; the
+ *              field size is given to fsrc_open()
+ *      PGM     binary ("P5") 8 bit PGM images one after another, each
+ *              one field, all with the same header
+ *      Y4M     YUV4MPEG2 with 8 bit planes; only the luma is used.  An
+ *              interlaced stream ("It" or "Ib") gives two fields a
+ *              frame, in the order it was shot, as the grabber's
+ *              vertical increment of 2 does
+ *
+ * Every field, and every header in front of one, is the same size, so
+ * field n is found from n alone: fsrc_field() costs the same for any
+ * field, in any order, backwards as well as forwards.  Where the
+ * system has mmap() the file is mapped (filemap.c) and a field is a
+ * pointer into it, and threads may share the source; elsewhere (DOS)
+ * each frame is read into a huge buffer when it is asked for, so a
+ * frame may be bigger than a segment.  A TRKFIELD (track.c) holds a
+ * pointer that is not huge; it can take a field only if FSRC_REACH()
+ * is at most FSRC_FARMAX.
+ *
+ * A field file (.FLD) is laid out in pages of FLD_PAGE bytes, so each
+ * field's pixels start on a page of their own and fetching one, or
+ * every (skip + 1)th, reads only those fields' pages:
+ *
+ *      page 0            FLDHEAD   (FLD_HEADSIZE bytes)
+ *      dataoff           the fields' pixels, width * height bytes
+ *                        each, every one padded to stride bytes
+ *      indexpage         numfields FLDINDEX entries, one per field
+ *
+ * The index gives the page each field starts on, the bytes of pixels
+ * there and the tape time code, if the grabber knew it.  The bytes
+ * are at least width * height and at most stride, and must lie within
+ * the file; an entry that breaks this is read as a damaged field.  A
+ * field dropped during capture has an entry but no pixels (page 0).
+ * The index and the final header are written when capture ends; a
+ * file cut short before then is read as the fields it holds, one
+ * after another, without time codes.
+ * Numbers are stored in the byte order of the writing machine.
+ */
+
+/* Include only once */
+#ifndef FIELDSRC_H
+#define FIELDSRC_H
+
+#include <stdio.h>
+#include "filemap.h"
+
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+typedef long  FLD_I32;          /* 16 bit compilers                     */
+typedef const unsigned char _huge *FSRCPIX;
+#define FSRC_FARMAX  0x10000L   /* Reach of a far pointer into a frame  */
+#else
+typedef int   FLD_I32;
+typedef const unsigned char *FSRCPIX;
+#define FSRC_FARMAX  0x7FFFFFFFL
+#endif
+
+#define FSRC_RAW     0          /* Layouts                              */
+#define FSRC_PGM     1
+#define FSRC_Y4M     2
+#define FSRC_FLD     3
+
+#define FSRC_HEADMAX 256        /* Longest file or frame header         */
+
+#define FLD_MAGIC    "PUMAFLD"
+#define FLD_VERSION  1
+#define FLD_HEADSIZE 64
+#define FLD_PAGE     4096L      /* Alignment of every field             */
+#define FLD_TCLEN    8          /* Time code characters, with the NUL   */
+
+typedef struct _FLDHEAD
+{
+    char    magic[8];           /* FLD_MAGIC                            */
+    FLD_I32 version;            /* FLD_VERSION                          */
+    FLD_I32 headsize;           /* FLD_HEADSIZE                         */
+    FLD_I32 width, height;      /* Pixels in a field                    */
+    FLD_I32 fieldsize;          /* Bytes of pixels in a field           */
+    FLD_I32 stride;             /* Bytes a field takes, whole pages     */
+    FLD_I32 dataoff;            /* Offset of the first field's pixels   */
+    FLD_I32 numfields;          /* Entries in the index                 */
+    FLD_I32 indexpage;          /* Page of the index, 0 if none         */
+    FLD_I32 dropped;            /* Fields with no pixels                */
+    FLD_I32 reserved[4];
+} FLDHEAD;
+
+typedef struct _FLDINDEX
+{
+    FLD_I32 page;               /* Page of the pixels, 0 if dropped     */
+    FLD_I32 bytes;              /* Bytes of pixels, 0 if dropped        */
+    char    timecode[FLD_TCLEN];/* Tape time code, "" if not known      */
+} FLDINDEX;
+
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+typedef FLDINDEX _huge *FSRCIDX;
+#else
+typedef FLDINDEX *FSRCIDX;
+#endif
+
+typedef struct _FIELDSRC
+{
+    int     kind;               /* FSRC_FLD, FSRC_RAW, FSRC_PGM or ...  */
+    int     width, height;      /* Pixels in a field                    */
+    long    pitch;              /* Bytes from a row to the next         */
+    long    fields;             /* Fields in the file                   */
+    long    size;               /* Bytes in the file                    */
+    int     perframe;           /* Fields in a frame, 1 or 2            */
+    int     lower;              /* Interlaced: first field is the lower */
+
+    long    first;              /* Offset of the first frame            */
+    long    stride;             /* Bytes from a frame to the next       */
+    long    headlen;            /* Bytes of header in front of a frame  */
+    char    head[FSRC_HEADMAX]; /* The header every frame must have     */
+    FSRCIDX index;              /* FSRC_FLD: NULL if never closed       */
+
+    FILEMAP map;                /* FMAP_MMAP: the whole file            */
+    FILE   *fp;                 /* Otherwise: the file, and a frame     */
+    FSRCPIX buf;
+    long    inbuf;              /* Offset of the frame in buf, or -1    */
+} FIELDSRC;
+
+/* Bytes from the start of a frame to the last pixel of any of its
+   fields */
+#define FSRC_REACH( s )  ((s)->headlen + (long) (s)->height * (s)->pitch)
+
+/* Public field source functions */
+FIELDSRC *fsrc_open( const char *path, int width, int height );
+FSRCPIX   fsrc_field( FIELDSRC *s, long n );
+void      fsrc_close( FIELDSRC *s );
+
+#endif /* FIELDSRC_H */
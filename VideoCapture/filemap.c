@@ -0,0 +1,125 @@
+/**************************************************************************
+ *  FILEMAP.C
+ *
+ * Read-only whole file views. The following functions are public:
+ *
+ *   fmap_open      -   Maps (or reads) a file and fills in a FILEMAP
+ *   fmap_close     -   Releases the view
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "filemap.h"
+
+/* The read fallback's memory.  halloc() gives a block starting a
+   segment, so the FMAP_CHUNK byte pieces it is read in never cross
+   one. */
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+#include <malloc.h>
+#define FMAP_ALLOC( n )  ((FMAPPTR) halloc( (n), 1 ))
+#define FMAP_FREE( p )   hfree( (void _huge *) (p) )
+#else
+#define FMAP_ALLOC( n )  ((FMAPPTR) malloc( (size_t) (n) ))
+#define FMAP_FREE( p )   free( p )
+#endif
+#define FMAP_CHUNK       0x8000L
+
+#ifdef FMAP_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+
+/* fmap_open - Opens "path" and makes its whole contents addressable
+ * through m->base.
+ *
+ * Return: 0 on success, -1 if the file cannot be opened or read
+ */
+int fmap_open( FILEMAP *m, const char *path )
+{
+#ifdef FMAP_MMAP
+    int fd;
+    struct stat st;
+    void *p;
+
+    m->base = NULL;
+    m->size = 0;
+    m->mapped = 0;
+    if( (fd = open( path, O_RDONLY )) < 0 )
+       return -1;
+    if( fstat( fd, &st ) < 0 )
+      {
+        close( fd );
+        return -1;
+      }
+    m->size = (long) st.st_size;
+    if( m->size == 0 )
+      {
+        close( fd );
+        return 0;
+      }
+    p = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if( p == MAP_FAILED )
+       return -1;
+    m->base = (char *) p;
+    m->mapped = 1;
+    return 0;
+#else
+    FILE *fp;
+    FMAPPTR p;
+    long left;
+    size_t n;
+
+    m->base = NULL;
+    m->size = 0;
+    m->mapped = 0;
+    if( (fp = fopen( path, "rb" )) == NULL )
+       return -1;
+    if( fseek( fp, 0L, SEEK_END ) != 0 || (m->size = ftell( fp )) < 0
+        || fseek( fp, 0L, SEEK_SET ) != 0 )
+      {
+        m->size = 0;
+        fclose( fp );
+        return -1;
+      }
+    if( m->size > 0 && (m->base = FMAP_ALLOC( m->size )) == NULL )
+      {
+        m->size = 0;
+        fclose( fp );
+        return -1;
+      }
+    for( p = m->base, left = m->size; left > 0; left -= (long) n, p += n )
+      {
+        n = (size_t) ((left < FMAP_CHUNK) ? left : FMAP_CHUNK);
+        if( fread( (void *) p, 1, n, fp ) != n )
+          {
+            fclose( fp );
+            fmap_close( m );
+            return -1;
+          }
+      }
+    fclose( fp );
+    return 0;
+#endif
+}
+
+
+/* fmap_close - Unmaps or frees the view.
+ */
+void fmap_close( FILEMAP *m )
+{
+    if( m->base == NULL )
+       return;
+#ifdef FMAP_MMAP
+    if( m->mapped )
+       munmap( m->base, (size_t) m->size );
+    else
+#endif
+       FMAP_FREE( m->base );
+    m->base = NULL;
+    m->size = 0;
+}
@@ -0,0 +1,35 @@
+/* FILEMAP.H
+ *
+ * Read-only view of a whole file.  Where the system has mmap() the
+ * file is mapped and pages come in on demand; elsewhere (DOS) the file
+ * is read into one huge allocation, a piece at a time, so a file may
+ * be bigger than a segment.  Either way the caller gets a pointer to
+ * the first byte and the file size.
+ */
+
+/* Include only once */
+#ifndef FILEMAP_H
+#define FILEMAP_H
+
+#if defined(unix) || defined(__unix__) || defined(__APPLE__)
+#define FMAP_MMAP               /* Use mmap() for the view              */
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+typedef char _huge *FMAPPTR;    /* 16 bit compilers                     */
+#else
+typedef char *FMAPPTR;
+#endif
+
+typedef struct _FILEMAP
+{
+    FMAPPTR base;               /* First byte of the file               */
+    long    size;               /* Size of the file in bytes            */
+    int     mapped;             /* TRUE if base came from mmap()        */
+} FILEMAP;
+
+/* Public file map functions */
+int  fmap_open( FILEMAP *m, const char *path );
+void fmap_close( FILEMAP *m );
+
+#endif /* FILEMAP_H */
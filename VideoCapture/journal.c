@@ -0,0 +1,274 @@
+/**************************************************************************
+ *  JOURNAL.C
+ *
+ * Crash-safe digitization journal. The following functions are public:
+ *
+ *   jnl_recover    -   Reads every good entry back into a TRAJECT and
+ *                      cuts off a torn entry at the end of the file
+ *   jnl_open       -   Opens a journal for appending (or starts afresh)
+ *   jnl_write      -   Buffers one field, committing each full batch
+ *   jnl_commit     -   Writes buffered fields and commits them to disk
+ *   jnl_close      -   Commits and closes the journal
+ *
+ * The file layout is described in JOURNAL.H.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "journal.h"
+
+#if defined(unix) || defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define JNL_SYNC( fp )          fsync( fileno( fp ) )
+#define JNL_CHSIZE( fp, size )  ftruncate( fileno( fp ), (off_t) (size) )
+#else
+#include <io.h>
+#define JNL_SYNC( fp )          _commit( _fileno( fp ) )
+#define JNL_CHSIZE( fp, size )  _chsize( _fileno( fp ), (long) (size) )
+#endif
+
+/* Prototypes for internal functions */
+static unsigned long jnl_adler( const char *p, long len );
+static void          jnl_cut( const char *path, long size );
+
+
+/* jnl_adler - Adler-32 checksum of "len" bytes.
+ */
+static unsigned long jnl_adler( const char *p, long len )
+{
+    unsigned long a = 1, b = 0;
+
+    while( len-- > 0 )
+      {
+        a = (a + (unsigned char) *p++) % 65521UL;
+        b = (b + a) % 65521UL;
+      }
+    return (b << 16) | a;
+}
+
+
+/* jnl_cut - Truncates "path" to "size" bytes.
+ */
+static void jnl_cut( const char *path, long size )
+{
+    FILE *fp;
+
+    if( (fp = fopen( path, "r+b" )) == NULL )
+       return;
+    fflush( fp );
+    JNL_CHSIZE( fp, size );
+    fclose( fp );
+}
+
+
+/* jnl_recover - Reads the journal at "path" into "t", one field per good
+ * entry, and describes the last entry in "st".  Reading stops at the
+ * first entry that is short or fails its checksum, and the file is
+ * truncated there so that appending resumes on a clean boundary.
+ *
+ * Return: The number of entries recovered, or -1 if there is no
+ *         journal or it was written for a different number of joints
+ */
+long jnl_recover( const char *path, TRAJECT *t, JNLSTATE *st )
+{
+    FILE *fp;
+    JNLHEAD head;
+    JNLENTRY *e;
+    double *xy;
+    char *buf;
+    long size, good, n;
+    TRJ_I32 sum;
+    int j;
+
+    memset( st, 0, sizeof(JNLSTATE) );
+    if( (fp = fopen( path, "rb" )) == NULL )
+       return -1;
+    if( fread( &head, sizeof(JNLHEAD), 1, fp ) != 1
+        || memcmp( head.magic, JNL_MAGIC, sizeof(head.magic) ) != 0
+        || head.version != JNL_VERSION
+        || head.numjoints != t->numjoints )
+      {
+        fclose( fp );
+        return -1;
+      }
+
+    size = JNL_ENTRYSIZE( t->numjoints );
+    if( (buf = (char *) malloc( (size_t) size )) == NULL )
+      {
+        printf( "Error:  jnl_recover()  malloc failed.\n" );
+        exit( 1 );
+      }
+    e = (JNLENTRY *) buf;
+    xy = (double *) (buf + sizeof(JNLENTRY));
+    good = (long) sizeof(JNLHEAD);
+
+    while( fread( buf, (size_t) size, 1, fp ) == 1 )
+      {
+        memcpy( &sum, buf + size - sizeof(TRJ_I32), sizeof(TRJ_I32) );
+        if( (TRJ_I32) jnl_adler( buf, size - (long) sizeof(TRJ_I32) ) != sum )
+           break;
+        n = traj_append( t );
+        for( j = 0; j < t->numjoints; j++ )
+          {
+            traj_point( t, j, n, xy[2 * j], xy[2 * j + 1] );
+          }
+        st->entries++;
+        st->frmcnt = (long) e->frmcnt;
+        st->field = (long) e->field;
+        memcpy( st->timecode, e->timecode, JNL_TCLEN );
+        st->timecode[JNL_TCLEN - 1] = '\0';
+        good += size;
+      }
+    fseek( fp, 0L, SEEK_END );
+    n = ftell( fp );
+    fclose( fp );
+    free( buf );
+    if( n > good )
+       jnl_cut( path, good );       /* drop the torn tail */
+    return st->entries;
+}
+
+
+/* jnl_open - Opens the journal at "path" for appending entries of
+ * "numjoints" joints, committing every "batch" entries.  With "fresh"
+ * set any existing journal is discarded and a new header written;
+ * otherwise the file must already have been through jnl_recover().
+ *
+ * Return: The journal, or NULL if the file cannot be opened
+ */
+JOURNAL *jnl_open( const char *path, int numjoints, int batch, int fresh )
+{
+    JOURNAL *jn;
+    JNLHEAD head;
+
+    jn = (JOURNAL *) calloc( 1, sizeof(JOURNAL) );
+    if( jn == NULL )
+      {
+        printf( "Error:  jnl_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    jn->numjoints = numjoints;
+    jn->batch = (batch > 0) ? batch : 1;
+    jn->buf = (char *) malloc( (size_t) (jn->batch * JNL_ENTRYSIZE( numjoints )) );
+    if( jn->buf == NULL )
+      {
+        printf( "Error:  jnl_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    if( (jn->fp = fopen( path, fresh ? "wb" : "ab" )) == NULL )
+      {
+        free( jn->buf );
+        free( jn );
+        return NULL;
+      }
+    if( fresh )
+      {
+        memset( &head, 0, sizeof(JNLHEAD) );
+        memcpy( head.magic, JNL_MAGIC, sizeof(head.magic) );
+        head.version = JNL_VERSION;
+        head.numjoints = numjoints;
+        fwrite( &head, sizeof(JNLHEAD), 1, jn->fp );
+        fflush( jn->fp );
+        JNL_SYNC( jn->fp );
+      }
+    fseek( jn->fp, 0L, SEEK_END );
+    jn->good = ftell( jn->fp );
+    return jn;
+}
+
+
+/* jnl_write - Adds field "n" of "t" to the batch, tagged with its field
+ * count, tape field and time code (up to JNL_TCLEN - 1 characters).
+ * A full batch is committed before returning.
+ *
+ * Return: 0 on success, -1 if a commit failed
+ */
+int jnl_write( JOURNAL *jn, TRAJECT *t, long n, long frmcnt,
+               long field, const char *timecode )
+{
+    long size;
+    char *p;
+    JNLENTRY *e;
+    double *xy;
+    TRJ_I32 sum;
+    int j;
+
+    size = JNL_ENTRYSIZE( jn->numjoints );
+    p = jn->buf + jn->pending * size;
+    e = (JNLENTRY *) p;
+    xy = (double *) (p + sizeof(JNLENTRY));
+
+    memset( e, 0, sizeof(JNLENTRY) );
+    e->frmcnt = (TRJ_I32) frmcnt;
+    e->field = (TRJ_I32) field;
+    if( timecode != NULL )
+       strncpy( e->timecode, timecode, JNL_TCLEN - 1 );
+    for( j = 0; j < jn->numjoints; j++ )
+      {
+        if( TRAJ_OK( t, j, n ) )
+          {
+            xy[2 * j] = TRAJ_X( t, j )[n];
+            xy[2 * j + 1] = TRAJ_Y( t, j )[n];
+          }
+        else
+           xy[2 * j] = xy[2 * j + 1] = TRAJ_HIDDEN;
+      }
+    sum = (TRJ_I32) jnl_adler( p, size - (long) sizeof(TRJ_I32) );
+    memcpy( p + size - sizeof(TRJ_I32), &sum, sizeof(TRJ_I32) );
+
+    if( ++jn->pending >= jn->batch )
+       return jnl_commit( jn );
+    return 0;
+}
+
+
+/* jnl_commit - Writes the buffered entries, flushes the C library buffer
+ * and asks the operating system to put them on the disk.  If that
+ * fails the buffered entries are dropped and the file is cut back to
+ * the last commit, so no part of the batch is left in it.
+ *
+ * Return: 0 on success, -1 on a write error
+ */
+int jnl_commit( JOURNAL *jn )
+{
+    long size;
+
+    if( jn == NULL || jn->pending == 0 )
+       return 0;
+    size = JNL_ENTRYSIZE( jn->numjoints );
+    if( fwrite( jn->buf, (size_t) size, (size_t) jn->pending, jn->fp )
+           != (size_t) jn->pending
+        || fflush( jn->fp ) != 0
+        || JNL_SYNC( jn->fp ) != 0 )
+      {
+        jn->pending = 0;
+        clearerr( jn->fp );
+        fflush( jn->fp );
+        JNL_CHSIZE( jn->fp, jn->good );
+        fseek( jn->fp, jn->good, SEEK_SET );
+        return -1;
+      }
+    jn->committed += jn->pending;
+    jn->good += jn->pending * size;
+    jn->pending = 0;
+    return 0;
+}
+
+
+/* jnl_close - Commits anything still buffered and closes the journal.
+ *
+ * Return: 0 on success, -1 if the last commit failed
+ */
+int jnl_close( JOURNAL *jn )
+{
+    int err;
+
+    if( jn == NULL )
+       return 0;
+    err = jnl_commit( jn );
+    fclose( jn->fp );
+    free( jn->buf );
+    free( jn );
+    return err;
+}
@@ -0,0 +1,76 @@
+/* JOURNAL.H
+ *
+ * Append-only digitization journal (.JNL).  Every digitized field is
+ * recorded with its field count, tape field, SMPTE time code and raw
+ * pixel coordinates, so a session cut short by a crash or power loss
+ * can be resumed at the last field that reached the disk.
+ *
+ *      offset 0          JNLHEAD
+ *      JNLHEAD size      entries, JNL_ENTRYSIZE( numjoints ) bytes each
+ *
+ * An entry is a JNLENTRY followed by numjoints (x,y) pairs of doubles
+ * (TRAJ_HIDDEN for a hidden point) and an Adler-32 checksum of
+ * everything before it.  Entries are
+ * buffered and written "batch" at a time; each batch is flushed and
+ * committed to the disk before jnl_commit() returns.  A torn entry at
+ * the end of the file fails its checksum and is cut off on recovery.
+ */
+
+/* Include only once */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdio.h>
+#include "traject.h"
+#include "trjfile.h"
+
+#define JNL_MAGIC     "PUMAJNL"
+#define JNL_VERSION   1
+#define JNL_TCLEN     8         /* Time code characters, with the NUL   */
+#define JNL_ENTRYSIZE( nj )  ((long) sizeof(JNLENTRY) \
+                              + 16L * (nj) + (long) sizeof(TRJ_I32))
+
+typedef struct _JNLHEAD
+{
+    char    magic[8];           /* JNL_MAGIC                            */
+    TRJ_I32 version;            /* JNL_VERSION                          */
+    TRJ_I32 numjoints;          /* Joints in every entry                */
+} JNLHEAD;
+
+typedef struct _JNLENTRY
+{
+    TRJ_I32 frmcnt;             /* Digitized field count, from 0        */
+    TRJ_I32 field;              /* Tape field from the session start    */
+    char    timecode[JNL_TCLEN];/* SMPTE time code from the editor      */
+} JNLENTRY;
+
+/* Writer state for an open journal */
+typedef struct _JOURNAL
+{
+    FILE   *fp;
+    int     numjoints;
+    int     batch;              /* Entries per commit                   */
+    int     pending;            /* Entries buffered, not yet committed  */
+    long    committed;          /* Entries known to be on the disk      */
+    long    good;               /* Bytes of the file up to the last one */
+    char   *buf;                /* "batch" entries of buffer            */
+} JOURNAL;
+
+/* Where a recovered journal left off */
+typedef struct _JNLSTATE
+{
+    long    entries;            /* Good entries in the journal          */
+    long    frmcnt;             /* Field count of the last entry        */
+    long    field;              /* Tape field of the last entry         */
+    char    timecode[JNL_TCLEN];/* Time code of the last entry          */
+} JNLSTATE;
+
+/* Public journal functions */
+long     jnl_recover( const char *path, TRAJECT *t, JNLSTATE *st );
+JOURNAL *jnl_open( const char *path, int numjoints, int batch, int fresh );
+int      jnl_write( JOURNAL *jn, TRAJECT *t, long n, long frmcnt,
+                    long field, const char *timecode );
+int      jnl_commit( JOURNAL *jn );
+int      jnl_close( JOURNAL *jn );
+
+#endif /* JOURNAL_H */
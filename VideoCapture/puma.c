@@ -32,7 +32,46 @@
  do a point over, the F1 key will back up one marker each time it is
  pressed.  To quit, press the ESC key before digitizing the first point
  of an image.  The F4 key is used if the point is hidden
- (x=999, y=999 is inserted).
+ (x=999, y=999 is inserted, unscaled in the .DAT file as well).  In
+ memory the session store keeps a validity bit per joint per field
+ instead of the code.
+
+ Every digitized field is committed, with its tape time code, to a
+ journal (D:\PUMA\DATA\<datafile>.JNL) before the data files are
+ written.  If a session is interrupted, choosing DIGITIZE VIDEO again
+ for the same datafile offers to rebuild the data files from the
+ journal and resume after the last committed field.
+
+ Fields can also come from a recording on disk instead of the VCR:
+ choose FIELD SOURCE under INIT HARDWARE and give a field file, or a
+ raw, PGM or Y4M file (see fieldsrc.h).  The field is drawn on the VGA
+ and the mouse cursor marks it there, so none of the frame grabber code
+ above is needed, and the time code saved for a field is its number in
+ the recording.  Any field can be brought up straight away, and
+ skipping fields between acquires, or going back to one already
+ digitized, jumps straight to it without reading those in between.
+
+ CAPTURE TAPE grabs every field during one pass of the tape in PLAY or
+ slow play and writes it, behind the grabber, to the field file
+ D:\PUMA\DATA\<datafile>.FLD, which then becomes the recording to
+ digitize from.  Fields the disk can't keep up with are dropped and
+ counted; each keeps its place in the file's index, with no pixels,
+ so the numbering holds (see capture.h).
+
+ While digitizing, each joint is looked for near where it was in the
+ last field (see track.h).  A sure match is placed without asking and
+ shown as tracked; a fair one only brings the cursor to it, to be
+ taken with ENTER or moved.  F1 backs up over a tracked joint like any
+ other, and it is then left to the operator.  Tracking needs the
+ field's pixels, which a recording always has; from the VCR they must
+ be read back from the frame grabber (vcr_pixels).
+
+ AUTO DIGITIZE goes further with a recording: one field is digitized
+ by hand and every joint is tracked through the rest of the recording,
+ the joints at once where threads are built in (see autodig.h).  The
+ data files come out as from DIGITIZE VIDEO, and each point's score
+ is written to D:\PUMA\DATA\<datafile>.CNF so that only the points
+ that scored low need to be looked over.
 
  This program currently requires the presence of two directories.  Those
  directories are:
@@ -50,11 +89,13 @@
 
  To use this program, it should be compiled using:
 
-         cl /c /AL puma.c > errors
+         cl /c /AL puma.c traject.c trjfile.c filemap.c journal.c arena.c
+            fieldsrc.c capture.c track.c autodig.c worker.c > errors
 
  To link:
 
-         link /NOD /NOE puma menu,,,llibc7+graphics;
+         link /NOD /NOE puma menu traject trjfile filemap journal arena
+              fieldsrc capture track autodig worker,,,llibc7+graphics;
 
 
  The major limitations of the code are:
@@ -156,6 +197,14 @@ Internet: BrettLee@vm.cc.purdue.edu
 #include <process.h>
 
 #include "menu.h"     // Microsoft C public header file
+#include "traject.h"  // Columnar trajectory store
+#include "trjfile.h"  // Binary .TRJ trajectory file
+#include "journal.h"  // Crash-safe digitization journal
+#include "arena.h"    // Session scoped memory
+#include "fieldsrc.h" // Recorded fields on disk
+#include "capture.h"  // Capture ring and field writer
+#include "track.h"    // Marker tracking field to field
+#include "autodig.h"  // Whole recordings tracked from one field
 
                       // Many of the definitions, which are specific to
                       // the editor we use, were left in to eliminate
@@ -189,7 +238,13 @@ Internet: BrettLee@vm.cc.purdue.edu
 #define ESC       27
 #define F1        59
 #define LENGTH    25
-#define MAXJTS    20
+#define JNLSYNC   1         // Fields per journal commit
+#define GREYBASE  16        // First palette entry of the field greys
+#define RINGSLOTS 32        // Fields the capture ring holds
+#define TRKTAKE   900       // Tracking score to place a joint unasked
+#define TRKSHOW   500       // Score to put the cursor on the match
+#define GRABWIDTH  512      // Field from the frame grabber
+#define GRABHEIGHT 512
 #define NO        0
 #define YES       !NO
 
@@ -200,7 +255,7 @@ CONFIG config;
 struct nametype
 {
     char name[15];
-} jtnames[MAXJTS];
+} *jtnames;                           // numjoints names, from the session
 
 struct jttype
 {
@@ -209,7 +264,7 @@ struct jttype
 
 typedef struct frametype
 {
-    struct jttype joint[MAXJTS];
+    struct jttype *joint;              // numjoints joints, from the session
 } FRAMETYPE;
 
 typedef struct frametype FRAME;
@@ -221,9 +276,35 @@ struct
     short x1, y1, x2, y2; // boundaries
   } mouse;
 
+                      // Where the fields come from: the VCR through
+                      // the frame grabber, or a recording on disk
+
+typedef struct _SOURCE
+{
+    int  (*start)( char *what );     // Ready the field showing "what"
+    void (*find)( char *tc );        // Go back to the field at time code
+    void (*next)( int n );           // Move on n fields
+    void (*where)( char *tc );       // Time code of the current field
+    void (*show)( int on );          // Current field on or off the screen
+    void (*cursor)( int on );        // Cursor on or off the field
+    void (*place)( short x, short y );  // Cursor to x, y
+    int  (*pixels)( TRKFIELD *f );   // The field's pixels, NO if out of reach
+    void (*rest)( void );            // Break every framestop fields
+    void (*view)( void );            // Run the fields until ESC
+    void (*stop)( void );
+} SOURCE;
+
                                        // Global Variables
+SOURCE *source;
+FIELDSRC *fieldsrc;                   // The recording, for file_source
+long fieldnum;                        // Its current field
 FRAME *frame, *prevframe;
-char filename[LENGTH], edtalk[15];
+TRACKER *tracker;                     // Joints from one field to the next
+TRAJECT *traj;
+TRJFILE *trjfile;
+JOURNAL *journal;
+ARENA *session;
+char filename[LENGTH], edtalk[15], timecode[JNL_TCLEN];
 int skip, numframes, numjoints, framestop;
 double ctrlength, cfactor;
 
@@ -249,9 +330,39 @@ void  init_dt3852( void );
 void  format_setup(void);
 void  acquire_setup(u_short *, u_short *, u_short *);
 void  view_video( void );
+void  init_source( void );
+void  use_recording( FIELDSRC *s );
+int   grab_field( CAPPIX dst );
+void  capture_video( void );
+void  auto_digitize( void );
+int   vcr_start( char *what );
+void  vcr_find( char *tc );
+void  vcr_next( int n );
+void  vcr_where( char *tc );
+long  tc_fields( const char *tc );
+void  vcr_show( int on );
+void  vcr_cursor( int on );
+void  vcr_place( short x, short y );
+int   vcr_pixels( TRKFIELD *f );
+void  vcr_rest( void );
+void  vcr_view( void );
+int   file_start( char *what );
+void  file_find( char *tc );
+void  file_next( int n );
+void  file_where( char *tc );
+void  file_show( int on );
+void  file_cursor( int on );
+void  file_place( short x, short y );
+int   file_pixels( TRKFIELD *f );
+void  file_rest( void );
+void  file_view( void );
+void  file_stop( void );
 void  find_cfactor( void );
 void  DigitizeFrame( void );
-void  Digitizeit(int frmcnt,int totjoints,struct nametype jtnames[MAXJTS]);
+void  Digitizeit(int frmcnt,int totjoints,struct nametype *jtnames);
+void  store_frame( void );
+int   resume_session( void );
+void  open_session( void );
 void  conversions( void );
 void  intro_screen( void );
 void  menu_main( void );
@@ -268,23 +379,13 @@ void  save_data( int frmcnt, char type[4] );
 
 FRAME *create_frame( void )
 {
-   int i;
    FRAME *f;
-
-   f = (FRAME *) malloc( sizeof(FRAME) );
-   if( f == NULL )
-     {
-       printf( "Error:  create_frame()  malloc failed.\n" );
-       exit( 1 );
-     }
-   else
-     {
-       for( i = 0; i < numjoints; i++)
-         {
-            f->joint[i].x = 0;
-            f->joint[i].y = 0;
-          }
-     }
+   int n;
+                                 // room for the two control rod ends
+   n = ( numjoints > 2 ) ? numjoints : 2;
+   f = (FRAME *) arena_alloc( session, (long) sizeof(FRAME) );
+   f->joint = (struct jttype *)
+              arena_alloc( session, (long) n * sizeof(struct jttype) );
    return f;
 }
 
@@ -330,7 +431,7 @@ void move_mouse( void )
        mouse.y = mouse.y2 ;
 
                                // move cursor to mouse.x , .y
-    (specific to frame grabber)
+    source->place( mouse.x, mouse.y );
                                // get the mouse buttons
     regs.x.ax = 3;
     _int86( 0x33, &regs, &regs );
@@ -600,14 +701,275 @@ void acquire_setup(vgared, vgagreen, vgablue)
 }
 
 
-                          // Plays VHS thru image monitor
+                          // Plays the fields thru the display
 void view_video( void )
 {
-    int i;
-
     _clearscreen( _GCLEARSCREEN );
     _settextposition( 10, 5 );
     _outtext( " Press ESC to stop.");
+    source->view();
+    _clearscreen( _GCLEARSCREEN );
+}
+
+
+// ***********************************************************
+// ******************** Sources of Fields ********************
+// ***********************************************************
+//
+// Digitizing only asks "source" for fields.  vcr_source steps the tape
+// through the frame grabber onto the image monitor; file_source reads
+// a recording (fieldsrc.c) and draws it on the VGA, so a session can
+// be digitized from footage on disk, at disk speed, with no VCR or
+// frame grabber.  Choose one under INIT HARDWARE.
+
+SOURCE vcr_source =
+{
+    vcr_start, vcr_find, vcr_next, vcr_where, vcr_show,
+    vcr_cursor, vcr_place, vcr_pixels, vcr_rest, vcr_view, stop
+};
+
+SOURCE file_source =
+{
+    file_start, file_find, file_next, file_where, file_show,
+    file_cursor, file_place, file_pixels, file_rest, file_view, file_stop
+};
+
+
+void init_source( void )
+{
+    int c, width, height;
+    char reply, path[80];
+    FIELDSRC *s;
+
+    _clearscreen( _GCLEARSCREEN );
+    _settextposition( 7, 12 );
+    _outtext( "Digitize from the VCR or a Recording? <v/r> " );
+    do
+      {
+        reply = (__toascii(toupper(_getch())));
+      } while( reply != 'V' && reply != 'R');
+    if ( reply == 'V' )
+      {
+        fsrc_close( fieldsrc );
+        fieldsrc = NULL;
+        source = &vcr_source;
+        install_cursor();
+        _clearscreen( _GCLEARSCREEN );
+        return;
+      }
+    _settextposition( 9, 12 );
+    _outtext( "Name of recording (.RAW, .PGM or .Y4M): " );
+    scanf( "%79s", path );
+    _settextposition( 10, 12 );
+    _outtext( "Field width and height (raw only, else 0 0): " );
+    scanf( "%d %d", &width, &height );
+    if ((s = fsrc_open( path, width, height )) == NULL )
+      {
+        _settextposition( 12, 12 );
+        _outtext( "Recording not found, or not understood." );
+      }
+    else
+      {
+        use_recording( s );
+        _settextposition( 12, 12 );
+        printf( "%ld fields of %d x %d.", s->fields, s->width, s->height );
+      }
+    _settextposition( 14, 12 );
+    _outtext( "Press ENTER to continue..." );
+    while (( c = _getch()) != 13 );
+    _clearscreen( _GCLEARSCREEN );
+}
+
+
+                  // Digitize from the recording "s" from now on
+
+void use_recording( FIELDSRC *s )
+{
+    fsrc_close( fieldsrc );
+    fieldsrc = s;
+    fieldnum = -1;
+    source = &file_source;
+                                // mouse stays on the drawn field
+    mouse.x1 = mouse.y1 = 0;
+    mouse.x2 = (( s->width < 640 ) ? s->width : 640 ) - 1;
+    mouse.y2 = (( s->height < 480 ) ? s->height : 480 ) - 1;
+}
+
+
+                  // The VCR, thru the frame grabber
+
+int vcr_start( char *what )
+{
+    int c;
+
+    play();
+
+                    // Passthru mode on here
+
+    _clearscreen( _GCLEARSCREEN );
+    _settextposition( 10, 12 );
+    printf( "Position the tape at %s.", what );
+    _settextposition( 12, 12 );
+    _outtext( "VCR must be in PAUSE mode during acquisition." );
+    _settextposition( 16, 12 );
+    _outtext( "Press ENTER when ready..." );
+    while (( c = _getch()) != 13 );
+    _clearscreen( _GCLEARSCREEN );
+    return YES;
+}
+
+
+void vcr_find( char *tc )
+{
+    int i, c;
+
+    _clearscreen( _GCLEARSCREEN );
+    printf( "Position the tape at frame\n\n");
+    for ( i = 0; i < 7; i++ )
+      {
+        if ((i % 2) == 1 )
+          printf(":");
+        printf( "%c", tc[i] );
+      }
+    printf( "\n\nin pause mode.");
+    printf( "\n\nHit <ENTER> to continue.");
+    while (( c = _getch()) != 13 );
+    _clearscreen( _GCLEARSCREEN );
+}
+
+
+void vcr_next( int n )
+{
+    int i, j, k;
+
+    for ( k = 1; k <= n; k++ )
+      {
+        if ( n > 1 )
+          {                       // a skip, count it off
+            _settextposition( 3, 0 );
+            printf( "\rField skip count is : %02d", k );
+          }
+        adv();
+        for ( i = 0; i < 30000; i++ )     // let the deck settle
+          for ( j = 0; j < 60; j++ );
+      }
+}
+
+
+void vcr_where( char *tc )
+{
+    int i;
+
+    status();                       // Time code of this field
+    for ( i = 0; i < 7; i++ )
+       tc[i] = edtalk[i + 4];
+    tc[7] = '\0';
+}
+
+
+                  // Fields from 0:00:00:00 to time code tc (H:MM:SS:FF,
+                  // 30 frames a second, 2 fields a frame), or -1 if
+                  // the editor didn't answer with digits
+
+long tc_fields( const char *tc )
+{
+    int i;
+
+    for ( i = 0; i < 7; i++ )
+      if ( tc[i] < '0' || tc[i] > '9' )
+        return -1L;
+    return ((((tc[0] - '0') * 60L
+              + (tc[1] - '0') * 10 + (tc[2] - '0')) * 60L
+              + (tc[3] - '0') * 10 + (tc[4] - '0')) * 30L
+              + (tc[5] - '0') * 10 + (tc[6] - '0')) * 2L;
+}
+
+
+                            // Functions for image monitor
+                            // Dependant on frame grabber
+void vcr_show( int on )
+{
+     // clear the overlay and turn the display on, or off
+}
+
+
+void vcr_cursor( int on )
+{
+     // turn the image monitor's cursor on or off
+}
+
+
+void vcr_place( short x, short y )
+{
+     // move the image monitor's cursor to x, y
+}
+
+
+                  // Reads the field the tape is paused on into memory,
+                  // when its pixels match the cursor's one to one
+
+int vcr_pixels( TRKFIELD *f )
+{
+     // read the field from the board's acquire buffer
+     // (specific to frame grabber)
+
+    return NO;
+}
+
+
+                  // Takes the VCR out of PAUSE before it shuts
+                  // itself off, and brings it back to this frame
+
+void vcr_rest( void )
+{
+    int i, j;
+    char frame_num[15];
+
+    status();
+    for ( i = 0; i < 15; i ++ )
+       frame_num[i] = edtalk[i];
+    _clearscreen( _GCLEARSCREEN );
+    printf("STOPPING THE TAPE.");
+    printf("\n\nCHECK TAPE FOR EXACT POSITION.\n\n");
+    for ( i = 4; i < 11; i++ )
+      {
+        if ((i % 2) == 1 )
+          printf(":");
+        printf( "%c", frame_num[i] );
+      }
+    printf("\n\nPress <F1> to continue.");
+    while ( _getch() != 59 );
+    _clearscreen( _GCLEARSCREEN );
+    for ( i = 0; i < 30000; i++ )
+       for ( j = 0; j < 50; j++ );
+    stop();
+    for ( i = 0; i < 30000; i++ )
+      for ( j = 0; j < 75; j++ );
+    reg_rewind();
+    for ( i = 0; i < 30000; i++ )
+      for ( j = 0; j < 250; j++ );
+    stop();
+    _clearscreen( _GCLEARSCREEN );
+    printf( "Position the tape at frame\n\n");
+    for ( i = 4; i < 11; i++ )
+      {
+        if ((i % 2) == 1 )
+          printf(":");
+        printf( "%c", frame_num[i] );
+      }
+    printf( "\n\nin pause mode.");
+    printf( "\n\nHit <ENTER> to continue.");
+    play();
+    for ( i = 0; i < 30000; i++ )
+      for ( j = 0; j < 650; j++ );
+    pause();
+    while ( _getch() != 13 );
+}
+
+
+                          // Plays VHS thru image monitor
+void vcr_view( void )
+{
     play();
 
                     // Here is where we turn the passthru mode on
@@ -617,6 +979,392 @@ void view_video( void )
 
                     // And now off
 
+}
+
+
+                  // A recording on disk, drawn on the VGA
+
+int file_start( char *what )
+{
+    long n = -1;
+
+    _clearscreen( _GCLEARSCREEN );
+    _settextposition( 10, 12 );
+    printf( "Recording of %ld fields.", fieldsrc->fields );
+    while ( n < 0 || n >= fieldsrc->fields )
+      {
+        _settextposition( 12, 12 );
+        printf( "Field showing %s (0-%ld): ", what, fieldsrc->fields - 1 );
+        if ( scanf( "%ld", &n ) != 1 )
+          return NO;
+      }
+    fieldnum = n - 1;               // next( 1 ) brings up field n
+    _clearscreen( _GCLEARSCREEN );
+    return YES;
+}
+
+
+void file_find( char *tc )
+{
+    fieldnum = atol( tc );
+}
+
+
+void file_next( int n )
+{
+    fieldnum += n;
+}
+
+
+void file_where( char *tc )
+{
+    sprintf( tc, "%07ld", fieldnum % 10000000L );
+}
+
+
+void file_show( int on )
+{
+    FSRCPIX p;
+    static long textcolor[GREYBASE] =
+    {
+        _BLACK, _BLUE, _GREEN, _CYAN, _RED, _MAGENTA, _BROWN, _WHITE,
+        _GRAY, _LIGHTBLUE, _LIGHTGREEN, _LIGHTCYAN, _LIGHTRED,
+        _LIGHTMAGENTA, _YELLOW, _BRIGHTWHITE
+    };
+    struct videoconfig vc;
+    long grey[256];
+    int x, y, w, h;
+
+    if ( !on )
+      {
+        _setvideomode( _DEFAULTMODE );
+        return;
+      }
+    _getvideoconfig( &vc );
+    if ( vc.mode != _VRES256COLOR )
+      {                         // 16 text colors, then 240 greys
+        _setvideomode( _VRES256COLOR );
+        for ( x = 0; x < GREYBASE; x++ )
+          grey[x] = textcolor[x];
+        for ( x = GREYBASE; x < 256; x++ )
+          grey[x] = (long)((x - GREYBASE) * 63 / (255 - GREYBASE)) * 0x010101L;
+        _remapallpalette( grey );
+      }
+    if ((p = fsrc_field( fieldsrc, fieldnum )) == NULL )
+      {
+        _settextposition( 2, 2 );
+        _outtext( "No such field in the recording, or it was dropped." );
+        return;
+      }
+    w = ( fieldsrc->width < 640 ) ? fieldsrc->width : 640;
+    h = ( fieldsrc->height < 480 ) ? fieldsrc->height : 480;
+    for ( y = 0; y < h; y++, p += fieldsrc->pitch )
+      for ( x = 0; x < w; x++ )
+        {
+          _setcolor( GREYBASE + p[x] * (255 - GREYBASE) / 255 );
+          _setpixel( x, y );
+        }
+}
+
+
+void file_cursor( int on )
+{
+    regs.x.ax = on ? 1 : 2;         // show or hide the mouse cursor
+    _int86( 0x33, &regs, &regs );
+}
+
+
+void file_place( short x, short y )
+{
+    regs.x.ax = 4;
+    regs.x.cx = x;
+    regs.x.dx = y;
+    _int86( 0x33, &regs, &regs );
+}
+
+
+int file_pixels( TRKFIELD *f )
+{
+    FSRCPIX p;
+                                // the tracker's pointer isn't huge
+    if ( FSRC_REACH( fieldsrc ) > FSRC_FARMAX
+         || (p = fsrc_field( fieldsrc, fieldnum )) == NULL )
+      return NO;
+    f->pix = (const unsigned char *) p;
+    f->width = mouse.x2 + 1;        // as much as file_show() draws,
+    f->height = mouse.y2 + 1;       // one pixel to a cursor step
+    f->pitch = fieldsrc->pitch;
+    return YES;
+}
+
+
+void file_rest( void )
+{
+                                // nothing wears out on a disk
+}
+
+
+void file_view( void )
+{
+    if ( fieldnum < 0 )
+      fieldnum = 0;
+    for ( ; fieldnum < fieldsrc->fields; fieldnum++ )
+      {
+        file_show( YES );
+        if ( _kbhit() && _getch() == 27 )
+          break;
+      }
+    file_show( NO );
+}
+
+
+void file_stop( void )
+{
+}
+
+
+// ***********************************************************
+// ****************** Capture Tape to Disk *******************
+// ***********************************************************
+//
+// Grabs every field during one pass of the tape, in PLAY or slow
+// play, into a ring in memory (capture.c) that is written out behind
+// the grabber to D:\PUMA\DATA\<datafile>.FLD.  The tape never sits in
+// PAUSE, and the field file becomes the source to digitize from.
+
+                  // Waits for the next field and copies it to dst
+                  // (only lets it pass if dst is NULL); dst is huge
+                  // under DOS, a field being more than 64K
+
+int grab_field( CAPPIX dst )
+{
+     // acquire the next field, and read it into dst
+     // (specific to frame grabber)
+
+    return -1;
+}
+
+
+void capture_video( void )
+{
+    int c, width, height;
+    long fields, n, start, due;
+    char reply, fldfile[LENGTH + 20], tc[FLD_TCLEN], now[FLD_TCLEN];
+    CAPPIX p;
+    CAPRING *ring;
+    CAPSTATS st;
+    FIELDSRC *s;
+
+    _clearscreen( _GCLEARSCREEN );
+    width = GRABWIDTH;               // size of the grabber's field
+    height = GRABHEIGHT;
+    if ( filename[0] == '\0' || width <= 0 || height <= 0 )
+      {
+        _settextposition( 10, 12 );
+        _outtext( "Set up the frame grabber and the session first." );
+        _settextposition( 14, 12 );
+        _outtext( "Press ENTER to continue..." );
+        while (( c = _getch()) != 13 );
+        _clearscreen( _GCLEARSCREEN );
+        return;
+      }
+    strcpy( fldfile, "D:\\PUMA\\DATA\\");
+    strncat( fldfile, filename, strlen( filename ) + 1 );
+    strcat( fldfile, ".FLD" );
+    _settextposition( 7, 12 );
+    printf( "Capturing to %s", fldfile );
+    _settextposition( 9, 12 );
+    _outtext( "Number of fields to capture: " );
+    scanf( "%ld", &fields );
+    _settextposition( 10, 12 );
+    _outtext( "PLAY or SLOW play? <p/s> " );
+    do
+      {
+        reply = (__toascii(toupper(_getch())));
+      } while( reply != 'P' && reply != 'S');
+    if ((ring = cap_open( fldfile, width, height, RINGSLOTS )) == NULL )
+      {
+        _settextposition( 12, 12 );
+        _outtext( "Cannot create the field file, or a field is too big." );
+        _settextposition( 14, 12 );
+        _outtext( "Press ENTER to continue..." );
+        while (( c = _getch()) != 13 );
+        _clearscreen( _GCLEARSCREEN );
+        return;
+      }
+    _settextposition( 12, 12 );
+    _outtext( "Position the tape at the start, then press ENTER." );
+    while (( c = _getch()) != 13 );
+    _settextposition( 14, 12 );
+    _outtext( "Capturing.  Press ESC to stop early." );
+
+    if ( reply == 'S' )
+      slow_play();
+    else
+      play();
+    vcr_where( tc );                 // time code the pass starts at
+    start = tc_fields( tc );
+    for ( n = 0; n < fields; n++ )
+      {
+        if ( _kbhit() && _getch() == 27 )
+          break;
+        if ((p = cap_slot( ring )) == NULL )
+          grab_field( NULL );         // ring full, the field is dropped
+        else if ( grab_field( p ) == 0 )
+          cap_put( ring, n == 0 ? tc : NULL );
+        else
+          cap_drop( ring );
+        if ( cap_drain( ring, 1L ) > 0 && start >= 0 )
+          {                           // no writer thread under DOS: the
+            vcr_where( now );         // fields that went by during the
+            due = tc_fields( now ) - start;     // write are dropped
+            if ( due > fields )
+              due = fields;
+            if ( due > n + 1 )
+              {
+                cap_skip( ring, due - (n + 1) );
+                n = due - 1;
+              }
+          }
+      }
+    stop();
+
+    _settextposition( 16, 12 );
+    _outtext( "Writing the last fields..." );
+    c = cap_close( ring, &st );
+    _clearscreen( _GCLEARSCREEN );
+    _settextposition( 7, 12 );
+    printf( "%ld fields captured, %ld dropped.", st.fields, st.dropped );
+    _settextposition( 9, 12 );
+    printf( "At most %d of the %d ring slots were waiting for the disk.",
+            st.highwater, st.slots );
+    if ( c != 0 )
+      {
+        _settextposition( 11, 12 );
+        _outtext( "The field file could not all be written." );
+      }
+    else if ((s = fsrc_open( fldfile, width, height )) != NULL )
+      {
+        use_recording( s );
+        _settextposition( 11, 12 );
+        _outtext( "Digitizing will now be done from the field file." );
+      }
+    _settextposition( 14, 12 );
+    _outtext( "Press ENTER to continue..." );
+    while (( c = _getch()) != 13 );
+    _clearscreen( _GCLEARSCREEN );
+}
+
+
+// ***********************************************************
+// ******************* Auto Digitization *********************
+// ***********************************************************
+//
+// Digitizes a whole recording from one field placed by hand: every
+// joint is tracked through the rest of it (autodig.c), the data files
+// are written as DIGITIZE VIDEO writes them, and each point's score
+// goes to D:\PUMA\DATA\<datafile>.CNF, so only the points that scored
+// low need to be looked over.
+
+void auto_digitize( void )
+{
+    int c, k;
+    long fields, n;
+    char ftn[] = { ".FTN" };
+    char dat[] = { ".DAT" };
+    char trj[] = { ".TRJ" };
+    char cnffile[LENGTH + 20];
+    ARENAMARK mark;
+    ADIGCLIP clip;
+
+    _clearscreen( _GCLEARSCREEN );
+    if ( source != &file_source || filename[0] == '\0' )
+      {
+        _settextposition( 10, 12 );
+        _outtext( "Choose a recording under INIT HARDWARE and set up" );
+        _settextposition( 11, 12 );
+        _outtext( "the session first." );
+        _settextposition( 14, 12 );
+        _outtext( "Press ENTER to continue..." );
+        while (( c = _getch()) != 13 );
+        _clearscreen( _GCLEARSCREEN );
+        return;
+      }
+    if ( !source->start( "the desired location" ) )
+      return;
+    _settextposition( 10, 12 );
+    _outtext( "Fields to digitize, 0 for all: " );
+    scanf( "%ld", &fields );
+    arena_mark( session, &mark );       // frames are scratch for this run
+    frame = create_frame();
+    prevframe = create_frame();
+    traj_free( traj );
+    traj = traj_create( numjoints, ( fields > 0 ) ? fields : 1L );
+    traj->cfactor = cfactor;
+    traj->skip = skip;
+    tracker = trk_open( numjoints, TRK_HALF, TRK_REACH );
+
+    source->next( 1 );                  // as DIGITIZE VIDEO starts
+    source->where( timecode );
+    _clearscreen( _GCLEARSCREEN );
+    printf( "Digitize field %s by hand.", timecode );
+    Digitizeit( 0, numjoints, jtnames );
+
+    clip.src = fieldsrc;
+    clip.first = fieldnum;
+    clip.step = skip + 1;
+    clip.count = ( fields > 0 ) ? fields : fieldsrc->fields;
+    clip.traj = traj;
+    clip.row = 0;
+    clip.score = NULL;
+    _settextposition( 10, 12 );
+    printf( "Tracking %d joints through the recording...", numjoints );
+    adig_run( &clip, 1, TRK_REACH * ( skip + 1 ), 0 );
+
+    _settextposition( 12, 12 );
+    _outtext( "Writing the data files..." );
+    for ( n = 0; n < clip.count; n++ )
+      {
+        for ( k = 0; k < numjoints; k++ )
+          {
+            frame->joint[k].x = TRAJ_OK( traj, k, n ) ?
+                                TRAJ_X( traj, k )[n] : TRAJ_HIDDEN;
+            frame->joint[k].y = TRAJ_OK( traj, k, n ) ?
+                                TRAJ_Y( traj, k )[n] : TRAJ_HIDDEN;
+          }
+        save_data( (int) n, ftn );
+        save_data( (int) n, trj );
+        conversions();
+        save_data( (int) n, dat );
+      }
+    trj_close( trjfile );
+    trjfile = NULL;
+    strcpy( cnffile, "D:\\PUMA\\DATA\\");
+    strncat( cnffile, filename, strlen( filename ) + 1 );
+    strcat( cnffile, ".CNF" );
+    c = adig_save( &clip, cnffile );
+
+    _clearscreen( _GCLEARSCREEN );
+    _settextposition( 7, 12 );
+    printf( "%ld fields digitized.", clip.count );
+    _settextposition( 9, 12 );
+    printf( "%ld of %ld points scored under %d%% and should be checked",
+            clip.review, ( clip.count - 1 ) * numjoints,
+            ADIG_REVIEW / ( TRK_SCALE / 100 ));
+    _settextposition( 10, 12 );
+    printf( "(see %s).", cnffile );
+    if ( c != 0 )
+      {
+        _settextposition( 12, 12 );
+        _outtext( "The scores could not be written." );
+      }
+    adig_free( &clip );
+    trk_close( tracker );
+    tracker = NULL;
+    arena_release( session, &mark );
+    _settextposition( 14, 12 );
+    _outtext( "Press ENTER to continue..." );
+    while (( c = _getch()) != 13 );
     _clearscreen( _GCLEARSCREEN );
 }
 
@@ -630,15 +1378,12 @@ void view_video( void )
 
 void DigitizeFrame( void )
 {
-    int i, j, n, c, dig_choice, done, frmcnt = 0;
+    int c, dig_choice, done, frmcnt = 0;
+    ARENAMARK mark;
     short v;
-    char frame_num[15];
     char ftn[] = { ".FTN" };
     char dat[] = { ".DAT" };
-
-    play();
-
-               // Passthru mode on again
+    char trj[] = { ".TRJ" };
 
     _displaycursor( _GCURSOROFF );
     _setvideomode( _VRES16COLOR );
@@ -649,11 +1394,6 @@ void DigitizeFrame( void )
     _settextcolor( 14 );
     _setcolor( 14 );
     _outgtext( "PUMA DIGITIZATION" );
-    _moveto( 95, 250 );
-    _setfont( "t'tms rmn'h20w12" );
-    _outgtext( "Position tape at desired location." );
-    _moveto( 95, 285 );
-    _outgtext( "VCR must be in PAUSE mode during acquisition." );
     _setfont( "t'tms rmn'h15w8" );
     _moveto( 350, 455 );
     _outgtext( "Press ENTER when ready..." );
@@ -662,56 +1402,30 @@ void DigitizeFrame( void )
     _setvideomode( _DEFAULTMODE );
     _clearscreen( _GCLEARSCREEN );
     _unregisterfonts();
+    if ( !source->start( "the desired location" ) )
+      return;
+    arena_mark( session, &mark );       // frames are scratch for this run
     frame = create_frame();
     prevframe = create_frame();
+    traj_free( traj );                  // store for this session's fields
+    traj = traj_create( numjoints, framestop );
+    traj->cfactor = cfactor;
+    traj->skip = skip;
+    tracker = trk_open( numjoints, TRK_HALF, TRK_REACH );
+    frmcnt = resume_session();          // 0 unless resuming a journal
    do
      {
           // This is where we stop the VCR before 5 minutes expires
       if ((frmcnt > 0 ) && ((frmcnt % framestop ) == 0 ))
         {
-          status();     // Gets current time code of tape
-          for ( i = 0; i < 15; i ++ )
-             frame_num[i] = edtalk[i];
-          _clearscreen( _GCLEARSCREEN );
-          printf("STOPPING THE TAPE.");
-          printf("\n\nCHECK TAPE FOR EXACT POSITION.\n\n");
-          for ( i = 4; i < 11; i++ )
-            {
-              if ((i % 2) == 1 )
-                printf(":");
-              printf( "%c", frame_num[i] );
-            }
-          printf("\n\nPress <F1> to continue.");
-          while ( _getch() != 59 );
-          _clearscreen( _GCLEARSCREEN );
-          for ( i = 0; i < 30000; i++ )
-             for ( j = 0; j < 50; j++ );
-          stop();
-          for ( i = 0; i < 30000; i++ )
-            for ( j = 0; j < 75; j++ );
-          reg_rewind();
-          for ( i = 0; i < 30000; i++ )
-            for ( j = 0; j < 250; j++ );
-          stop();
-          _clearscreen( _GCLEARSCREEN );
-          printf( "Position the tape at frame\n\n");
-          for ( i = 4; i < 11; i++ )
-            {
-              if ((i % 2) == 1 )
-                printf(":");
-              printf( "%c", frame_num[i] );
-            }
-          printf( "\n\nin pause mode.");
-          printf( "\n\nHit <ENTER> to continue.");
-          play();
-          for ( i = 0; i < 30000; i++ )
-            for ( j = 0; j < 650; j++ );
-          pause();
-          while ( _getch() != 13 );
+          jnl_commit( journal );   // Nothing pending while stopped
+          source->rest();
         }
                       // Now, digitization continues
-      adv();
+      source->next( 1 );
+      source->where( timecode );      // Time code of this field
       _clearscreen( _GCLEARSCREEN );
+      source->show( YES );
       _settextposition( 20, 16 );
       _settextcolor( 14 );
       printf( "Displaying field %d", frmcnt );
@@ -727,30 +1441,42 @@ void DigitizeFrame( void )
         {
           _clearscreen (_GCLEARSCREEN );
           Digitizeit( frmcnt, numjoints, jtnames );
+          if ( journal != NULL            // committed before the text files
+              && jnl_write( journal, traj, (long) frmcnt, (long) frmcnt,
+                            (long) frmcnt * (skip + 1), timecode ) != 0 )
+            {
+              _settextposition( 10, 12 );
+              _outtext( "The journal could not be written, and is closed." );
+              _settextposition( 11, 12 );
+              printf( "The session can only be resumed after field %ld.",
+                      journal->committed - 1 );
+              _settextposition( 14, 12 );
+              _outtext( "Press ENTER to continue..." );
+              while (( c = _getch()) != 13 );
+              jnl_close( journal );
+              journal = NULL;
+            }
           save_data( frmcnt, ftn );
+          save_data( frmcnt, trj );
           conversions();
           save_data( frmcnt, dat );
           frmcnt++;
           _clearscreen( _GCLEARSCREEN );
           printf( "CURRENTLY ADVANCING VIDEO TAPE...");
-          for ( n = 0; n < skip; n++ )
-            {                     // FIELD SKIPS BETWEEN ACQUIRES
-              _settextposition( 3, 0 );
-              printf( "\rField skip count is : %02d", n + 1 );
-              adv();
-              for ( i = 0; i < 30000; i++ )
-                for ( j = 0; j < 60; j++ );
-            }
+          source->next( skip );          // FIELD SKIPS BETWEEN ACQUIRES
           done = NO;
          }
       } while (done == NO );
 
       frmcnt--;
-      free( prevframe );
-      free( frame );
-
-          // Turning passthru mode off again
-
+      trj_close( trjfile );              // header, names, records, index
+      trjfile = NULL;
+      jnl_close( journal );
+      journal = NULL;
+      trk_close( tracker );
+      tracker = NULL;
+      arena_release( session, &mark );
+      source->show( NO );
       _displaycursor( _GCURSOROFF );
       _setvideomode( _VRES16COLOR );
       _clearscreen( _GCLEARSCREEN );
@@ -766,7 +1492,7 @@ void DigitizeFrame( void )
       _moveto( 100, 225 );
       _outgtext(" the main menu.");
       while (( c = _getch()) != 13);
-      stop();
+      source->stop();
       _unregisterfonts();
       _displaycursor( _GCURSORON );
       _setvideomode( _DEFAULTMODE );
@@ -776,25 +1502,57 @@ void DigitizeFrame( void )
            // This function handles the digitization of the
            // images on the image monitor
 
-void Digitizeit( int framecnt, int totjoints, struct nametype jtnames[MAXJTS] )
+void Digitizeit( int framecnt, int totjoints, struct nametype *jtnames )
 {
-    int c, pointdone;
-    unsigned short jtcnt = 0;
+    int c, x, y, score, seen, pointdone;
+    unsigned short jtcnt = 0, reached = 0;
+    TRKFIELD still;
 
            // Turn cursor off for display of current x/y coord's
     _settextcursor( 0x2000 );
-
-                            // Passthru mode on again
+    source->show( YES );
+    seen = source->pixels( &still );   // NO: every joint by hand
 
                           // move mouse to center of the screen
 
+    mouse.x = ( mouse.x2 + 1 )>>1;
+    mouse.y = ( mouse.y2 + 1 )>>1;
+    source->place( mouse.x, mouse.y );
+    source->cursor( YES );
+
     do
     {
      pointdone = NO;
-     if( framecnt >= 1 )         // move mouse to previous location
-                                 // this doesn't seem to work
-       set_curs_xy(((short)((float)prevframe->joint[jtcnt].x)),
-                   ((short)((float)prevframe->joint[jtcnt].y)));
+     if ( framecnt >= 1 && prevframe->joint[jtcnt].x != TRAJ_HIDDEN )
+       {                         // look for the joint where it was
+         x = (int) prevframe->joint[jtcnt].x;
+         y = (int) prevframe->joint[jtcnt].y;
+         score = seen ? trk_find( tracker, jtcnt, &still, &x, &y ) : -1;
+         if ( score >= TRKTAKE && jtcnt >= reached )
+           {                     // sure of it, no need to ask
+             frame->joint[jtcnt].x = (double) x;
+             frame->joint[jtcnt].y = (double) y;
+             trk_learn( tracker, jtcnt, &still, x, y );
+             _settextposition( 18, 40 );
+             printf( "Tracked %-12s %3d%%", jtnames[jtcnt].name,
+                     score / ( TRK_SCALE / 100 ));
+             reached = ++jtcnt;
+             continue;
+           }
+         if ( score >= TRKSHOW || score < 0 )
+           {                     // the cursor must move with the mouse,
+             mouse.x = x;        // or move_mouse() puts it back
+             mouse.y = y;
+           }
+         else
+           {                     // a poor match, just where it was
+             mouse.x = (short) prevframe->joint[jtcnt].x;
+             mouse.y = (short) prevframe->joint[jtcnt].y;
+           }
+         source->place( mouse.x, mouse.y );
+       }
+     if ( jtcnt >= reached )
+       reached = jtcnt + 1;
      _settextposition( 20, 40 );
      _outtext( "Next joint: ");
      _settextposition( 20, 53 );
@@ -814,13 +1572,9 @@ void Digitizeit( int framecnt, int totjoints, struct nametype jtnames[MAXJTS] )
      c = _getch();
      if (c == 13)
        {
-         if ( framecnt >= 1 )
-           {
-             prevframe->joint[jtcnt].x = frame->joint[jtcnt].x;
-             prevframe->joint[jtcnt].y = frame->joint[jtcnt].y;
-           }
          frame->joint[jtcnt].x = (double) mouse.x;
          frame->joint[jtcnt].y = (double) mouse.y;
+         trk_learn( tracker, jtcnt, seen ? &still : NULL, mouse.x, mouse.y );
          jtcnt++;
          continue;
        }
@@ -836,17 +1590,23 @@ void Digitizeit( int framecnt, int totjoints, struct nametype jtnames[MAXJTS] )
        }
      if (c == 62 )
        {
-         frame->joint[jtcnt].x = 999;
-         frame->joint[jtcnt].y = 999;
+         frame->joint[jtcnt].x = TRAJ_HIDDEN;
+         frame->joint[jtcnt].y = TRAJ_HIDDEN;
+         trk_forget( tracker, jtcnt );
          jtcnt++;
          continue;
        }
    } while ( jtcnt < totjoints );
-
-                          // Last time, passthru mode off
-
-
-
+   if ( framecnt >= 0 )           // in pixels, before conversions()
+     for ( c = 0; c < totjoints; c++ )
+       {
+         prevframe->joint[c].x = frame->joint[c].x;
+         prevframe->joint[c].y = frame->joint[c].y;
+       }
+   if ( framecnt >= 0 )           // keep the field in the session store
+      store_frame();
+   source->cursor( NO );
+   source->show( NO );
    _settextcursor( 0x0707 );    // Turn cursor back on
    _clearscreen( _GCLEARSCREEN );
 }
@@ -866,12 +1626,9 @@ void find_cfactor( void )
     struct nametype sides[] = { "LEFT SIDE", "RIGHT SIDE" };
     long int xdist, ydist;
     double pixdist, sqdist, sum;
+    ARENAMARK mark;
     sum = i = j = 0;
 
-    play();
-
-                         // I lied, passthru mode on again
-
     _displaycursor( _GCURSOROFF );
     _setvideomode( _VRES16COLOR );
     _setcolor( 14 );
@@ -880,21 +1637,21 @@ void find_cfactor( void )
     _setfont( "t'helv'h125w80b" );
     _moveto( 0, 85 );
     _outgtext( "CONVERSION FACTOR DETERMINATION" );
-    _moveto( 100, 230 );
-    _setfont( "t'tms rmn'h25w10" );
-    _outgtext( "Position the tape at the");
-    _moveto( 100, 260 );
-    _outgtext( "measurement standard.  The VCR" );
-    _moveto( 100, 290 );
-    _outgtext( "must be in PAUSE mode to begin");
-    _moveto( 100, 320 );
-    _outgtext( "acquisition.");
     _setfont( "t'tms rmn'h15w8" );
     _moveto( 325, 420 );
     _outgtext( "Press ENTER when ready..." );
     while (( c = _getch()) != 13);
+    _setvideomode( _DEFAULTMODE );
+    if ( !source->start( "the measurement standard" ) )
+      {
+        _displaycursor( _GCURSORON );
+        _unregisterfonts();
+        return;
+      }
 
-    adv();
+    source->next( 1 );
+    _setvideomode( _VRES16COLOR );
+    _setcolor( 14 );
     _clearscreen( _GCLEARSCREEN );
     _setfont( "t'tms rmn'h125w80b" );
     _moveto( 70, 200 );
@@ -909,6 +1666,7 @@ void find_cfactor( void )
     _setvideomode( _DEFAULTMODE );
     _settextcolor( 14 );
 
+    arena_mark( session, &mark );
     frame = create_frame();
     while( n < 49 || n > 57 )
      {
@@ -947,11 +1705,8 @@ void find_cfactor( void )
               i++;
            }
         }
-
-               // Guess what, passthru mode off again
-
     sqdist = (sum / n);
-    stop();
+    source->stop();
 
     if (sqdist > 0 )
        {
@@ -978,11 +1733,28 @@ void find_cfactor( void )
         _outtext( "Press ENTER to continue...");
         while (( c = _getch()) != 13);
        }
-    free( frame );
+    arena_release( session, &mark );
     _clearscreen( _GCLEARSCREEN );
 }
 
 
+// *******************************************
+// APPEND FIELD TO THE TRAJECTORY STORE
+// *******************************************
+
+void store_frame( void )
+{
+    int i;
+    long n;
+
+    n = traj_append( traj );
+    for( i = 0; i < numjoints; i++ )
+      {
+         traj_point( traj, i, n, frame->joint[i].x, frame->joint[i].y );
+      }
+}
+
+
 // *******************************************
 // CONVERT TO REAL WORLD COORDINATES
 // *******************************************
@@ -992,12 +1764,111 @@ void conversions( void )
     int i;
     for( i = 0; i < numjoints; i++ )
       {
+         if ( ( frame->joint[i].x == TRAJ_HIDDEN )  // keep the hidden code
+           && ( frame->joint[i].y == TRAJ_HIDDEN ) )
+            continue;
          frame->joint[i].x = ( cfactor )*( frame->joint[i].x );
          frame->joint[i].y = ( cfactor )*( frame->joint[i].y );
       }
 }
 
 
+// *******************************************
+// START A NEW SESSION ARENA
+// *******************************************
+
+                    // Drops the last session's memory in one shot
+                    // and makes room for numjoints joint names
+
+void open_session( void )
+{
+    arena_free( session );
+    session = arena_create( ARENA_BLOCK );
+    jtnames = (struct nametype *)
+              arena_alloc( session, (long) numjoints * sizeof(struct nametype) );
+}
+
+
+// *******************************************
+// RESUME AN INTERRUPTED SESSION FROM ITS JOURNAL
+// *******************************************
+
+                    // Returns the field count to continue from
+
+int resume_session( void )
+{
+    int i, k;
+    long n, entries;
+    char jnlfile[LENGTH], reply;
+    char ftn[] = { ".FTN" };
+    char dat[] = { ".DAT" };
+    char trj[] = { ".TRJ" };
+    JNLSTATE st;
+
+    strcpy( jnlfile, "D:\\PUMA\\DATA\\");
+    strncat( jnlfile, filename, strlen( filename ) + 1 );
+    strncat( jnlfile, ".JNL", 4 );
+
+    entries = jnl_recover( jnlfile, traj, &st );
+    if ( entries > 0 )
+      {
+        _clearscreen( _GCLEARSCREEN );
+        _settextcolor( 14 );
+        printf( "The journal holds %ld digitized fields for %s.",
+                entries, filename );
+        printf( "\n\nLast field committed: %ld   at time code ",
+                st.frmcnt );
+        for ( i = 0; i < 7; i++ )
+          {
+            if ((i % 2) == 1 )
+              printf(":");
+            printf( "%c", st.timecode[i] );
+          }
+        printf( "\n\nResume after the last field? <Y or N> " );
+        do
+          {
+            reply = (__toascii(toupper(_getch())));
+          } while( reply != 'Y' && reply != 'N');
+
+        if ( reply == 'Y' )
+          {
+                     // Rebuild the data files from the journal
+            for ( n = 0; n < traj->numframes; n++ )
+              {
+                for ( k = 0; k < numjoints; k++ )
+                  {
+                    frame->joint[k].x = TRAJ_OK( traj, k, n ) ?
+                                        TRAJ_X( traj, k )[n] : TRAJ_HIDDEN;
+                    frame->joint[k].y = TRAJ_OK( traj, k, n ) ?
+                                        TRAJ_Y( traj, k )[n] : TRAJ_HIDDEN;
+                  }
+                save_data( (int) n, ftn );
+                save_data( (int) n, trj );
+                conversions();
+                save_data( (int) n, dat );
+              }
+            n = traj->numframes - 1;
+            for ( k = 0; k < numjoints; k++ )
+              {
+                frame->joint[k].x = prevframe->joint[k].x =
+                    TRAJ_OK( traj, k, n ) ? TRAJ_X( traj, k )[n] : TRAJ_HIDDEN;
+                frame->joint[k].y = prevframe->joint[k].y =
+                    TRAJ_OK( traj, k, n ) ? TRAJ_Y( traj, k )[n] : TRAJ_HIDDEN;
+              }
+            journal = jnl_open( jnlfile, numjoints, JNLSYNC, NO );
+
+            source->find( st.timecode );
+            printf( "CURRENTLY ADVANCING VIDEO TAPE...");
+            source->next( skip );          // FIELD SKIPS PAST THE LAST FIELD
+            return (int) st.frmcnt + 1;
+          }
+      }
+    traj->numframes = 0;           // Starting over, discard the journal
+    journal = jnl_open( jnlfile, numjoints, JNLSYNC, YES );
+    return 0;
+}
+
+
 // *******************************************
 // SAVE DATA / SESSIONS TO HARD DISK
 // *******************************************
@@ -1018,6 +1889,20 @@ void save_data( int frmcnt, char type[4] )
     strncat( datafile, type, 4 );
     speed = ((skip + 1) / 60.0);
 
+    if (type[1] == 'T')            // Binary .TRJ stays open all session
+      {
+       if ( frmcnt == 0 )
+         {
+          trj_close( trjfile );
+          trjfile = trj_create( datafile, numjoints, jtnames[0].name,
+                                sizeof(struct nametype), cfactor, skip );
+         }
+       if ( trjfile != NULL )
+          trj_append( trjfile, traj, (long) frmcnt,
+                      (long) frmcnt * (skip + 1) );
+       return;
+      }
+
     if (type[1] == 'D')
       {
        if ( frmcnt == 0)
@@ -1146,20 +2031,19 @@ void namejoints( int njts )
     _settextcolor( 14 );
     _clearscreen( _GCLEARSCREEN );
     _settextposition( 3, 18 );
-    _outtext( "NAME JOINTS IN ORDER OF DIGITIZATION (MAX = 20)" );
+    _outtext( "NAME JOINTS IN ORDER OF DIGITIZATION" );
     _settextposition( 4, 22 );
     _outtext( "(Maximum length of 12 characters)" );
 
-    j = 0;
     for( i = 0; i < njts; i++)
       {
-       if( i >= 10 )
-         {
-           _settextposition( 8+j, 40 );
-           j++;
-         }
+       j = i % 20;                     // 20 names to a screen
+       if(( i > 0 ) && ( j == 0 ))
+         _clearscreen( _GCLEARSCREEN );
+       if( j >= 10 )
+         _settextposition( 8+j-10, 40 );
        else
-       _settextposition( 8+i, 10 );
+         _settextposition( 8+j, 10 );
        printf( "Name of joint %d:  ", i + 1 );
        scanf( "%12s", &jtnames[i].name );
        _strupr( jtnames[i].name );
@@ -1229,6 +2113,7 @@ void session_setup()
               scanf( "%s", &filename);
               fscanf( fpSESS, "%lf\n%d\n%d\n%lf\n%d",
                   &cfactor, &framestop, &skip, &ctrlength, &numjoints );
+              open_session();
               for( i = 0; i < numjoints; i++ )
                   fscanf( fpSESS, "\n%s", &jtnames[i].name );
               fclose( fpSESS );
@@ -1285,6 +2170,7 @@ void session_setup()
                ctrlength = (ctrlength * .9144);
          else if ( units == 'I' )
                ctrlength = (ctrlength / 39.37);
+         open_session();
          namejoints( numjoints );
        }
     }
@@ -1347,6 +2233,7 @@ void setup_menu( void )
     {
      { 0, "VCR & EDITOR" },
      { 0, "FRAME GRABBER" },
+     { 0, "FIELD SOURCE" },
      { 0, "MAIN MENU" },
      { 0, "" }
     };
@@ -1355,6 +2242,7 @@ void setup_menu( void )
     {
        EDITOR,
        FRAME,
+       FIELDS,
        RETURN
      };
 
@@ -1371,6 +2259,10 @@ void setup_menu( void )
          init_dt3852();
          done = NO;
          continue;
+       case FIELDS:
+         init_source();
+         done = NO;
+         continue;
        case RETURN:
          _clearscreen( _GCLEARSCREEN );
          done = YES;
@@ -1391,6 +2283,8 @@ void menu_main( void )
      {  6, "SETUP SESSION"},
      {  0, "CONVERSION FACTOR"},
      {  5, "VIEW TAPE" },
+     {  1, "CAPTURE TAPE" },
+     {  1, "AUTO DIGITIZE" },
      {  0, "DIGITIZE VIDEO" },
      {  0, "QUIT" },
      {  0, "" }
@@ -1402,6 +2296,8 @@ void menu_main( void )
      SESSION,
      CONVERSION,
      VIEW,
+     CAPTURE,
+     AUTODIG,
      DIGITIZE,
      QUIT
      };
@@ -1428,12 +2324,24 @@ void menu_main( void )
             view_video();
             done = NO;
             continue;
+         case CAPTURE:
+            capture_video();
+            done = NO;
+            continue;
+         case AUTODIG:
+            auto_digitize();
+            done = NO;
+            continue;
          case DIGITIZE:
             DigitizeFrame();
             done = NO;
             continue;
          case QUIT:
-            stop();
+            source->stop();
+            fsrc_close( fieldsrc );
+            fieldsrc = NULL;
+            arena_free( session );
+            session = NULL;
             term_tiga;
             _clearscreen( _GCLEARSCREEN );
             done = YES;
@@ -1492,6 +2400,8 @@ void intro_screen( void )
 void main(void)
 {
     int c;
+    open_session();             // empty until a session is set up
+    source = &vcr_source;       // until a recording is chosen
     intro_screen();
                                // causes mouse crash
 /*
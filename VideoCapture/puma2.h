@@ -10,6 +10,14 @@
 #include <graph.h>
 #include <memory.h>
 #include <process.h>
+#include "traject.h"  // Columnar trajectory store
+#include "trjfile.h"  // Binary .TRJ trajectory file
+#include "journal.h"  // Crash-safe digitization journal
+#include "arena.h"    // Session scoped memory
+#include "fieldsrc.h" // Recorded fields on disk
+#include "capture.h"  // Capture ring and field writer
+#include "track.h"    // Marker tracking field to field
+#include "autodig.h"  // Whole recordings tracked from one field
 
 #define COM1      0x3F8
 #define LSR       5
@@ -40,7 +48,11 @@
 #define ESC       27
 #define F1        59
 #define LENGTH    25
-#define MAXJTS    20
+#define JNLSYNC   1         // Fields per journal commit
+#define GREYBASE  16        // First palette entry of the field greys
+#define RINGSLOTS 32        // Fields the capture ring holds
+#define TRKTAKE   900       // Tracking score to place a joint unasked
+#define TRKSHOW   500       // Score to put the cursor on the match
 #define NO        0
 #define YES       !NO
 
@@ -50,7 +62,7 @@ CONFIG config;
 struct nametype
 {
     char name[15];
-} jtnames[MAXJTS];
+} *jtnames;                           // numjoints names, from the session
 
 struct jttype
 {
@@ -59,7 +71,7 @@ struct jttype
 
 typedef struct frametype
 {
-    struct jttype joint[MAXJTS];
+    struct jttype *joint;              // numjoints joints, from the session
 } FRAMETYPE;
 
 typedef struct frametype FRAME;
@@ -71,8 +83,35 @@ struct
     short x1, y1, x2, y2; // boundaries
   } mouse;
 
+                      // Where the fields come from: the VCR through
+                      // the frame grabber, or a recording on disk
+
+typedef struct _SOURCE
+{
+    int  (*start)( char *what );     // Ready the field showing "what"
+    void (*find)( char *tc );        // Go back to the field at time code
+    void (*next)( int n );           // Move on n fields
+    void (*where)( char *tc );       // Time code of the current field
+    void (*show)( int on );          // Current field on or off the screen
+    void (*cursor)( int on );        // Cursor on or off the field
+    void (*place)( short x, short y );  // Cursor to x, y
+    int  (*pixels)( TRKFIELD *f );   // The field's pixels, NO if out of reach
+    void (*rest)( void );            // Break every framestop fields
+    void (*view)( void );            // Run the fields until ESC
+    void (*stop)( void );
+} SOURCE;
+
+SOURCE *source;
+FIELDSRC *fieldsrc;                   // The recording, for file_source
+long fieldnum;                        // Its current field
+
 FRAME *frame, *prevframe;
-char filename[LENGTH], edtalk[15], array[16][1024];
+TRACKER *tracker;                     // Joints from one field to the next
+TRAJECT *traj;
+TRJFILE *trjfile;
+JOURNAL *journal;
+ARENA *session;
+char filename[LENGTH], edtalk[15], array[16][1024], timecode[JNL_TCLEN];
 int skip, numframes, numjoints, framestop, Warr[5];
 double ctrlength, cfactor;
 static u_short vgar[256], vgag[256], vgab[256];
@@ -98,9 +137,39 @@ void  init_dt3852( void );
 void  format_setup(void);
 void  acquire_setup(u_short *, u_short *, u_short *);
 void  view_video( void );
+void  init_source( void );
+void  use_recording( FIELDSRC *s );
+int   grab_field( CAPPIX dst );
+void  capture_video( void );
+void  auto_digitize( void );
+int   vcr_start( char *what );
+void  vcr_find( char *tc );
+void  vcr_next( int n );
+void  vcr_where( char *tc );
+long  tc_fields( const char *tc );
+void  vcr_show( int on );
+void  vcr_cursor( int on );
+void  vcr_place( short x, short y );
+int   vcr_pixels( TRKFIELD *f );
+void  vcr_rest( void );
+void  vcr_view( void );
+int   file_start( char *what );
+void  file_find( char *tc );
+void  file_next( int n );
+void  file_where( char *tc );
+void  file_show( int on );
+void  file_cursor( int on );
+void  file_place( short x, short y );
+int   file_pixels( TRKFIELD *f );
+void  file_rest( void );
+void  file_view( void );
+void  file_stop( void );
 void  find_cfactor( void );
 void  DigitizeFrame( void );
-void  Digitizeit(int frmcnt,int totjoints,struct nametype jtnames[MAXJTS]);
+void  Digitizeit(int frmcnt,int totjoints,struct nametype *jtnames);
+void  store_frame( void );
+int   resume_session( void );
+void  open_session( void );
 void  conversions( void );   
 void  intro_screen( void );      
 void  menu_main( void );
@@ -0,0 +1,236 @@
+/**************************************************************************
+ *  TRACK.C
+ *
+ * Marker tracking by template matching. The following functions are
+ * public:
+ *
+ *   trk_open       -   Creates a tracker for a set of joints
+ *   trk_learn      -   Takes a joint's template from where it was placed
+ *   trk_forget     -   Drops a joint's template
+ *   trk_find       -   Looks for a joint near where it was last
+ *   trk_close      -   Frees the tracker
+ *
+ * For every place the template could sit, the correlation needs the
+ * sum and the sum of squares of the pixels under it, and the sum of
+ * their products with the template's.  The first two come from summed
+ * area tables built once over the search window, in four lookups each,
+ * so only the products are summed pixel by pixel: one multiply and add
+ * per pixel over rows that lie one after another in memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "track.h"
+
+/* Sum over the side by side square at (u, v) of a summed area table
+ * "s" whose rows are "w" + 1 entries long */
+#define TRK_BOX( s, w, u, v, side ) \
+    ( (s)[(long) ((v) + (side)) * ((w) + 1) + (u) + (side)] \
+    - (s)[(long) (v) * ((w) + 1) + (u) + (side)] \
+    - (s)[(long) ((v) + (side)) * ((w) + 1) + (u)] \
+    + (s)[(long) (v) * ((w) + 1) + (u)] )
+
+
+/* trk_open - Creates a tracker for "joints" joints, with templates
+ * "half" pixels each way of the joint that are looked for "reach"
+ * pixels each way of where it was (TRK_HALF and TRK_REACH if zero).
+ * No joint has a template yet.
+ *
+ * Return: The new tracker
+ */
+TRACKER *trk_open( int joints, int half, int reach )
+{
+    TRACKER *t;
+    long n;
+
+    t = (TRACKER *) malloc( sizeof(TRACKER) );
+    if( t == NULL )
+      {
+        printf( "Error:  trk_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    t->joints = (joints > 0) ? joints : 1;
+    t->half = (half > 0) ? half : TRK_HALF;
+    if( t->half > TRK_MAXHALF )
+       t->half = TRK_MAXHALF;
+    t->reach = (reach > 0) ? reach : TRK_REACH;
+    if( t->reach > TRK_MAXREACH )
+       t->reach = TRK_MAXREACH;
+    t->side = 2 * t->half + 1;
+    t->area = (long) t->side * t->side;
+    t->span = t->side + 2 * t->reach;
+    n = (long) (t->span + 1) * (t->span + 1);
+
+    t->tmpl = (unsigned char *) malloc( (size_t) (t->joints * t->area) );
+    t->tsum = (double *) malloc( t->joints * sizeof(double) );
+    t->tvar = (double *) calloc( t->joints, sizeof(double) );
+    t->sat = (long *) malloc( (size_t) n * sizeof(long) );
+    t->sat2 = (long *) malloc( (size_t) n * sizeof(long) );
+    if( t->tmpl == NULL || t->tsum == NULL || t->tvar == NULL
+        || t->sat == NULL || t->sat2 == NULL )
+      {
+        printf( "Error:  trk_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    return t;
+}
+
+
+/* trk_learn - Takes joint "k"'s template from field "f" around (x, y),
+ * where the joint has just been placed.  A joint too near the edge of
+ * the field, or on pixels all of one shade, is left without one.  With
+ * no tracker ("t" NULL) nothing is done.
+ */
+void trk_learn( TRACKER *t, int k, const TRKFIELD *f, int x, int y )
+{
+    const unsigned char *p;
+    unsigned char *q;
+    long sum, sum2;
+    int i, j;
+
+    if( t == NULL || k < 0 || k >= t->joints )
+       return;
+    t->tvar[k] = 0.0;
+    if( f == NULL || f->pix == NULL
+        || x - t->half < 0 || x + t->half >= f->width
+        || y - t->half < 0 || y + t->half >= f->height )
+       return;
+
+    p = f->pix + (long) (y - t->half) * f->pitch + (x - t->half);
+    q = t->tmpl + k * t->area;
+    sum = sum2 = 0L;
+    for( j = 0; j < t->side; j++, p += f->pitch )
+       for( i = 0; i < t->side; i++ )
+         {
+           *q++ = p[i];
+           sum += p[i];
+           sum2 += (long) p[i] * p[i];
+         }
+    t->tsum[k] = (double) sum;
+    t->tvar[k] = (double) t->area * sum2 - (double) sum * sum;
+    if( t->tvar[k] < 0.5 )
+       t->tvar[k] = 0.0;
+}
+
+
+/* trk_forget - Drops joint "k"'s template, as when it is hidden.  With
+ * no tracker ("t" NULL) nothing is done.
+ */
+void trk_forget( TRACKER *t, int k )
+{
+    if( t != NULL && k >= 0 && k < t->joints )
+       t->tvar[k] = 0.0;
+}
+
+
+/* trk_find - Looks for joint "k" in field "f" within the tracker's
+ * reach of (*x, *y), where it was in the last field.  (*x, *y) is
+ * moved to the best match.
+ *
+ * Return: The match's score, 0 to TRK_SCALE, or -1 if there is no
+ *         tracker, the joint has no template or the field has no room
+ *         to look
+ */
+int trk_find( TRACKER *t, int k, const TRKFIELD *f, int *x, int *y )
+{
+    const unsigned char *w, *p, *q;
+    long cross, s, s2, rs, rs2, *row, *row2;
+    double n, wvar, r, best;
+    int x0, y0, ww, wh, u, v, i, j, bu, bv;
+
+    if( t == NULL || k < 0 || k >= t->joints || t->tvar[k] <= 0.0
+        || f == NULL || f->pix == NULL )
+       return -1;
+
+    /* The window: every pixel the template could cover */
+    x0 = *x - t->reach - t->half;
+    y0 = *y - t->reach - t->half;
+    ww = t->span;
+    wh = t->span;
+    if( x0 < 0 )
+      {
+        ww += x0;
+        x0 = 0;
+      }
+    if( y0 < 0 )
+      {
+        wh += y0;
+        y0 = 0;
+      }
+    if( x0 + ww > f->width )
+       ww = f->width - x0;
+    if( y0 + wh > f->height )
+       wh = f->height - y0;
+    if( ww < t->side || wh < t->side )
+       return -1;
+    w = f->pix + (long) y0 * f->pitch + x0;
+
+    /* Summed area tables, a row and a column of zeros in front */
+    memset( t->sat, 0, (ww + 1) * sizeof(long) );
+    memset( t->sat2, 0, (ww + 1) * sizeof(long) );
+    for( j = 0, p = w; j < wh; j++, p += f->pitch )
+      {
+        row = t->sat + (long) (j + 1) * (ww + 1);
+        row2 = t->sat2 + (long) (j + 1) * (ww + 1);
+        row[0] = row2[0] = rs = rs2 = 0L;
+        for( i = 0; i < ww; i++ )
+          {
+            rs += p[i];
+            rs2 += (long) p[i] * p[i];
+            row[i + 1] = row[i + 1 - (ww + 1)] + rs;
+            row2[i + 1] = row2[i + 1 - (ww + 1)] + rs2;
+          }
+      }
+
+    n = (double) t->area;
+    best = -2.0;
+    bu = bv = 0;
+    for( v = 0; v + t->side <= wh; v++ )
+       for( u = 0; u + t->side <= ww; u++ )
+         {
+           s = TRK_BOX( t->sat, ww, u, v, t->side );
+           s2 = TRK_BOX( t->sat2, ww, u, v, t->side );
+           wvar = n * s2 - (double) s * s;
+           if( wvar < 0.5 )
+              continue;             /* flat, nothing to match */
+           cross = 0L;
+           p = w + (long) v * f->pitch + u;
+           q = t->tmpl + k * t->area;
+           for( j = 0; j < t->side; j++, p += f->pitch, q += t->side )
+              for( i = 0; i < t->side; i++ )
+                 cross += (long) q[i] * p[i];
+           r = (n * cross - t->tsum[k] * s) / sqrt( t->tvar[k] * wvar );
+           if( r > best )
+             {
+               best = r;
+               bu = u;
+               bv = v;
+             }
+         }
+    if( best < -1.5 )
+       return 0;
+    *x = x0 + bu + t->half;
+    *y = y0 + bv + t->half;
+    if( best <= 0.0 )
+       return 0;
+    if( best >= 1.0 )
+       return TRK_SCALE;
+    return (int) (best * TRK_SCALE + 0.5);
+}
+
+
+/* trk_close - Frees the tracker.
+ */
+void trk_close( TRACKER *t )
+{
+    if( t == NULL )
+       return;
+    free( t->tmpl );
+    free( t->tsum );
+    free( t->tvar );
+    free( t->sat );
+    free( t->sat2 );
+    free( t );
+}
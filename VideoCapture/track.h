@@ -0,0 +1,60 @@
+/* TRACK.H
+ *
+ * Marker tracking from one field to the next.  When a joint is placed
+ * the square of pixels around it is kept as that joint's template; in
+ * the next field the template is looked for within reach pixels each
+ * way of where the joint was, and the best match by normalized cross
+ * correlation is taken as the joint's new place.
+ *
+ * The score is the correlation scaled to 0 - TRK_SCALE; it does not
+ * change with the brightness or contrast of the field, only with how
+ * much the marker's surroundings still look the same.  The caller
+ * decides what score is good enough to take the place without asking
+ * the operator.
+ *
+ * The sums are kept in longs, so a template may be no more than
+ * TRK_MAXHALF pixels each way and the reach no more than TRK_MAXREACH.
+ */
+
+/* Include only once */
+#ifndef TRACK_H
+#define TRACK_H
+
+#define TRK_HALF      7         /* Template is 2 * half + 1 pixels square */
+#define TRK_REACH     16        /* Pixels each way to look for a marker */
+#define TRK_MAXHALF   20
+#define TRK_MAXREACH  64
+#define TRK_SCALE     1000      /* Score of a perfect match             */
+
+/* One field's pixels, 8 bit grey */
+typedef struct _TRKFIELD
+{
+    const unsigned char *pix;   /* Pixel (x, y) at pix[y * pitch + x]   */
+    int     width, height;
+    long    pitch;
+} TRKFIELD;
+
+typedef struct _TRACKER
+{
+    int     joints;
+    int     half;               /* Template is side pixels square       */
+    int     side;
+    int     reach;
+    long    area;               /* side * side                          */
+    unsigned char *tmpl;        /* Joint k's template at tmpl + k * area */
+    double *tsum;               /* Sum of each template's pixels        */
+    double *tvar;               /* area * sum of squares - sum * sum,   */
+                                /*   0 if the joint has no template     */
+    int     span;               /* Widest search window, in pixels      */
+    long   *sat;                /* Summed area tables of the window,    */
+    long   *sat2;               /*   of pixels and of their squares     */
+} TRACKER;
+
+/* Public tracking functions */
+TRACKER *trk_open( int joints, int half, int reach );
+void     trk_learn( TRACKER *t, int k, const TRKFIELD *f, int x, int y );
+void     trk_forget( TRACKER *t, int k );
+int      trk_find( TRACKER *t, int k, const TRKFIELD *f, int *x, int *y );
+void     trk_close( TRACKER *t );
+
+#endif /* TRACK_H */
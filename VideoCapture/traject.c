@@ -0,0 +1,252 @@
+/**************************************************************************
+ *  TRAJECT.C
+ *
+ * Columnar trajectory store for a digitization session. The following
+ * functions are public:
+ *
+ *   traj_create    -   Allocates an empty store for a number of joints
+ *   traj_free      -   Releases a store
+ *   traj_reserve   -   Grows every column to hold at least n fields
+ *   traj_append    -   Adds one zeroed field and returns its index
+ *   traj_load      -   Reads text records of (x,y) pairs into the store
+ *   traj_point     -   Stores one point, or marks it hidden
+ *   traj_hide      -   Marks one point hidden
+ *   traj_weights   -   Expands a run of mask bits to 0.0 / 1.0 weights
+ *
+ * The layout is described in TRAJECT.H.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "traject.h"
+
+/* Prototype for internal function */
+static double *traj_align( void *block );
+
+
+/* traj_align - Rounds a malloc'd pointer up to the next TRAJ_ALIGN
+ * boundary.  Callers over-allocate by TRAJ_ALIGN bytes.
+ */
+static double *traj_align( void *block )
+{
+    size_t pad;
+
+    pad = (TRAJ_ALIGN - ((size_t) block % TRAJ_ALIGN)) % TRAJ_ALIGN;
+    return (double *) ((char *) block + pad);
+}
+
+
+/* traj_create - Allocates a store for "numjoints" joints with room for
+ * "hint" fields before the first regrowth.
+ *
+ * Return: The new store.  Exits if memory cannot be allocated.
+ */
+TRAJECT *traj_create( int numjoints, long hint )
+{
+    TRAJECT *t;
+
+    t = (TRAJECT *) malloc( sizeof(TRAJECT) );
+    if( t != NULL )
+      {
+        t->col = (double **) calloc( 2 * numjoints + 1, sizeof(double *) );
+        t->block = (void **) calloc( 2 * numjoints + 1, sizeof(void *) );
+        t->valid = (unsigned char **) calloc( numjoints + 1,
+                                              sizeof(unsigned char *) );
+      }
+    if( t == NULL || t->col == NULL || t->block == NULL || t->valid == NULL )
+      {
+        printf( "Error:  traj_create()  malloc failed.\n" );
+        exit( 1 );
+      }
+    t->numjoints = numjoints;
+    t->numframes = 0;
+    t->capacity = 0;
+    t->skip = 0;
+    t->cfactor = 1.0;
+    if( hint > TRAJ_MAXCAP )
+       hint = TRAJ_MAXCAP;
+    traj_reserve( t, (hint > 0) ? hint : TRAJ_LANE );
+    return t;
+}
+
+
+/* traj_free - Releases the columns and the store itself.
+ */
+void traj_free( TRAJECT *t )
+{
+    int i;
+
+    if( t == NULL )
+       return;
+    for( i = 0; i < 2 * t->numjoints; i++ )
+       free( t->block[i] );
+    for( i = 0; i < t->numjoints; i++ )
+       free( t->valid[i] );
+    free( t->col );
+    free( t->block );
+    free( t->valid );
+    free( t );
+}
+
+
+/* traj_reserve - Makes room for at least "frames" fields per column.
+ * Capacity is rounded up to a whole lane and at least doubled on each
+ * regrowth (but not past TRAJ_MAXCAP), so appending one field at a
+ * time stays amortized O(1).  Each column and mask is moved to a new
+ * allocation of its own.  Exits if "frames" is more than TRAJ_MAXCAP
+ * or memory cannot be allocated.
+ */
+void traj_reserve( TRAJECT *t, long frames )
+{
+    long cap;
+    int i;
+    void *block;
+    double *col;
+    unsigned char *valid;
+
+    if( frames <= t->capacity )
+       return;
+    if( frames > TRAJ_MAXCAP )
+      {
+        printf( "Error:  traj_reserve()  %ld fields is more than a column"
+                " holds (%ld).\n", frames, (long) TRAJ_MAXCAP );
+        exit( 1 );
+      }
+    cap = (t->capacity > 0) ? t->capacity * 2 : TRAJ_LANE;
+    if( cap < frames )
+       cap = frames;
+    cap = (cap + TRAJ_LANE - 1) / TRAJ_LANE * TRAJ_LANE;
+    if( cap > TRAJ_MAXCAP )
+       cap = TRAJ_MAXCAP;
+
+    for( i = 0; i < 2 * t->numjoints; i++ )
+      {
+        block = malloc( (size_t) (cap * sizeof(double) + TRAJ_ALIGN) );
+        if( block == NULL )
+          {
+            printf( "Error:  traj_reserve()  malloc failed.\n" );
+            exit( 1 );
+          }
+        col = traj_align( block );
+        memset( col, 0, (size_t) (cap * sizeof(double)) );
+        if( t->block[i] != NULL )
+          {
+            memcpy( col, t->col[i], (size_t) t->numframes * sizeof(double) );
+            free( t->block[i] );
+          }
+        t->block[i] = block;
+        t->col[i] = col;
+      }
+    for( i = 0; i < t->numjoints; i++ )
+      {
+        valid = (unsigned char *) calloc( (size_t) (cap >> 3) + 1, 1 );
+        if( valid == NULL )
+          {
+            printf( "Error:  traj_reserve()  malloc failed.\n" );
+            exit( 1 );
+          }
+        if( t->valid[i] != NULL )
+          {
+            memcpy( valid, t->valid[i], (size_t) (t->capacity >> 3) );
+            free( t->valid[i] );
+          }
+        t->valid[i] = valid;
+      }
+    t->capacity = cap;
+}
+
+
+/* traj_append - Adds one field to the end of the store.
+ *
+ * Return: The index of the new field; its coordinates are zero and
+ *         every joint is marked valid.
+ */
+long traj_append( TRAJECT *t )
+{
+    long n;
+    int j;
+
+    traj_reserve( t, t->numframes + 1 );
+    n = t->numframes++;
+    for( j = 0; j < t->numjoints; j++ )
+      {
+        TRAJ_X( t, j )[n] = 0.0;
+        TRAJ_Y( t, j )[n] = 0.0;
+        TRAJ_MASK( t, j )[n >> 3] |= (unsigned char) (1 << (n & 7));
+      }
+    return n;
+}
+
+
+/* traj_load - Reads whitespace separated records of "numjoints" (x,y)
+ * pairs, one record per field, as written to the .DAT and .DTA files.
+ * Line breaks inside a record are ignored.  Reading stops at end of
+ * file or after "maxframes" records (maxframes <= 0 reads them all).
+ *
+ * Return: The number of complete records appended
+ */
+long traj_load( TRAJECT *t, FILE *fp, long maxframes )
+{
+    long n, count = 0;
+    int j;
+    double x, y;
+
+    while( maxframes <= 0 || count < maxframes )
+      {
+        n = traj_append( t );
+        for( j = 0; j < t->numjoints; j++ )
+          {
+            if( fscanf( fp, "%lf%lf", &x, &y ) != 2 )
+              {
+                t->numframes--;       /* drop the partial record */
+                return count;
+              }
+            traj_point( t, j, n, x, y );
+          }
+        count++;
+      }
+    return count;
+}
+
+
+/* traj_point - Stores (x,y) as joint "j" of field "n".  A point given
+ * as the hidden point code (TRAJ_HIDDEN, TRAJ_HIDDEN) is marked hidden
+ * instead.
+ */
+void traj_point( TRAJECT *t, int j, long n, double x, double y )
+{
+    if( x == TRAJ_HIDDEN && y == TRAJ_HIDDEN )
+      {
+        traj_hide( t, j, n );
+        return;
+      }
+    TRAJ_X( t, j )[n] = x;
+    TRAJ_Y( t, j )[n] = y;
+    TRAJ_MASK( t, j )[n >> 3] |= (unsigned char) (1 << (n & 7));
+}
+
+
+/* traj_hide - Clears the mask bit of joint "j" in field "n" and zeroes
+ * its coordinates.
+ */
+void traj_hide( TRAJECT *t, int j, long n )
+{
+    TRAJ_X( t, j )[n] = 0.0;
+    TRAJ_Y( t, j )[n] = 0.0;
+    TRAJ_MASK( t, j )[n >> 3] &= (unsigned char) ~(1 << (n & 7));
+}
+
+
+/* traj_weights - Writes 1.0 for each visible and 0.0 for each hidden
+ * field of joint "j", for "count" fields starting at "first".
+ */
+void traj_weights( TRAJECT *t, int j, long first, long count, double *w )
+{
+    unsigned char *m;
+    long n;
+
+    m = TRAJ_MASK( t, j );
+    for( n = 0; n < count; n++ )
+       w[n] = (double) ((m[(first + n) >> 3] >> ((first + n) & 7)) & 1);
+}
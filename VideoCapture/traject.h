@@ -0,0 +1,75 @@
+/* TRAJECT.H
+ *
+ * Columnar trajectory store. A whole digitization session is held as
+ * one x column and one y column of doubles per joint, so that a pass
+ * over a joint walks contiguous memory instead of striding through an
+ * array of FRAME structures.
+ *
+ * Every column starts on a TRAJ_ALIGN byte boundary and holds
+ * "capacity" fields, a multiple of TRAJ_LANE, so kernels can run over
+ * full lanes without a scalar tail.  The store grows as fields are
+ * appended, up to TRAJ_MAXCAP fields.  Each column, and each joint's
+ * mask, is an allocation of its own, so under DOS a column may fill a
+ * 64K segment however many joints there are.
+ *
+ * Columns are reached with the TRAJ_X and TRAJ_Y macros:
+ *
+ *      double *x = TRAJ_X( t, joint );
+ *      for( n = 0; n < t->numframes; n++ )
+ *          x[n] *= t->cfactor;
+ *
+ * Whether a joint was seen in a field is kept in a validity bitmask,
+ * one bit per field for each joint (bit n & 7 of byte n >> 3 of the
+ * joint's mask).  Hidden points hold zero in the columns, so a kernel
+ * can run over a whole column and weight each result by its bit with
+ * no compares.  The digitizer's hidden point code (x = y = 999) only
+ * appears in files: traj_point() turns it into a cleared bit, and the
+ * writers put it back for fields whose bit is clear.
+ */
+
+/* Include only once */
+#ifndef TRAJECT_H
+#define TRAJECT_H
+
+#include <stdio.h>
+
+#define TRAJ_ALIGN  64          /* Byte alignment of every column       */
+#define TRAJ_LANE   8           /* Doubles per TRAJ_ALIGN bytes         */
+#define TRAJ_HIDDEN 999.0       /* Hidden point code in data files      */
+
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+#define TRAJ_MAXCAP ((0xFFFFL - TRAJ_ALIGN) / 8 / TRAJ_LANE * TRAJ_LANE)
+                                /* Fields a column can hold: one segment */
+#else
+#define TRAJ_MAXCAP ((0x7FFFFFFFL - TRAJ_ALIGN) / 8 / TRAJ_LANE * TRAJ_LANE)
+#endif
+
+typedef struct _TRAJECT
+{
+    int     numjoints;          /* Number of (x,y) column pairs         */
+    long    numframes;          /* Fields currently held                */
+    long    capacity;           /* Fields allocated in each column      */
+    int     skip;               /* Fields skipped between acquires      */
+    double  cfactor;            /* Conversion factor, pixels to meters  */
+    double **col;               /* 2 * numjoints aligned columns        */
+    void  **block;              /* Each column as returned by malloc    */
+    unsigned char **valid;      /* capacity / 8 mask bytes per joint    */
+} TRAJECT;
+
+#define TRAJ_X( t, j )  ((t)->col[2 * (j)])
+#define TRAJ_Y( t, j )  ((t)->col[2 * (j) + 1])
+#define TRAJ_MASK( t, j )   ((t)->valid[j])
+#define TRAJ_OK( t, j, n )  ((TRAJ_MASK( t, j )[(n) >> 3] >> ((n) & 7)) & 1)
+
+/* Public trajectory functions */
+TRAJECT *traj_create( int numjoints, long hint );
+void     traj_free( TRAJECT *t );
+void     traj_reserve( TRAJECT *t, long frames );
+long     traj_append( TRAJECT *t );
+long     traj_load( TRAJECT *t, FILE *fp, long maxframes );
+void     traj_point( TRAJECT *t, int j, long n, double x, double y );
+void     traj_hide( TRAJECT *t, int j, long n );
+void     traj_weights( TRAJECT *t, int j, long first, long count,
+                       double *w );
+
+#endif /* TRAJECT_H */
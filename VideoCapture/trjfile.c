@@ -0,0 +1,309 @@
+/**************************************************************************
+ *  TRJFILE.C
+ *
+ * Binary trajectory files. The following functions are public:
+ *
+ *   trj_create     -   Creates a .TRJ and writes its header and names
+ *   trj_append     -   Writes one field of a TRAJECT as the next record
+ *   trj_close      -   Writes the field index and closes the file
+ *   trj_map        -   Maps a .TRJ for reading and checks its header
+ *   trj_unmap      -   Releases a mapped .TRJ
+ *   trj_field      -   Tape field number of a record
+ *   trj_read       -   Appends records of a mapped .TRJ to a TRAJECT
+ *   trj_traject    -   Copies a mapped .TRJ into a TRAJECT
+ *
+ * The file layout is described in TRJFILE.H.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trjfile.h"
+
+/* Prototype for internal function */
+static int trj_head( TRJFILE *tf );
+
+
+/* trj_head - Rewrites the header in place and returns to the end of the
+ * file.
+ *
+ * Return: 0 on success, -1 on a write error
+ */
+static int trj_head( TRJFILE *tf )
+{
+    if( fseek( tf->fp, 0L, SEEK_SET ) != 0
+        || fwrite( &tf->head, sizeof(TRJHEAD), 1, tf->fp ) != 1
+        || fseek( tf->fp, 0L, SEEK_END ) != 0 )
+       return -1;
+    return 0;
+}
+
+
+/* trj_create - Creates "path" for a session of "numjoints" joints.  The
+ * names are taken "namestride" bytes apart starting at "names", so an
+ * array of fixed width name structures can be passed directly.
+ *
+ * Return: The writer, or NULL if the file cannot be created
+ */
+TRJFILE *trj_create( const char *path, int numjoints, const char *names,
+                     int namestride, double cfactor, int skip )
+{
+    TRJFILE *tf;
+    char name[TRJ_NAMELEN];
+    long pad;
+    int j;
+
+    tf = (TRJFILE *) calloc( 1, sizeof(TRJFILE) );
+    if( tf == NULL )
+      {
+        printf( "Error:  trj_create()  malloc failed.\n" );
+        exit( 1 );
+      }
+    if( (tf->fp = fopen( path, "wb" )) == NULL )
+      {
+        free( tf );
+        return NULL;
+      }
+    if( (tf->ixfp = tmpfile()) == NULL )    /* the index, until closed */
+      {
+        fclose( tf->fp );
+        remove( path );
+        free( tf );
+        return NULL;
+      }
+
+    memcpy( tf->head.magic, TRJ_MAGIC, sizeof(tf->head.magic) );
+    tf->head.version = TRJ_VERSION;
+    tf->head.headsize = TRJ_HEADSIZE;
+    tf->head.numjoints = numjoints;
+    tf->head.skip = skip;
+    tf->head.numframes = 0;
+    tf->head.recsize = (TRJ_I32) ((2 * numjoints * sizeof(float)
+                          + TRJ_RECALIGN - 1) / TRJ_RECALIGN * TRJ_RECALIGN);
+    tf->head.namesoff = TRJ_HEADSIZE;
+    tf->head.dataoff = (TRJ_I32) ((TRJ_HEADSIZE + numjoints * TRJ_NAMELEN
+                          + TRJ_DATAALIGN - 1) / TRJ_DATAALIGN * TRJ_DATAALIGN);
+    tf->head.indexoff = 0;
+    tf->head.cfactor = cfactor;
+
+    tf->rec = (float *) calloc( 1, (size_t) tf->head.recsize );
+    if( tf->rec == NULL )
+      {
+        printf( "Error:  trj_create()  malloc failed.\n" );
+        exit( 1 );
+      }
+
+    fwrite( &tf->head, sizeof(TRJHEAD), 1, tf->fp );
+    for( j = 0; j < numjoints; j++ )
+      {
+        memset( name, 0, TRJ_NAMELEN );
+        strncpy( name, names + (long) j * namestride, TRJ_NAMELEN - 1 );
+        fwrite( name, TRJ_NAMELEN, 1, tf->fp );
+      }
+    for( pad = tf->head.namesoff + (long) numjoints * TRJ_NAMELEN;
+         pad < tf->head.dataoff; pad++ )
+       fputc( 0, tf->fp );
+    if( fflush( tf->fp ) != 0 )
+      {
+        trj_close( tf );
+        return NULL;
+      }
+    return tf;
+}
+
+
+/* trj_append - Writes field "n" of "t" as the next record and notes its
+ * tape field number "field" for the index.  Hidden points are written
+ * as the hidden point code.
+ *
+ * Return: 0 on success, -1 on a write error
+ */
+int trj_append( TRJFILE *tf, TRAJECT *t, long n, long field )
+{
+    TRJ_I32 f;
+    int j;
+
+    for( j = 0; j < tf->head.numjoints; j++ )
+      {
+        if( TRAJ_OK( t, j, n ) )
+          {
+            tf->rec[2 * j] = (float) TRAJ_X( t, j )[n];
+            tf->rec[2 * j + 1] = (float) TRAJ_Y( t, j )[n];
+          }
+        else
+           tf->rec[2 * j] = tf->rec[2 * j + 1] = (float) TRAJ_HIDDEN;
+      }
+    if( fwrite( tf->rec, (size_t) tf->head.recsize, 1, tf->fp ) != 1 )
+       return -1;
+
+    f = (TRJ_I32) field;
+    if( fwrite( &f, sizeof(TRJ_I32), 1, tf->ixfp ) != 1 )
+       return -1;
+    tf->head.numframes++;
+    if( trj_head( tf ) != 0 )
+       return -1;
+    return fflush( tf->fp ) == 0 ? 0 : -1;
+}
+
+
+/* trj_close - Writes the field index after the last record, records its
+ * offset in the header and closes the file.
+ *
+ * Return: 0 on success, -1 on a write error
+ */
+int trj_close( TRJFILE *tf )
+{
+    long left;
+    size_t n;
+    int err = 0;
+
+    if( tf == NULL )
+       return 0;
+    if( tf->head.numframes > 0 )
+      {
+        tf->head.indexoff = (TRJ_I32) (tf->head.dataoff
+                            + (long) tf->head.numframes * tf->head.recsize);
+        if( fflush( tf->ixfp ) != 0 || fseek( tf->ixfp, 0L, SEEK_SET ) != 0
+            || fseek( tf->fp, (long) tf->head.indexoff, SEEK_SET ) != 0 )
+           err = -1;
+        left = (long) tf->head.numframes * (long) sizeof(TRJ_I32);
+        for( ; left > 0 && err == 0; left -= (long) n )
+          {                             /* the record is scratch now */
+            n = (size_t) ((left < tf->head.recsize) ? left
+                                                    : tf->head.recsize);
+            if( fread( tf->rec, 1, n, tf->ixfp ) != n
+                || fwrite( tf->rec, 1, n, tf->fp ) != n )
+               err = -1;
+          }
+        if( err == 0 && trj_head( tf ) != 0 )
+           err = -1;
+      }
+    if( fclose( tf->fp ) != 0 )
+       err = -1;
+    fclose( tf->ixfp );
+    free( tf->rec );
+    free( tf );
+    return err;
+}
+
+
+/* trj_map - Maps "path" and points the view at its header, names,
+ * records and index.  m->numframes counts only records that are wholly
+ * inside the file, in case the last write was cut short.
+ *
+ * Return: 0 on success, -1 if the file is missing or not a .TRJ
+ */
+int trj_map( TRJMAP *m, const char *path )
+{
+    TRJHEAD *h;
+    long avail;
+
+    memset( m, 0, sizeof(TRJMAP) );
+    if( fmap_open( &m->map, path ) != 0 )
+       return -1;
+    h = (TRJHEAD *) m->map.base;
+    if( m->map.size < TRJ_HEADSIZE
+        || memcmp( h->magic, TRJ_MAGIC, sizeof(h->magic) ) != 0
+        || h->version != TRJ_VERSION
+        || h->numjoints <= 0 || h->numjoints > m->map.size / TRJ_NAMELEN
+        || h->recsize < 2L * h->numjoints * (long) sizeof(float)
+        || h->namesoff < 0 || h->dataoff < 0
+        || h->namesoff + (long) h->numjoints * TRJ_NAMELEN > m->map.size
+        || h->dataoff > m->map.size )
+      {
+        fmap_close( &m->map );
+        return -1;
+      }
+    avail = (m->map.size - h->dataoff) / h->recsize;
+    m->head = h;
+    m->numframes = (h->numframes < avail) ? (long) h->numframes : avail;
+    m->names = (char *) (m->map.base + h->namesoff);
+    m->data = m->map.base + h->dataoff;
+    if( h->indexoff > 0
+        && h->indexoff + (long) h->numframes * (long) sizeof(TRJ_I32)
+           <= m->map.size )
+       m->index = (TRJ_IDX) (m->map.base + h->indexoff);
+    return 0;
+}
+
+
+/* trj_unmap - Releases the view.
+ */
+void trj_unmap( TRJMAP *m )
+{
+    fmap_close( &m->map );
+    memset( m, 0, sizeof(TRJMAP) );
+}
+
+
+/* trj_field - Returns the tape field number of record "n".
+ */
+long trj_field( TRJMAP *m, long n )
+{
+    if( m->index != NULL )
+       return (long) m->index[n];
+    return n * (m->head->skip + 1L);
+}
+
+
+/* trj_read - Appends records "first" .. "first" + "count" - 1 of a
+ * mapped file (fewer at the end of the file) to "t", which must have
+ * the file's joints.
+ *
+ * Return: The number of records appended, or -1 if "t" has a
+ *         different number of joints
+ */
+long trj_read( TRJMAP *m, TRAJECT *t, long first, long count )
+{
+    const float *rec;
+    unsigned char *cm;
+    double x, y, ok;
+    long k, n, n0;
+    int j, b;
+
+    if( t->numjoints != (int) m->head->numjoints )
+       return -1L;
+    if( first < 0 || first >= m->numframes || count <= 0 )
+       return 0L;
+    if( count > m->numframes - first )
+       count = m->numframes - first;
+
+    n0 = t->numframes;
+    traj_reserve( t, n0 + count );
+    for( k = 0; k < count; k++ )        /* a hidden point is stored as  */
+      {                                 /*   zero with its bit cleared  */
+        rec = TRJ_REC( m, first + k );
+        n = n0 + k;
+        b = (int) (n & 7);
+        for( j = 0; j < t->numjoints; j++ )
+          {
+            x = rec[2 * j];
+            y = rec[2 * j + 1];
+            ok = (double) !(x == TRAJ_HIDDEN && y == TRAJ_HIDDEN);
+            TRAJ_X( t, j )[n] = x * ok;
+            TRAJ_Y( t, j )[n] = y * ok;
+            cm = TRAJ_MASK( t, j ) + (n >> 3);
+            *cm = (unsigned char) ((*cm & ~(1 << b)) | ((int) ok << b));
+          }
+      }
+    t->numframes = n0 + count;
+    return count;
+}
+
+
+/* trj_traject - Copies every record of a mapped file into a new
+ * columnar store, carrying over the conversion factor and skip.
+ * Points holding the hidden point code are marked hidden.
+ *
+ * Return: The new store (pixel coordinates)
+ */
+TRAJECT *trj_traject( TRJMAP *m )
+{
+    TRAJECT *t;
+
+    t = traj_create( (int) m->head->numjoints, m->numframes );
+    t->cfactor = m->head->cfactor;
+    t->skip = (int) m->head->skip;
+    trj_read( m, t, 0L, m->numframes );
+    return t;
+}
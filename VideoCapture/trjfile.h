@@ -0,0 +1,101 @@
+/* TRJFILE.H
+ *
+ * Binary trajectory file (.TRJ), written alongside the .DAT and .FTN
+ * text files.  The file is laid out so that a reader can map it and
+ * use it in place, with no parsing:
+ *
+ *      offset 0          TRJHEAD   (TRJ_HEADSIZE bytes)
+ *      namesoff          numjoints joint names, TRJ_NAMELEN bytes each
+ *      dataoff           numframes records, recsize bytes each
+ *      indexoff          numframes tape field numbers (TRJ_I32)
+ *
+ * A record holds the pixel coordinates x0 y0 x1 y1 ... of one field as
+ * floats, padded to a multiple of TRJ_RECALIGN bytes.  Record n of a
+ * mapped file is at dataoff + n * recsize, so any field is reached in
+ * constant time.  Real world coordinates are pixel * cfactor.  A
+ * hidden point is stored as (TRAJ_HIDDEN, TRAJ_HIDDEN).
+ *
+ * The header is rewritten after every record, so a file cut short by a
+ * crash is still readable up to its last complete record.  The index
+ * is written when the file is closed; until then indexoff is zero and
+ * the field of record n is taken as n * (skip + 1).  The writer keeps
+ * the field numbers in a temporary file, not in memory, so a session
+ * may have more records than one segment could index.
+ *
+ * Numbers are stored in the byte order of the writing machine.
+ */
+
+/* Include only once */
+#ifndef TRJFILE_H
+#define TRJFILE_H
+
+#include <stdio.h>
+#include "filemap.h"
+#include "traject.h"
+
+#if defined(_MSC_VER) && (_MSC_VER <= 800)
+typedef long  TRJ_I32;          /* 16 bit compilers                     */
+typedef TRJ_I32 _huge *TRJ_IDX; /* An index reaching past 64K           */
+#else
+typedef int   TRJ_I32;
+typedef TRJ_I32 *TRJ_IDX;
+#endif
+
+#define TRJ_MAGIC     "PUMATRJ"
+#define TRJ_VERSION   1
+#define TRJ_HEADSIZE  64
+#define TRJ_NAMELEN   16
+#define TRJ_RECALIGN  16
+#define TRJ_DATAALIGN 64
+
+typedef struct _TRJHEAD
+{
+    char    magic[8];           /* TRJ_MAGIC                            */
+    TRJ_I32 version;            /* TRJ_VERSION                          */
+    TRJ_I32 headsize;           /* TRJ_HEADSIZE                         */
+    TRJ_I32 numjoints;          /* Joints per record                    */
+    TRJ_I32 skip;               /* Fields skipped between acquires      */
+    TRJ_I32 numframes;          /* Complete records in the file         */
+    TRJ_I32 recsize;            /* Bytes per record                     */
+    TRJ_I32 namesoff;           /* Offset of the joint name table       */
+    TRJ_I32 dataoff;            /* Offset of record 0                   */
+    TRJ_I32 indexoff;           /* Offset of the field index, 0 if none */
+    TRJ_I32 reserved[3];
+    double  cfactor;            /* Conversion factor, pixels to meters  */
+} TRJHEAD;
+
+/* Writer state for a .TRJ being appended to */
+typedef struct _TRJFILE
+{
+    FILE    *fp;
+    TRJHEAD  head;
+    float   *rec;               /* One record of scratch                */
+    FILE    *ixfp;              /* Field numbers of records written     */
+} TRJFILE;
+
+/* Reader view of a mapped .TRJ */
+typedef struct _TRJMAP
+{
+    FILEMAP  map;
+    TRJHEAD *head;
+    long     numframes;         /* Complete records present             */
+    char    *names;
+    FMAPPTR  data;              /* Record 0, with the records after it  */
+    TRJ_IDX  index;             /* NULL if the file was never closed    */
+} TRJMAP;
+
+#define TRJ_REC( m, n )   ((float *) ((m)->data + (long) (n) * (m)->head->recsize))
+#define TRJ_NAME( m, j )  ((m)->names + (j) * TRJ_NAMELEN)
+
+/* Public .TRJ functions */
+TRJFILE *trj_create( const char *path, int numjoints, const char *names,
+                     int namestride, double cfactor, int skip );
+int      trj_append( TRJFILE *tf, TRAJECT *t, long n, long field );
+int      trj_close( TRJFILE *tf );
+int      trj_map( TRJMAP *m, const char *path );
+void     trj_unmap( TRJMAP *m );
+long     trj_field( TRJMAP *m, long n );
+long     trj_read( TRJMAP *m, TRAJECT *t, long first, long count );
+TRAJECT *trj_traject( TRJMAP *m );
+
+#endif /* TRJFILE_H */
@@ -0,0 +1,236 @@
+/**************************************************************************
+ *  TXTBENCH.C
+ *
+ * Times the buffered scanner (txtscan.c) against fscanf( "%lf" ) on
+ * one text file and checks that both read the same numbers, bit for
+ * bit.  Every token of the file is read as a number until the first
+ * that is not one, so point it at a .DAT without its count line, or
+ * let it write a file of its own:
+ *
+ *      txtbench file [passes]          time reading "file"
+ *      txtbench -w file n [passes]     write n numbers to "file" first
+ *
+ * The numbers written look like the digitizer's (%06.3f, 4 pairs to a
+ * line) with a few longer ones and exponents among them, so the slow
+ * strtod() path is timed too.  Compile with:
+ *
+ *      cl /AL txtbench.c txtscan.c traject.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "txtscan.h"
+
+#define TB_BLOCK      2048      /* Numbers read at a time               */
+
+/* Prototypes for internal functions */
+static void   tb_write( const char *path, long n );
+static long   tb_fscanf( const char *path, double *v );
+static long   tb_txtscan( const char *path, double *v );
+static long   tb_compare( const char *path, double *a, double *b );
+static double tb_seconds( clock_t start );
+
+
+/* tb_write - Writes "n" numbers to "path", 8 to a line.
+ */
+static void tb_write( const char *path, long n )
+{
+    FILE *fp;
+    long i;
+    double x;
+
+    if( (fp = fopen( path, "w" )) == NULL )
+      {
+        printf( "Error:  cannot create %s\n", path );
+        exit( 1 );
+      }
+    srand( 1994 );
+    for( i = 0; i < n; i++ )
+      {
+        x = (rand() % 512000) / 1000.0 - ((i % 16 == 15) ? 256.0 : 0.0);
+        if( i % 97 == 0 )
+           fprintf( fp, "%.17g", x / 3.0 );         /* 17 digits */
+        else if( i % 101 == 0 )
+           fprintf( fp, "%e", x * 1e-30 );          /* big exponent */
+        else
+           fprintf( fp, "%06.3f", x );
+        fprintf( fp, (i % 8 == 7) ? "\n" : ((i % 2) ? "   " : " ") );
+      }
+    fprintf( fp, "\n" );
+    if( fclose( fp ) != 0 )
+      {
+        printf( "Error:  cannot write %s\n", path );
+        exit( 1 );
+      }
+}
+
+
+/* tb_fscanf - Reads every number of "path" with fscanf(), a block at a
+ * time into "v".
+ *
+ * Return: The count read
+ */
+static long tb_fscanf( const char *path, double *v )
+{
+    FILE *fp;
+    long count = 0;
+    int i;
+
+    if( (fp = fopen( path, "r" )) == NULL )
+       return 0L;
+    for( i = 0; fscanf( fp, "%lf", &v[i] ) == 1; count++ )
+       if( ++i == TB_BLOCK )
+          i = 0;
+    fclose( fp );
+    return count;
+}
+
+
+/* tb_txtscan - Reads every number of "path" with txt_doubles(), a block
+ * at a time into "v".
+ *
+ * Return: The count read
+ */
+static long tb_txtscan( const char *path, double *v )
+{
+    FILE *fp;
+    TXTSCAN *ts;
+    long n, count = 0;
+
+    if( (fp = fopen( path, "r" )) == NULL )
+       return 0L;
+    ts = txt_open( fp );
+    while( (n = txt_doubles( ts, v, (long) TB_BLOCK )) > 0 )
+       count += n;
+    txt_close( ts );
+    fclose( fp );
+    return count;
+}
+
+
+/* tb_compare - Reads "path" both ways at once, a block at a time.
+ *
+ * Return: The index of the first number that differs, or -1 if all
+ *         are the same and both ways read as many
+ */
+static long tb_compare( const char *path, double *a, double *b )
+{
+    FILE *fa, *fb;
+    TXTSCAN *ts;
+    long na, nb, i, count = 0, bad = -1L;
+
+    if( (fa = fopen( path, "r" )) == NULL
+        || (fb = fopen( path, "r" )) == NULL )
+      {
+        printf( "Error:  cannot open %s\n", path );
+        exit( 1 );
+      }
+    ts = txt_open( fb );
+    do
+      {
+        for( na = 0; na < TB_BLOCK && fscanf( fa, "%lf", &a[na] ) == 1; na++ )
+           ;
+        nb = txt_doubles( ts, b, (long) TB_BLOCK );
+        for( i = 0; i < na && i < nb; i++ )
+           if( memcmp( &a[i], &b[i], sizeof(double) ) != 0 )
+              break;
+        if( i < na || i < nb )
+          {
+            bad = count + i;
+            if( i < na && i < nb )
+               printf( "Number %ld: fscanf %.17g, txt_doubles %.17g\n",
+                       bad, a[i], b[i] );
+            else
+               printf( "Number %ld: read by only one of them\n", bad );
+            break;
+          }
+        count += na;
+      }
+    while( na == TB_BLOCK );
+    txt_close( ts );
+    fclose( fa );
+    fclose( fb );
+    return bad;
+}
+
+
+/* tb_seconds - Processor time since "start".
+ */
+static double tb_seconds( clock_t start )
+{
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    double *a, *b, tf, tt;
+    char *path;
+    long n, nf, nt;
+    int passes, k;
+    clock_t start;
+
+    if( argc >= 4 && strcmp( argv[1], "-w" ) == 0 )
+      {
+        path = argv[2];
+        tb_write( path, atol( argv[3] ) );
+        passes = (argc >= 5) ? atoi( argv[4] ) : 1;
+      }
+    else if( argc >= 2 && argv[1][0] != '-' )
+      {
+        path = argv[1];
+        passes = (argc >= 3) ? atoi( argv[2] ) : 1;
+      }
+    else
+      {
+        printf( "Usage:  txtbench file [passes]\n" );
+        printf( "        txtbench -w file n [passes]\n" );
+        exit( 1 );
+      }
+    if( passes < 1 )
+       passes = 1;
+
+    a = (double *) malloc( TB_BLOCK * sizeof(double) );
+    b = (double *) malloc( TB_BLOCK * sizeof(double) );
+    if( a == NULL || b == NULL )
+      {
+        printf( "Error:  txtbench  malloc failed.\n" );
+        exit( 1 );
+      }
+
+    if( (n = tb_compare( path, a, b )) >= 0 )
+      {
+        printf( "%s: the two ways differ\n", path );
+        exit( 1 );
+      }
+
+    nf = nt = 0L;
+    tf = tt = 0.0;
+    for( k = 0; k < passes; k++ )       /* alternate, so the disk cache */
+      {                                 /*   favours neither            */
+        start = clock();
+        nf = tb_fscanf( path, a );
+        tf += tb_seconds( start );
+        start = clock();
+        nt = tb_txtscan( path, b );
+        tt += tb_seconds( start );
+      }
+    if( nf != nt )
+      {
+        printf( "%s: fscanf read %ld numbers, txt_doubles %ld\n",
+                path, nf, nt );
+        exit( 1 );
+      }
+
+    printf( "%s: %ld numbers, identical, %d pass(es)\n", path, nf, passes );
+    printf( "  fscanf       %8.3f s\n", tf / passes );
+    printf( "  txt_doubles  %8.3f s", tt / passes );
+    if( tt > 0.0 )
+       printf( "   (%.2f times as fast)", tf / tt );
+    printf( "\n" );
+    free( a );
+    free( b );
+    return 0;
+}
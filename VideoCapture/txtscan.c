@@ -0,0 +1,332 @@
+/**************************************************************************
+ *  TXTSCAN.C
+ *
+ * Buffered text file scanning. The following functions are public:
+ *
+ *   txt_open       -   Starts scanning an open text stream
+ *   txt_close      -   Releases the scanner (the stream stays open)
+ *   txt_skip       -   Skips over tokens
+ *   txt_word       -   Copies the next token
+ *   txt_long       -   Reads an integer
+ *   txt_double     -   Reads a floating point number
+ *   txt_doubles    -   Reads a run of floating point numbers
+ *   txt_traject    -   Reads .DAT / .DTA / .FTN records into a TRAJECT
+ *   txt_force      -   Reads one BEDAS force plate sample
+ *
+ * The layouts are described in TXTSCAN.H.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "txtscan.h"
+
+#define TXT_SPACE( c )  ((c) == ' ' || (c) == '\n' || (c) == '\r' \
+                         || (c) == '\t' || (c) == '\f' || (c) == '\v')
+#define TXT_DIGIT( c )  ((c) >= '0' && (c) <= '9')
+
+/* Exact powers of ten a double can hold */
+static const double txt_pow10[] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+    1e22
+};
+
+/* Prototypes for internal functions */
+static void txt_fill( TXTSCAN *ts );
+static int  txt_token( TXTSCAN *ts );
+
+
+/* txt_fill - Moves the unread bytes to the front of the buffer and
+ * tops it up from the file.
+ */
+static void txt_fill( TXTSCAN *ts )
+{
+    long n;
+
+    n = ts->len - ts->pos;
+    if( n > 0 && ts->pos > 0 )
+       memmove( ts->buf, ts->buf + ts->pos, (size_t) n );
+    ts->pos = 0;
+    ts->len = n;
+    if( !ts->eof )
+      {
+        n = (long) fread( ts->buf + ts->len, 1,
+                          (size_t) (TXT_BUFSIZE - ts->len), ts->fp );
+        if( n <= 0 )
+           ts->eof = 1;
+        else
+           ts->len += n;
+      }
+    ts->buf[ts->len] = '\0';
+}
+
+
+/* txt_token - Skips blanks and makes sure the next token, up to
+ * TXT_TOKMAX characters of it, is in the buffer and followed by a
+ * non-digit (at worst the NUL after the data).
+ *
+ * Return: TRUE if there is a token, FALSE at the end of the file
+ */
+static int txt_token( TXTSCAN *ts )
+{
+    for( ;; )
+      {
+        while( ts->pos < ts->len && TXT_SPACE( ts->buf[ts->pos] ) )
+           ts->pos++;
+        if( ts->pos < ts->len )
+          {
+            while( ts->len - ts->pos < TXT_TOKMAX && !ts->eof )
+               txt_fill( ts );
+            return 1;
+          }
+        if( ts->eof )
+           return 0;
+        txt_fill( ts );
+      }
+}
+
+
+/* txt_open - Wraps the open stream "fp" in a scanner.  Nothing should be
+ * read from "fp" directly while the scanner is in use.
+ *
+ * Return: The scanner
+ */
+TXTSCAN *txt_open( FILE *fp )
+{
+    TXTSCAN *ts;
+
+    ts = (TXTSCAN *) malloc( sizeof(TXTSCAN) );
+    if( ts == NULL || (ts->buf = (char *) malloc( TXT_BUFSIZE + 1 )) == NULL )
+      {
+        printf( "Error:  txt_open()  malloc failed.\n" );
+        exit( 1 );
+      }
+    ts->fp = fp;
+    ts->pos = ts->len = 0;
+    ts->eof = (fp == NULL);
+    ts->buf[0] = '\0';
+    return ts;
+}
+
+
+/* txt_close - Frees the scanner.  The stream is left for the caller
+ * to close.
+ */
+void txt_close( TXTSCAN *ts )
+{
+    if( ts == NULL )
+       return;
+    free( ts->buf );
+    free( ts );
+}
+
+
+/* txt_skip - Passes over the next "ntokens" tokens, whatever they hold.
+ *
+ * Return: The number of tokens skipped (short only at end of file)
+ */
+int txt_skip( TXTSCAN *ts, long ntokens )
+{
+    long i;
+
+    for( i = 0; i < ntokens; i++ )
+      {
+        if( !txt_token( ts ) )
+           break;
+        for( ;; )
+          {
+            while( ts->pos < ts->len && !TXT_SPACE( ts->buf[ts->pos] ) )
+               ts->pos++;
+            if( ts->pos < ts->len || ts->eof )
+               break;
+            txt_fill( ts );
+          }
+      }
+    return (int) i;
+}
+
+
+/* txt_word - Copies the next token into "word", cut to "size" - 1
+ * characters, like fscanf( "%s" ).
+ *
+ * Return: 1 on success, 0 at end of file
+ */
+int txt_word( TXTSCAN *ts, char *word, int size )
+{
+    int n = 0;
+
+    if( !txt_token( ts ) )
+       return 0;
+    for( ;; )
+      {
+        while( ts->pos < ts->len && !TXT_SPACE( ts->buf[ts->pos] ) )
+          {
+            if( n < size - 1 )
+               word[n++] = ts->buf[ts->pos];
+            ts->pos++;
+          }
+        if( ts->pos < ts->len || ts->eof )
+           break;
+        txt_fill( ts );
+      }
+    word[n] = '\0';
+    return 1;
+}
+
+
+/* txt_long - Reads a decimal integer.  As with fscanf( "%ld" ) a token
+ * that does not start with a number is left unread.
+ *
+ * Return: 1 on success, 0 at end of file or if no number is there
+ */
+int txt_long( TXTSCAN *ts, long *v )
+{
+    char *p;
+    long n = 0;
+    int neg = 0;
+
+    if( !txt_token( ts ) )
+       return 0;
+    p = ts->buf + ts->pos;
+    if( *p == '-' || *p == '+' )
+       neg = (*p++ == '-');
+    if( !TXT_DIGIT( *p ) )
+       return 0;
+    while( TXT_DIGIT( *p ) )
+       n = n * 10 + (*p++ - '0');
+    ts->pos = (long) (p - ts->buf);
+    *v = neg ? -n : n;
+    return 1;
+}
+
+
+/* txt_double - Reads a floating point number.  Mantissas of up to 15
+ * significant digits scaled by up to 1e22 are exact in a double, so one
+ * multiply or divide rounds them correctly; anything else goes through
+ * strtod().  A token that is not a number is left unread.
+ *
+ * Return: 1 on success, 0 at end of file or if no number is there
+ */
+int txt_double( TXTSCAN *ts, double *v )
+{
+    char *p, *q;
+    double m = 0.0;
+    int neg = 0, any = 0, sig = 0, exp10 = 0, e = 0, eneg = 0;
+
+    if( !txt_token( ts ) )
+       return 0;
+    p = q = ts->buf + ts->pos;
+    if( *q == '-' || *q == '+' )
+       neg = (*q++ == '-');
+    for( ; TXT_DIGIT( *q ); q++, any = 1 )
+      {
+        if( sig > 0 || *q != '0' )
+           sig++;
+        m = m * 10.0 + (*q - '0');
+      }
+    if( *q == '.' )
+       for( q++; TXT_DIGIT( *q ); q++, any = 1, exp10-- )
+         {
+           if( sig > 0 || *q != '0' )
+              sig++;
+           m = m * 10.0 + (*q - '0');
+         }
+    if( any && (*q == 'e' || *q == 'E')
+        && (TXT_DIGIT( q[1] )
+            || ((q[1] == '-' || q[1] == '+') && TXT_DIGIT( q[2] ))) )
+      {
+        q++;
+        if( *q == '-' || *q == '+' )
+           eneg = (*q++ == '-');
+        for( ; TXT_DIGIT( *q ); q++ )
+           if( e < 10000 )
+              e = e * 10 + (*q - '0');
+        exp10 += eneg ? -e : e;
+      }
+
+    if( any && sig <= 15 && exp10 >= -22 && exp10 <= 22 )
+      {
+        if( exp10 < 0 )
+           m /= txt_pow10[-exp10];
+        else
+           m *= txt_pow10[exp10];
+        *v = neg ? -m : m;
+      }
+    else
+      {
+        m = strtod( p, &q );       /* long mantissas, big exponents, INF */
+        if( q == p )
+           return 0;
+        *v = m;
+      }
+    ts->pos = (long) (q - ts->buf);
+    return 1;
+}
+
+
+/* txt_doubles - Reads up to "n" numbers into "v".
+ *
+ * Return: The number read
+ */
+long txt_doubles( TXTSCAN *ts, double *v, long n )
+{
+    long i;
+
+    for( i = 0; i < n; i++ )
+       if( !txt_double( ts, &v[i] ) )
+          break;
+    return i;
+}
+
+
+/* txt_traject - Appends up to "maxframes" records of t->numjoints x y
+ * pairs to "t" (no limit if "maxframes" is negative).  With "layout"
+ * TXT_FTN each record is preceded by its field count, which is
+ * skipped.  The header must already have been read.
+ *
+ * Return: The number of complete records read; a partial record at the
+ *         end of the file is dropped
+ */
+long txt_traject( TXTSCAN *ts, TRAJECT *t, long maxframes, int layout )
+{
+    long n, count = 0;
+    double x, y;
+    int j;
+
+    while( maxframes < 0 || count < maxframes )
+      {
+        if( layout == TXT_FTN && txt_skip( ts, 1L ) != 1 )
+           break;
+        n = traj_append( t );
+        for( j = 0; j < t->numjoints; j++ )
+          {
+            if( !txt_double( ts, &x ) || !txt_double( ts, &y ) )
+              {
+                t->numframes--;       /* drop the partial record */
+                return count;
+              }
+            traj_point( t, j, n, x, y );
+          }
+        count++;
+      }
+    return count;
+}
+
+
+/* txt_force - Skips "skip" values and reads the TXT_BEDASCHAN channels
+ * of the next force plate sample into "rec".
+ *
+ * Return: 1 on success, 0 if the file ended first
+ */
+int txt_force( TXTSCAN *ts, double *rec, int skip )
+{
+    double temp;
+    int i;
+
+    for( i = 0; i < skip; i++ )
+       if( !txt_double( ts, &temp ) )
+          return 0;
+    return txt_doubles( ts, rec, (long) TXT_BEDASCHAN ) == TXT_BEDASCHAN;
+}
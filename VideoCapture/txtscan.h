@@ -0,0 +1,57 @@
+/* TXTSCAN.H
+ *
+ * Buffered tokenizer and number parser for the text files the lab
+ * keeps in its archive:
+ *
+ *      .DAT   numjoints, then one record of x y pairs per field
+ *      .DTA   name, records, fin number, then records of 6 x y pairs
+ *      .FTN   name, NX, cfactor, film speed, then per field the field
+ *             count followed by x y pairs, 4 pairs to a line
+ *      BEDAS  TXT_BEDASHEAD header tokens, then force plate samples of
+ *             TXT_BEDASCHAN channels each
+ *
+ * Tokens are runs of non-blank characters, so line layout (4 pairs to
+ * a line, blank lines, trailing spaces) does not matter.  The file is
+ * read TXT_BUFSIZE bytes at a time and numbers are converted straight
+ * out of the buffer; only numbers with more than 15 significant digits
+ * or an exponent beyond 1e22 are handed to strtod(), so every value
+ * comes out exactly as fscanf( "%lf" ) would give it.
+ */
+
+/* Include only once */
+#ifndef TXTSCAN_H
+#define TXTSCAN_H
+
+#include <stdio.h>
+#include "traject.h"
+
+#define TXT_BUFSIZE    16384    /* Bytes read from the file at a time   */
+#define TXT_TOKMAX     64       /* Longest token converted as a number  */
+
+#define TXT_DAT        0        /* Records are x y pairs only           */
+#define TXT_FTN        1        /* Each record starts with its count    */
+
+#define TXT_BEDASHEAD  74       /* Header tokens in a BEDAS force file  */
+#define TXT_BEDASCHAN  6        /* fx fy fz mx my mz                    */
+
+typedef struct _TXTSCAN
+{
+    FILE   *fp;
+    char   *buf;                /* TXT_BUFSIZE bytes plus a NUL         */
+    long    pos;                /* Next unread byte                     */
+    long    len;                /* Bytes in the buffer                  */
+    int     eof;                /* TRUE once the file is exhausted      */
+} TXTSCAN;
+
+/* Public scanner functions */
+TXTSCAN *txt_open( FILE *fp );
+void     txt_close( TXTSCAN *ts );
+int      txt_skip( TXTSCAN *ts, long ntokens );
+int      txt_word( TXTSCAN *ts, char *word, int size );
+int      txt_long( TXTSCAN *ts, long *v );
+int      txt_double( TXTSCAN *ts, double *v );
+long     txt_doubles( TXTSCAN *ts, double *v, long n );
+long     txt_traject( TXTSCAN *ts, TRAJECT *t, long maxframes, int layout );
+int      txt_force( TXTSCAN *ts, double *rec, int skip );
+
+#endif /* TXTSCAN_H */
@@ -0,0 +1,115 @@
+/**************************************************************************
+ *  WORKER.C
+ *
+ * Task pool. The following functions are public:
+ *
+ *   work_threads   -   Resolves a requested thread count
+ *   work_run       -   Runs tasks 0 .. count-1 and waits for them all
+ *
+ * Compile with PUMA_THREADS defined (and link -lpthread) for threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "worker.h"
+
+#ifdef PUMA_THREADS
+#include <pthread.h>
+#include <unistd.h>
+
+/* Shared state of one work_run() call */
+typedef struct _WORKPOOL
+{
+    pthread_mutex_t lock;
+    long    next;               /* Next task to hand out                */
+    long    count;
+    WORKFN  fn;
+    void   *arg;
+} WORKPOOL;
+
+/* Prototype for internal function */
+static void *work_loop( void *p );
+
+
+/* work_loop - Takes tasks from the pool until there are none left.
+ */
+static void *work_loop( void *p )
+{
+    WORKPOOL *pool = (WORKPOOL *) p;
+    long i;
+
+    for( ;; )
+      {
+        pthread_mutex_lock( &pool->lock );
+        i = pool->next++;
+        pthread_mutex_unlock( &pool->lock );
+        if( i >= pool->count )
+           break;
+        pool->fn( pool->arg, i );
+      }
+    return NULL;
+}
+#endif
+
+
+/* work_threads - Turns a requested thread count into the number that
+ * will be used: "nthreads" if positive, otherwise one per processor.
+ *
+ * Return: The thread count, 1 without PUMA_THREADS
+ */
+int work_threads( int nthreads )
+{
+#ifdef PUMA_THREADS
+    long n;
+
+    if( nthreads <= 0 )
+      {
+        n = sysconf( _SC_NPROCESSORS_ONLN );
+        nthreads = (n > 0) ? (int) n : 1;
+      }
+    return (nthreads > WORK_MAXTHREADS) ? WORK_MAXTHREADS : nthreads;
+#else
+    return 1;
+#endif
+}
+
+
+/* work_run - Calls fn( arg, i ) for every i from 0 to count - 1 using
+ * up to "nthreads" threads (0 = one per processor), the caller's
+ * among them, and returns when all the tasks are done.  Tasks may run
+ * in any order and at the same time, so they must not share scratch.
+ */
+void work_run( long count, WORKFN fn, void *arg, int nthreads )
+{
+#ifdef PUMA_THREADS
+    WORKPOOL pool;
+    pthread_t tid[WORK_MAXTHREADS];
+    int i, started = 0;
+
+    nthreads = work_threads( nthreads );
+    if( (long) nthreads > count )
+       nthreads = (int) count;
+    if( nthreads > 1 )
+      {
+        pthread_mutex_init( &pool.lock, NULL );
+        pool.next = 0;
+        pool.count = count;
+        pool.fn = fn;
+        pool.arg = arg;
+        for( i = 1; i < nthreads; i++ )
+           if( pthread_create( &tid[started], NULL, work_loop, &pool ) == 0 )
+              started++;
+        work_loop( &pool );
+        for( i = 0; i < started; i++ )
+           pthread_join( tid[i], NULL );
+        pthread_mutex_destroy( &pool.lock );
+        return;
+      }
+#endif
+    {
+        long n;
+
+        for( n = 0; n < count; n++ )
+           fn( arg, n );
+    }
+}
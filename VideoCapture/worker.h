@@ -0,0 +1,26 @@
+/* WORKER.H
+ *
+ * Runs a batch of independent tasks (one per joint, per cutoff, per
+ * trial ...) over a pool of threads.  Threads take the next task
+ * number from a shared counter as they finish, so uneven tasks still
+ * keep every thread busy.
+ *
+ * Threads are used when the program is compiled with PUMA_THREADS
+ * defined (POSIX threads).  Otherwise, as under DOS, the tasks run one
+ * after another in the calling thread and the thread count is ignored.
+ */
+
+/* Include only once */
+#ifndef WORKER_H
+#define WORKER_H
+
+#define WORK_MAXTHREADS  64     /* Upper limit on pool size             */
+
+/* A task: "arg" is shared by all tasks, "i" is the task number */
+typedef void (*WORKFN)( void *arg, long i );
+
+/* Public worker functions */
+int  work_threads( int nthreads );
+void work_run( long count, WORKFN fn, void *arg, int nthreads );
+
+#endif /* WORKER_H */